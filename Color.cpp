@@ -1,34 +1,42 @@
 #include "Color.h"
+#include "ColorConstexpr.h"
+#include "ColorGraph.h"
+#include "ColorPlan.h"
+#include "ColorSpace.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 namespace COLORNS
 {
 
-	double GetLuminance(const double r, const double g, const double b)
+	template <typename T>
+	T GetLuminance(const T r, const T g, const T b)
 	{
 		// BT.601 (NTSC 1953)
-		constexpr double  Pr = .299;
-		constexpr double  Pg = .587;
-		constexpr double  Pb = .114;
+		constexpr T  Pr = T(.299);
+		constexpr T  Pg = T(.587);
+		constexpr T  Pb = T(.114);
 
 		// should use these parameters
 		// why? see https://habr.com/ru/post/304210/ (rus)
 		// BT.709 (Rec.709)
-/*		constexpr double  Pr = .2126;
-		constexpr double  Pg = .7152;
-		constexpr double  Pb = .0722;*/
+/*		constexpr T  Pr = T(.2126);
+		constexpr T  Pg = T(.7152);
+		constexpr T  Pb = T(.0722);*/
 
-		return sqrt(r * r * Pr + g * g * Pg + b * b * Pb);
+		return std::sqrt(r * r * Pr + g * g * Pg + b * b * Pb);
 	}
 
-	void GetHSPVL(const double r, const double g, const double b,
-		double& h, double& s, double& p, double& v, double& l)
+	template <typename T>
+	void GetHSPVL(const T r, const T g, const T b,
+		T& h, T& s, T& p, T& v, T& l)
 	{
-		double max = std::max(std::max(r, g), b);
-		double min = std::min(std::min(r, g), b);
-		double d = max - min;
+		T max = std::max(std::max(r, g), b);
+		T min = std::min(std::min(r, g), b);
+		T d = max - min;
 		h = 0;
 		s = max == 0 ? 0 : (d / max);
 		p = GetLuminance(r, g, b);
@@ -44,22 +52,23 @@ namespace COLORNS
 		}
 	}
 
-	void GetRGBfromHSV(const double h, const double s, const double v,
-		double& r, double& g, double& b)
+	template <typename T>
+	void GetRGBfromHSV(const T h, const T s, const T v,
+		T& r, T& g, T& b)
 	{
 		r = 0;
 		g = 0;
 		b = 0;
-		double H = static_cast<double>(static_cast<int>(h) % 360) / 360;
-		double S = s;
-		double V = v;
+		T H = static_cast<T>(static_cast<int>(h) % 360) / 360;
+		T S = s;
+		T V = v;
 		if (S)
 		{
 			H *= 6;
-			int vi = static_cast<int>(floor(H));
-			double v1 = V * (1 - S);
-			double v2 = V * (1 - S * (H - vi));
-			double v3 = V * (1 - S * (1 - (H - vi)));
+			int vi = static_cast<int>(std::floor(H));
+			T v1 = V * (1 - S);
+			T v2 = V * (1 - S * (H - vi));
+			T v3 = V * (1 - S * (1 - (H - vi)));
 			switch (vi)
 			{
 			case 0:
@@ -114,423 +123,31 @@ namespace COLORNS
 
 	//////////////////////////////////////////////////////////////////////////////////////////////////
 	// brucelindblum.com CIE Color Calculator C++ porting
-	typedef struct _XYZ
-	{
-		double X{ 0.0 };
-		double Y{ 0.0 };
-		double Z{ 0.0 };
-	} XYZ;
-
-	enum class AdaptationEnum
-	{
-		amBradford = 0,
-		amVonKries = 1,
-//		amXYZScaling = 2,
-		amNone = 2
-	};
-
-	enum class RgbEnum
-	{
-		AdobeRgb = 0,
-		AppleRgb = 1,
-		BestRgb = 2,
-		BetaRgb = 3,
-		BruceRgb = 4,
-		CieRgb = 5,
-		ColorMatchRgb = 6,
-		DonRgb4 = 7,
-		EciRgb2 = 8,
-		EktaSpacePS5 = 9,
-		NtscRgb = 10,
-		PalSecamRgb = 11,
-		ProPhotoRgb = 12,
-		SmpteCRgb = 13,
-		sRGB = 14,
-		WideGamutRgb = 15
+	// all working spaces, evaluated at compile time
+	constexpr RgbModel kRgbModels[kRgbModelCount] = {
+		MakeRGBModel(RgbEnum::AdobeRgb),
+		MakeRGBModel(RgbEnum::AppleRgb),
+		MakeRGBModel(RgbEnum::BestRgb),
+		MakeRGBModel(RgbEnum::BetaRgb),
+		MakeRGBModel(RgbEnum::BruceRgb),
+		MakeRGBModel(RgbEnum::CieRgb),
+		MakeRGBModel(RgbEnum::ColorMatchRgb),
+		MakeRGBModel(RgbEnum::DonRgb4),
+		MakeRGBModel(RgbEnum::EciRgb2),
+		MakeRGBModel(RgbEnum::EktaSpacePS5),
+		MakeRGBModel(RgbEnum::NtscRgb),
+		MakeRGBModel(RgbEnum::PalSecamRgb),
+		MakeRGBModel(RgbEnum::ProPhotoRgb),
+		MakeRGBModel(RgbEnum::SmpteCRgb),
+		MakeRGBModel(RgbEnum::sRGB),
+		MakeRGBModel(RgbEnum::WideGamutRgb)
 	};
 
-	enum class IlluminantEnum
-	{
-		A = 0,
-		B = 1,
-		C = 2,
-		D50 = 3,
-		D55 = 4,
-		D65 = 5,
-		D75 = 6,
-		E = 7,
-		F2 = 8,
-		F7 = 9,
-		F11 = 10
-	};
-
-	typedef struct _Mtx3x3
-	{
-		double m[3][3];
-	} Mtx3x3;
-
-	typedef struct _RgbModel
-	{
-		XYZ RefWhiteRGB;
-		double GammaRGB;
-		Mtx3x3 MtxRGB2XYZ;
-		Mtx3x3 MtxXYZ2RGB;
-	} RgbModel;
-
-	XYZ GetRefWhite(IlluminantEnum i = IlluminantEnum::D50)
-	{
-		XYZ RefWhite;
-		RefWhite.Y = 1.0;
-		switch (i)
-		{
-		case IlluminantEnum::A:	// A (ASTM E308-01)
-			RefWhite.X = 1.09850;
-			RefWhite.Z = 0.35585;
-			break;
-		case IlluminantEnum::B:	// B (Wyszecki & Stiles, p. 769)
-			RefWhite.X = 0.99072;
-			RefWhite.Z = 0.85223;
-			break;
-		case IlluminantEnum::C:	// C (ASTM E308-01)
-			RefWhite.X = 0.98074;
-			RefWhite.Z = 1.18232;
-			break;
-		case IlluminantEnum::D50:	// D50 (ASTM E308-01)
-			RefWhite.X = 0.96422;
-			RefWhite.Z = 0.82521;
-			break;
-		case IlluminantEnum::D55:	// D55 (ASTM E308-01)
-			RefWhite.X = 0.95682;
-			RefWhite.Z = 0.92149;
-			break;
-		case IlluminantEnum::D65:	// D65 (ASTM E308-01)
-			RefWhite.X = 0.95047;
-			RefWhite.Z = 1.08883;
-			break;
-		case IlluminantEnum::D75:	// D75 (ASTM E308-01)
-			RefWhite.X = 0.94972;
-			RefWhite.Z = 1.22638;
-			break;
-		default:
-		case IlluminantEnum::E:	// E (ASTM E308-01)
-			RefWhite.X = 1.00000;
-			RefWhite.Z = 1.00000;
-			break;
-		case IlluminantEnum::F2:	// F2 (ASTM E308-01)
-			RefWhite.X = 0.99186;
-			RefWhite.Z = 0.67393;
-			break;
-		case IlluminantEnum::F7:	// F7 (ASTM E308-01)
-			RefWhite.X = 0.95041;
-			RefWhite.Z = 1.08747;
-			break;
-		case IlluminantEnum::F11:	// F11 (ASTM E308-01)
-			RefWhite.X = 1.00962;
-			RefWhite.Z = 0.64350;
-			break;
-		}
-		return RefWhite;
-	}
-
-	double Determinant3x3(const Mtx3x3& m)
+	const RgbModel& GetRGBModel(RgbEnum Model)
 	{
-		double det = m.m[0][0] * (m.m[2][2] * m.m[1][1] - m.m[2][1] * m.m[1][2]) -
-			m.m[1][0] * (m.m[2][2] * m.m[0][1] - m.m[2][1] * m.m[0][2]) +
-			m.m[2][0] * (m.m[1][2] * m.m[0][1] - m.m[1][1] * m.m[0][2]);
-
-		return (det);
-	}
-
-	void MtxInvert3x3(const Mtx3x3& m, Mtx3x3& i)
-	{
-		double scale = 1.0 / Determinant3x3(m);
-
-		i.m[0][0] = scale * (m.m[2][2] * m.m[1][1] - m.m[2][1] * m.m[1][2]);
-		i.m[0][1] = -scale * (m.m[2][2] * m.m[0][1] - m.m[2][1] * m.m[0][2]);
-		i.m[0][2] = scale * (m.m[1][2] * m.m[0][1] - m.m[1][1] * m.m[0][2]);
-
-		i.m[1][0] = -scale * (m.m[2][2] * m.m[1][0] - m.m[2][0] * m.m[1][2]);
-		i.m[1][1] = scale * (m.m[2][2] * m.m[0][0] - m.m[2][0] * m.m[0][2]);
-		i.m[1][2] = -scale * (m.m[1][2] * m.m[0][0] - m.m[1][0] * m.m[0][2]);
-
-		i.m[2][0] = scale * (m.m[2][1] * m.m[1][0] - m.m[2][0] * m.m[1][1]);
-		i.m[2][1] = -scale * (m.m[2][1] * m.m[0][0] - m.m[2][0] * m.m[0][1]);
-		i.m[2][2] = scale * (m.m[1][1] * m.m[0][0] - m.m[1][0] * m.m[0][1]);
-	}
-
-	void MtxTranspose3x3(Mtx3x3& m)
-	{
-		double v = m.m[0][1];
-		m.m[0][1] = m.m[1][0];
-		m.m[1][0] = v;
-
-		v = m.m[0][2];
-		m.m[0][2] = m.m[2][0];
-		m.m[2][0] = v;
-
-		v = m.m[1][2];
-		m.m[1][2] = m.m[2][1];
-		m.m[2][1] = v;
-	}
-
-	RgbModel GetRGBModel(RgbEnum Model = RgbEnum::sRGB)
-	{
-		RgbModel result;
-		result.RefWhiteRGB.Y = 1.00000;
-		double xr, yr, xg, yg, xb, yb;
-
-		switch (Model)
-		{
-		case RgbEnum::AdobeRgb:	/* Adobe RGB (1998) */
-			xr = 0.64;
-			yr = 0.33;
-			xg = 0.21;
-			yg = 0.71;
-			xb = 0.15;
-			yb = 0.06;
-
-			result.RefWhiteRGB.X = 0.95047;
-			result.RefWhiteRGB.Z = 1.08883;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::AppleRgb:	/* AppleRGB */
-			xr = 0.625;
-			yr = 0.340;
-			xg = 0.280;
-			yg = 0.595;
-			xb = 0.155;
-			yb = 0.070;
-
-			result.RefWhiteRGB.X = 0.95047;
-			result.RefWhiteRGB.Z = 1.08883;
-
-			result.GammaRGB = 1.8;
-			break;
-		case RgbEnum::BestRgb:	/* Best RGB */
-			xr = 0.7347;
-			yr = 0.2653;
-			xg = 0.2150;
-			yg = 0.7750;
-			xb = 0.1300;
-			yb = 0.0350;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::BetaRgb:	/* Beta RGB */
-			xr = 0.6888;
-			yr = 0.3112;
-			xg = 0.1986;
-			yg = 0.7551;
-			xb = 0.1265;
-			yb = 0.0352;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::BruceRgb:	/* Bruce RGB */
-			xr = 0.64;
-			yr = 0.33;
-			xg = 0.28;
-			yg = 0.65;
-			xb = 0.15;
-			yb = 0.06;
-
-			result.RefWhiteRGB.X = 0.95047;
-			result.RefWhiteRGB.Z = 1.08883;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::CieRgb:	/* CIE RGB */
-			xr = 0.735;
-			yr = 0.265;
-			xg = 0.274;
-			yg = 0.717;
-			xb = 0.167;
-			yb = 0.009;
-
-			result.RefWhiteRGB.X = 1.00000;
-			result.RefWhiteRGB.Z = 1.00000;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::ColorMatchRgb:	/* ColorMatch RGB */
-			xr = 0.630;
-			yr = 0.340;
-			xg = 0.295;
-			yg = 0.605;
-			xb = 0.150;
-			yb = 0.075;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 1.8;
-			break;
-		case RgbEnum::DonRgb4:	/* Don RGB 4 */
-			xr = 0.696;
-			yr = 0.300;
-			xg = 0.215;
-			yg = 0.765;
-			xb = 0.130;
-			yb = 0.035;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::EciRgb2:	/* ECI RGB v2 */
-			xr = 0.67;
-			yr = 0.33;
-			xg = 0.21;
-			yg = 0.71;
-			xb = 0.14;
-			yb = 0.08;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 0.0;
-			break;
-		case RgbEnum::EktaSpacePS5:	/* Ekta Space PS5 */
-			xr = 0.695;
-			yr = 0.305;
-			xg = 0.260;
-			yg = 0.700;
-			xb = 0.110;
-			yb = 0.005;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::NtscRgb:	/* NTSC RGB */
-			xr = 0.67;
-			yr = 0.33;
-			xg = 0.21;
-			yg = 0.71;
-			xb = 0.14;
-			yb = 0.08;
-
-			result.RefWhiteRGB.X = 0.98074;
-			result.RefWhiteRGB.Z = 1.18232;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::PalSecamRgb:	/* PAL/SECAM RGB */
-			xr = 0.64;
-			yr = 0.33;
-			xg = 0.29;
-			yg = 0.60;
-			xb = 0.15;
-			yb = 0.06;
-
-			result.RefWhiteRGB.X = 0.95047;
-			result.RefWhiteRGB.Z = 1.08883;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::ProPhotoRgb:	/* ProPhoto RGB */
-			xr = 0.7347;
-			yr = 0.2653;
-			xg = 0.1596;
-			yg = 0.8404;
-			xb = 0.0366;
-			yb = 0.0001;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 1.8;
-			break;
-		case RgbEnum::SmpteCRgb:	/* SMPTE-C RGB */
-			xr = 0.630;
-			yr = 0.340;
-			xg = 0.310;
-			yg = 0.595;
-			xb = 0.155;
-			yb = 0.070;
-
-			result.RefWhiteRGB.X = 0.95047;
-			result.RefWhiteRGB.Z = 1.08883;
-
-			result.GammaRGB = 2.2;
-			break;
-		case RgbEnum::sRGB:	/* sRGB */
-			xr = 0.64;
-			yr = 0.33;
-			xg = 0.30;
-			yg = 0.60;
-			xb = 0.15;
-			yb = 0.06;
-
-			result.RefWhiteRGB.X = 0.95047;
-			result.RefWhiteRGB.Z = 1.08883;
-
-			result.GammaRGB = -2.2;
-			break;
-		case RgbEnum::WideGamutRgb:	/* Wide Gamut RGB */
-			xr = 0.735;
-			yr = 0.265;
-			xg = 0.115;
-			yg = 0.826;
-			xb = 0.157;
-			yb = 0.018;
-
-			result.RefWhiteRGB.X = 0.96422;
-			result.RefWhiteRGB.Z = 0.82521;
-
-			result.GammaRGB = 2.2;
-			break;
-		}
-
-		Mtx3x3 m = { { {xr / yr, xg / yg, xb / yb}, {1.0, 1.0, 1.0}, {(1.0 - xr - yr) / yr, (1.0 - xg - yg) / yg, (1.0 - xb - yb) / yb} } };
-		Mtx3x3 mi = { { {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0} } };
-		MtxInvert3x3(m, mi);
-
-		double sr = result.RefWhiteRGB.X * mi.m[0][0] + result.RefWhiteRGB.Y * mi.m[0][1] + result.RefWhiteRGB.Z * mi.m[0][2];
-		double sg = result.RefWhiteRGB.X * mi.m[1][0] + result.RefWhiteRGB.Y * mi.m[1][1] + result.RefWhiteRGB.Z * mi.m[1][2];
-		double sb = result.RefWhiteRGB.X * mi.m[2][0] + result.RefWhiteRGB.Y * mi.m[2][1] + result.RefWhiteRGB.Z * mi.m[2][2];
-
-		result.MtxRGB2XYZ.m[0][0] = sr * m.m[0][0];
-		result.MtxRGB2XYZ.m[0][1] = sg * m.m[0][1];
-		result.MtxRGB2XYZ.m[0][2] = sb * m.m[0][2];
-		result.MtxRGB2XYZ.m[1][0] = sr * m.m[1][0];
-		result.MtxRGB2XYZ.m[1][1] = sg * m.m[1][1];
-		result.MtxRGB2XYZ.m[1][2] = sb * m.m[1][2];
-		result.MtxRGB2XYZ.m[2][0] = sr * m.m[2][0];
-		result.MtxRGB2XYZ.m[2][1] = sg * m.m[2][1];
-		result.MtxRGB2XYZ.m[2][2] = sb * m.m[2][2];
-
-		MtxTranspose3x3(result.MtxRGB2XYZ);
-
-		MtxInvert3x3(result.MtxRGB2XYZ, result.MtxXYZ2RGB);
-
-		return result;
+		return kRgbModels[static_cast<size_t>(Model)];
 	}
 
-	const Mtx3x3 Adaptations[3][2] = {
-			{
-				{{{0.8951, -0.7502, 0.0389}, {0.2664, 1.7135, -0.0685}, {-0.1614, 0.0367, 1.0296}}},
-				{{{0.9869929, 0.4323053, -0.0085287}, {-0.1470543, 0.5183603, 0.0400428}, {0.1599627, 0.0492912, 0.9684867}}}
-			},
-			{
-				{{{0.40024, -0.2263, 0}, {0.7076, 1.16532, 0}, {-0.08081, 0.0457, 0.91822}}},
-				{{{1.8599364, 0.3611914, 0}, {-1.1293816, 0.6388125, 0}, {0.2198974, -0.0000064, 1.0890636}}}
-			},
-			{
-				{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}},
-				{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}},
-			}
-		}; 
-
 	void GetAdaptation(AdaptationEnum Method, Mtx3x3& MtxAdaptMa, Mtx3x3& MtxAdaptMaI)
 	{
 		switch (Method)
@@ -586,69 +203,71 @@ namespace COLORNS
 		}
 	}
 
-	double Compand(double linear, const double gamma)
+	template <typename T>
+	T Compand(T linear, const double gamma)
 	{
-		double companded;
+		T companded;
 		if (gamma > 0.0)
 		{
-			companded = (linear >= 0.0) ? pow(linear, 1.0 / gamma) : -pow(-linear, 1.0 / gamma);
+			companded = (linear >= 0) ? std::pow(linear, T(1.0 / gamma)) : -std::pow(-linear, T(1.0 / gamma));
 		}
 		else if (gamma < 0.0)
 		{
 			/* sRGB */
-			double sign = 1.0;
-			if (linear < 0.0)
+			T sign = 1;
+			if (linear < 0)
 			{
-				sign = -1.0;
+				sign = -1;
 				linear = -linear;
 			}
-			companded = (linear <= 0.0031308) ? (linear * 12.92) : (1.055 * pow(linear, 1.0 / 2.4) - 0.055);
+			companded = (linear <= T(0.0031308)) ? (linear * T(12.92)) : (T(1.055) * std::pow(linear, T(1.0 / 2.4)) - T(0.055));
 			companded *= sign;
 		}
 		else
 		{
 			/* L* */
-			double sign = 1.0;
-			if (linear < 0.0)
+			T sign = 1;
+			if (linear < 0)
 			{
-				sign = -1.0;
+				sign = -1;
 				linear = -linear;
 			}
-			companded = (linear <= (216.0 / 24389.0)) ? (linear * 24389.0 / 2700.0) : (1.16 * pow(linear, 1.0 / 3.0) - 0.16);
+			companded = (linear <= T(216.0 / 24389.0)) ? (linear * T(24389.0) / T(2700.0)) : (T(1.16) * std::pow(linear, T(1.0 / 3.0)) - T(0.16));
 			companded *= sign;
 		}
 		return companded;
 	}
 
-	double InvCompand(double companded, const double gamma)
+	template <typename T>
+	T InvCompand(T companded, const double gamma)
 	{
-		double linear;
+		T linear;
 		if (gamma > 0.0)
 		{
-			linear = (companded >= 0.0) ? pow(companded, gamma) : -pow(-companded, gamma);
+			linear = (companded >= 0) ? std::pow(companded, T(gamma)) : -std::pow(-companded, T(gamma));
 		}
 		else if (gamma < 0.0)
 		{
 			/* sRGB */
-			double sign = 1.0;
-			if (companded < 0.0)
+			T sign = 1;
+			if (companded < 0)
 			{
-				sign = -1.0;
+				sign = -1;
 				companded = -companded;
 			}
-			linear = (companded <= 0.04045) ? (companded / 12.92) : pow((companded + 0.055) / 1.055, 2.4);
+			linear = (companded <= T(0.04045)) ? (companded / T(12.92)) : std::pow((companded + T(0.055)) / T(1.055), T(2.4));
 			linear *= sign;
 		}
 		else
 		{
 			/* L* */
-			double sign = 1.0;
-			if (companded < 0.0)
+			T sign = 1;
+			if (companded < 0)
 			{
-				sign = -1.0;
+				sign = -1;
 				companded = -companded;
 			}
-			linear = (companded <= 0.08) ? (2700.0 * companded / 24389.0) : ((((1000000.0 * companded + 480000.0) * companded + 76800.0) * companded + 4096.0) / 1560896.0);
+			linear = (companded <= T(0.08)) ? (T(2700.0) * companded / T(24389.0)) : ((((T(1000000.0) * companded + T(480000.0)) * companded + T(76800.0)) * companded + T(4096.0)) / T(1560896.0));
 			linear *= sign;
 		}
 		return(linear);
@@ -656,43 +275,49 @@ namespace COLORNS
 
 	// RGB to XYZ
 	// http://brucelindbloom.com/index.html?Eqn_RGB_to_XYZ.html
-	void RGB2XYZ(const double& r, const double& g, const double& b, 
+	// The white point cone responses are per call and stay double,
+	// the per pixel math runs in T.
+	template <typename T>
+	void RGB2XYZ(const T& r, const T& g, const T& b,
 		const double gamma, const RgbModel& model,
-		double& x, double& y, double& z, const XYZ& RefWhite,
-		const AdaptationEnum Method = AdaptationEnum::amBradford)
+		T& x, T& y, T& z, const XYZ& RefWhite,
+		const AdaptationEnum Method)
 	{
-		Mtx3x3 MtxAdaptMa = Adaptations[static_cast<size_t>(Method)][0];
-		Mtx3x3 MtxAdaptMaI = Adaptations[static_cast<size_t>(Method)][1];
+		const BasicMtx3x3<T> MtxAdaptMa = MtxConvert3x3<T>(Adaptations[static_cast<size_t>(Method)][0]);
+		const BasicMtx3x3<T> MtxAdaptMaI = MtxConvert3x3<T>(Adaptations[static_cast<size_t>(Method)][1]);
+		const BasicMtx3x3<T> MtxRGB2XYZ = MtxConvert3x3<T>(model.MtxRGB2XYZ);
 //		GetAdaptation(Method, MtxAdaptMa, MtxAdaptMaI);
 
 		// Inverse Gamma Companding
-		double R = InvCompand(r, gamma);
-		double G = InvCompand(g, gamma);
-		double B = InvCompand(b, gamma);
+		T R = InvCompand(r, gamma);
+		T G = InvCompand(g, gamma);
+		T B = InvCompand(b, gamma);
 
 		// Linear RGB to XYZ
-		x = R * model.MtxRGB2XYZ.m[0][0] + G * model.MtxRGB2XYZ.m[1][0] + B * model.MtxRGB2XYZ.m[2][0];
-		y = R * model.MtxRGB2XYZ.m[0][1] + G * model.MtxRGB2XYZ.m[1][1] + B * model.MtxRGB2XYZ.m[2][1];
-		z = R * model.MtxRGB2XYZ.m[0][2] + G * model.MtxRGB2XYZ.m[1][2] + B * model.MtxRGB2XYZ.m[2][2];
+		x = R * MtxRGB2XYZ.m[0][0] + G * MtxRGB2XYZ.m[1][0] + B * MtxRGB2XYZ.m[2][0];
+		y = R * MtxRGB2XYZ.m[0][1] + G * MtxRGB2XYZ.m[1][1] + B * MtxRGB2XYZ.m[2][1];
+		z = R * MtxRGB2XYZ.m[0][2] + G * MtxRGB2XYZ.m[1][2] + B * MtxRGB2XYZ.m[2][2];
 
 		// Chromatic Adaptation
 		if (Method != AdaptationEnum::amNone)
 		{
-			double Ad = RefWhite.X * MtxAdaptMa.m[0][0] + RefWhite.Y * MtxAdaptMa.m[1][0] + RefWhite.Z * MtxAdaptMa.m[2][0];
-			double Bd = RefWhite.X * MtxAdaptMa.m[0][1] + RefWhite.Y * MtxAdaptMa.m[1][1] + RefWhite.Z * MtxAdaptMa.m[2][1];
-			double Cd = RefWhite.X * MtxAdaptMa.m[0][2] + RefWhite.Y * MtxAdaptMa.m[1][2] + RefWhite.Z * MtxAdaptMa.m[2][2];
+			const Mtx3x3& Ma = Adaptations[static_cast<size_t>(Method)][0];
+
+			double Ad = RefWhite.X * Ma.m[0][0] + RefWhite.Y * Ma.m[1][0] + RefWhite.Z * Ma.m[2][0];
+			double Bd = RefWhite.X * Ma.m[0][1] + RefWhite.Y * Ma.m[1][1] + RefWhite.Z * Ma.m[2][1];
+			double Cd = RefWhite.X * Ma.m[0][2] + RefWhite.Y * Ma.m[1][2] + RefWhite.Z * Ma.m[2][2];
 
-			double As = model.RefWhiteRGB.X * MtxAdaptMa.m[0][0] + model.RefWhiteRGB.Y * MtxAdaptMa.m[1][0] + model.RefWhiteRGB.Z * MtxAdaptMa.m[2][0];
-			double Bs = model.RefWhiteRGB.X * MtxAdaptMa.m[0][1] + model.RefWhiteRGB.Y * MtxAdaptMa.m[1][1] + model.RefWhiteRGB.Z * MtxAdaptMa.m[2][1];
-			double Cs = model.RefWhiteRGB.X * MtxAdaptMa.m[0][2] + model.RefWhiteRGB.Y * MtxAdaptMa.m[1][2] + model.RefWhiteRGB.Z * MtxAdaptMa.m[2][2];
+			double As = model.RefWhiteRGB.X * Ma.m[0][0] + model.RefWhiteRGB.Y * Ma.m[1][0] + model.RefWhiteRGB.Z * Ma.m[2][0];
+			double Bs = model.RefWhiteRGB.X * Ma.m[0][1] + model.RefWhiteRGB.Y * Ma.m[1][1] + model.RefWhiteRGB.Z * Ma.m[2][1];
+			double Cs = model.RefWhiteRGB.X * Ma.m[0][2] + model.RefWhiteRGB.Y * Ma.m[1][2] + model.RefWhiteRGB.Z * Ma.m[2][2];
 
-			double X = x * MtxAdaptMa.m[0][0] + y * MtxAdaptMa.m[1][0] + z * MtxAdaptMa.m[2][0];
-			double Y = x * MtxAdaptMa.m[0][1] + y * MtxAdaptMa.m[1][1] + z * MtxAdaptMa.m[2][1];
-			double Z = x * MtxAdaptMa.m[0][2] + y * MtxAdaptMa.m[1][2] + z * MtxAdaptMa.m[2][2];
+			T X = x * MtxAdaptMa.m[0][0] + y * MtxAdaptMa.m[1][0] + z * MtxAdaptMa.m[2][0];
+			T Y = x * MtxAdaptMa.m[0][1] + y * MtxAdaptMa.m[1][1] + z * MtxAdaptMa.m[2][1];
+			T Z = x * MtxAdaptMa.m[0][2] + y * MtxAdaptMa.m[1][2] + z * MtxAdaptMa.m[2][2];
 
-			X *= (Ad / As);
-			Y *= (Bd / Bs);
-			Z *= (Cd / Cs);
+			X *= T(Ad / As);
+			Y *= T(Bd / Bs);
+			Z *= T(Cd / Cs);
 
 			x = X * MtxAdaptMaI.m[0][0] + Y * MtxAdaptMaI.m[1][0] + Z * MtxAdaptMaI.m[2][0];
 			y = X * MtxAdaptMaI.m[0][1] + Y * MtxAdaptMaI.m[1][1] + Z * MtxAdaptMaI.m[2][1];
@@ -700,251 +325,329 @@ namespace COLORNS
 		}
 	}
 
-	void XYZ2RGB(const double& x, const double& y, const double& z,
+	template <typename T>
+	void XYZ2RGB(const T& x, const T& y, const T& z,
 		const XYZ& RefWhite,
-		double& r, double& g, double& b,
+		T& r, T& g, T& b,
 		const double gamma, const RgbModel& model,
-		const AdaptationEnum Method = AdaptationEnum::amBradford)
+		const AdaptationEnum Method)
 	{
-		Mtx3x3 MtxAdaptMa = Adaptations[static_cast<size_t>(Method)][0];
-		Mtx3x3 MtxAdaptMaI = Adaptations[static_cast<size_t>(Method)][1];
+		const BasicMtx3x3<T> MtxAdaptMa = MtxConvert3x3<T>(Adaptations[static_cast<size_t>(Method)][0]);
+		const BasicMtx3x3<T> MtxAdaptMaI = MtxConvert3x3<T>(Adaptations[static_cast<size_t>(Method)][1]);
+		const BasicMtx3x3<T> MtxXYZ2RGB = MtxConvert3x3<T>(model.MtxXYZ2RGB);
 //		GetAdaptation(Method, MtxAdaptMa, MtxAdaptMaI);
 		
-		double X2 = x;
-		double Y2 = y;
-		double Z2 = z;
+		T X2 = x;
+		T Y2 = y;
+		T Z2 = z;
 
 		if (Method != AdaptationEnum::amNone)
 		{
-			double As = RefWhite.X * MtxAdaptMa.m[0][0] + RefWhite.Y * MtxAdaptMa.m[1][0] + RefWhite.Z * MtxAdaptMa.m[2][0];
-			double Bs = RefWhite.X * MtxAdaptMa.m[0][1] + RefWhite.Y * MtxAdaptMa.m[1][1] + RefWhite.Z * MtxAdaptMa.m[2][1];
-			double Cs = RefWhite.X * MtxAdaptMa.m[0][2] + RefWhite.Y * MtxAdaptMa.m[1][2] + RefWhite.Z * MtxAdaptMa.m[2][2];
+			const Mtx3x3& Ma = Adaptations[static_cast<size_t>(Method)][0];
 
-			double Ad = model.RefWhiteRGB.X * MtxAdaptMa.m[0][0] + model.RefWhiteRGB.Y * MtxAdaptMa.m[1][0] + model.RefWhiteRGB.Z * MtxAdaptMa.m[2][0];
-			double Bd = model.RefWhiteRGB.X * MtxAdaptMa.m[0][1] + model.RefWhiteRGB.Y * MtxAdaptMa.m[1][1] + model.RefWhiteRGB.Z * MtxAdaptMa.m[2][1];
-			double Cd = model.RefWhiteRGB.X * MtxAdaptMa.m[0][2] + model.RefWhiteRGB.Y * MtxAdaptMa.m[1][2] + model.RefWhiteRGB.Z * MtxAdaptMa.m[2][2];
+			double As = RefWhite.X * Ma.m[0][0] + RefWhite.Y * Ma.m[1][0] + RefWhite.Z * Ma.m[2][0];
+			double Bs = RefWhite.X * Ma.m[0][1] + RefWhite.Y * Ma.m[1][1] + RefWhite.Z * Ma.m[2][1];
+			double Cs = RefWhite.X * Ma.m[0][2] + RefWhite.Y * Ma.m[1][2] + RefWhite.Z * Ma.m[2][2];
 
-			double X1 = x * MtxAdaptMa.m[0][0] + y * MtxAdaptMa.m[1][0] + z * MtxAdaptMa.m[2][0];
-			double Y1 = x * MtxAdaptMa.m[0][1] + y * MtxAdaptMa.m[1][1] + z * MtxAdaptMa.m[2][1];
-			double Z1 = x * MtxAdaptMa.m[0][2] + y * MtxAdaptMa.m[1][2] + z * MtxAdaptMa.m[2][2];
+			double Ad = model.RefWhiteRGB.X * Ma.m[0][0] + model.RefWhiteRGB.Y * Ma.m[1][0] + model.RefWhiteRGB.Z * Ma.m[2][0];
+			double Bd = model.RefWhiteRGB.X * Ma.m[0][1] + model.RefWhiteRGB.Y * Ma.m[1][1] + model.RefWhiteRGB.Z * Ma.m[2][1];
+			double Cd = model.RefWhiteRGB.X * Ma.m[0][2] + model.RefWhiteRGB.Y * Ma.m[1][2] + model.RefWhiteRGB.Z * Ma.m[2][2];
 
-			X1 *= (Ad / As);
-			Y1 *= (Bd / Bs);
-			Z1 *= (Cd / Cs);
+			T X1 = x * MtxAdaptMa.m[0][0] + y * MtxAdaptMa.m[1][0] + z * MtxAdaptMa.m[2][0];
+			T Y1 = x * MtxAdaptMa.m[0][1] + y * MtxAdaptMa.m[1][1] + z * MtxAdaptMa.m[2][1];
+			T Z1 = x * MtxAdaptMa.m[0][2] + y * MtxAdaptMa.m[1][2] + z * MtxAdaptMa.m[2][2];
+
+			X1 *= T(Ad / As);
+			Y1 *= T(Bd / Bs);
+			Z1 *= T(Cd / Cs);
 
 			X2 = X1 * MtxAdaptMaI.m[0][0] + Y1 * MtxAdaptMaI.m[1][0] + Z1 * MtxAdaptMaI.m[2][0];
 			Y2 = X1 * MtxAdaptMaI.m[0][1] + Y1 * MtxAdaptMaI.m[1][1] + Z1 * MtxAdaptMaI.m[2][1];
 			Z2 = X1 * MtxAdaptMaI.m[0][2] + Y1 * MtxAdaptMaI.m[1][2] + Z1 * MtxAdaptMaI.m[2][2];
 		}
 
-		r = Compand(X2 * model.MtxXYZ2RGB.m[0][0] + Y2 * model.MtxXYZ2RGB.m[1][0] + Z2 * model.MtxXYZ2RGB.m[2][0], gamma);
-		g = Compand(X2 * model.MtxXYZ2RGB.m[0][1] + Y2 * model.MtxXYZ2RGB.m[1][1] + Z2 * model.MtxXYZ2RGB.m[2][1], gamma);
-		b = Compand(X2 * model.MtxXYZ2RGB.m[0][2] + Y2 * model.MtxXYZ2RGB.m[1][2] + Z2 * model.MtxXYZ2RGB.m[2][2], gamma);
+		r = Compand(X2 * MtxXYZ2RGB.m[0][0] + Y2 * MtxXYZ2RGB.m[1][0] + Z2 * MtxXYZ2RGB.m[2][0], gamma);
+		g = Compand(X2 * MtxXYZ2RGB.m[0][1] + Y2 * MtxXYZ2RGB.m[1][1] + Z2 * MtxXYZ2RGB.m[2][1], gamma);
+		b = Compand(X2 * MtxXYZ2RGB.m[0][2] + Y2 * MtxXYZ2RGB.m[1][2] + Z2 * MtxXYZ2RGB.m[2][2], gamma);
 	}
 
-	constexpr double kE = 216.0 / 24389.0;
-	constexpr double kK = 24389.0 / 27.0;
-	constexpr double kKE = 8.0;
-
-	void XYZ2Lab(const double& x, const double& y, const double& z,
+	template <typename T>
+	void XYZ2Lab(const T& x, const T& y, const T& z,
 		const XYZ& RefWhite,
-		double& l, double& a, double& b)
+		T& l, T& a, T& b)
 	{
-		double xr = x / RefWhite.X;
-		double yr = y / RefWhite.Y;
-		double zr = z / RefWhite.Z;
+		T xr = x / T(RefWhite.X);
+		T yr = y / T(RefWhite.Y);
+		T zr = z / T(RefWhite.Z);
 
-		double fx = (xr > kE) ? pow(xr, 1.0 / 3.0) : ((kK * xr + 16.0) / 116.0);
-		double fy = (yr > kE) ? pow(yr, 1.0 / 3.0) : ((kK * yr + 16.0) / 116.0);
-		double fz = (zr > kE) ? pow(zr, 1.0 / 3.0) : ((kK * zr + 16.0) / 116.0);
+		T fx = (xr > T(kE)) ? std::pow(xr, T(1.0 / 3.0)) : ((T(kK) * xr + T(16.0)) / T(116.0));
+		T fy = (yr > T(kE)) ? std::pow(yr, T(1.0 / 3.0)) : ((T(kK) * yr + T(16.0)) / T(116.0));
+		T fz = (zr > T(kE)) ? std::pow(zr, T(1.0 / 3.0)) : ((T(kK) * zr + T(16.0)) / T(116.0));
 
-		l = 116.0 * fy - 16.0;
-		a = 500.0 * (fx - fy);
-		b = 200.0 * (fy - fz);
+		l = T(116.0) * fy - T(16.0);
+		a = T(500.0) * (fx - fy);
+		b = T(200.0) * (fy - fz);
 	}
 
-	void Lab2XYZ(const double& l, const double& a, const double& b,
+	template <typename T>
+	void Lab2XYZ(const T& l, const T& a, const T& b,
 		const XYZ& RefWhite,
-		double& x, double& y, double& z)
+		T& x, T& y, T& z)
 	{
-		double fy = (l + 16.0) / 116.0;
-		double fx = 0.002 * a + fy;
-		double fz = fy - 0.005 * b;
+		T fy = (l + T(16.0)) / T(116.0);
+		T fx = T(0.002) * a + fy;
+		T fz = fy - T(0.005) * b;
 
-		double fx3 = fx * fx * fx;
-		double fz3 = fz * fz * fz;
+		T fx3 = fx * fx * fx;
+		T fz3 = fz * fz * fz;
 
-		double xr = (fx3 > kE) ? fx3 : ((116.0 * fx - 16.0) / kK);
-		double yr = (l > kKE) ? pow((l + 16.0) / 116.0, 3.0) : (l / kK);
-		double zr = (fz3 > kE) ? fz3 : ((116.0 * fz - 16.0) / kK);
+		T xr = (fx3 > T(kE)) ? fx3 : ((T(116.0) * fx - T(16.0)) / T(kK));
+		T yr = (l > T(kKE)) ? std::pow((l + T(16.0)) / T(116.0), T(3.0)) : (l / T(kK));
+		T zr = (fz3 > T(kE)) ? fz3 : ((T(116.0) * fz - T(16.0)) / T(kK));
 
-		x = xr * RefWhite.X;
-		y = yr * RefWhite.Y;
-		z = zr * RefWhite.Z;
+		x = xr * T(RefWhite.X);
+		y = yr * T(RefWhite.Y);
+		z = zr * T(RefWhite.Z);
 	}
 
-	//////////////////////////////////////////////////////////////////////////////////////////////////
-	XyzColor::XyzColor(double X, double Y, double Z) :
-		channels(X, Y, Z)
-	{}
-
-	XyzColor::XyzColor(const XyzColor& xyz) :
-		channels(xyz.m_ch1, xyz.m_ch2, xyz.m_ch3)
-	{}
-
-	double XyzColor::GetX() const noexcept
+	// cube root: exponent / 3 bit trick seed and two Halley steps,
+	// relative error under 1e-14; zero, denormals, inf and NaN go to cbrt()
+	double FastCbrt(double x)
 	{
-		return m_ch1;
-	}
-
-	double XyzColor::GetY() const noexcept
-	{
-		return m_ch2;
-	}
-
-	double XyzColor::GetZ() const noexcept
-	{
-		return m_ch3;
-	}
-
-	XyzColor& XyzColor::operator=(const XyzColor& xyz)
-	{
-		m_ch1 = xyz.m_ch1;
-		m_ch2 = xyz.m_ch2;
-		m_ch3 = xyz.m_ch3;
-		return *this;
+		uint64_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		const uint64_t exponent = (bits >> 52) & 0x7ff;
+		if ((bits >> 63) || exponent == 0 || exponent == 0x7ff)
+			return cbrt(x);
+		bits = bits / 3 + 0x2a9f7893782da1ceull;
+		double y;
+		memcpy(&y, &bits, sizeof(y));
+		for (int i = 0; i < 2; ++i)
+		{
+			double y3 = y * y * y;
+			y *= (y3 + 2.0 * x) / (2.0 * y3 + x);
+		}
+		return y;
 	}
 
-	std::ostream& operator<<(std::ostream& out, const XyzColor& xyz)
+	// the same for float, two Halley steps reach float precision
+	float FastCbrt(float x)
 	{
-		out << "xyz(" << xyz.m_ch1 << ", " << xyz.m_ch2 << ", " << xyz.m_ch3 << ")";
-		return out;
+		uint32_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		const uint32_t exponent = (bits >> 23) & 0xff;
+		if ((bits >> 31) || exponent == 0 || exponent == 0xff)
+			return std::cbrt(x);
+		bits = bits / 3 + 0x2a508935u;
+		float y;
+		memcpy(&y, &bits, sizeof(y));
+		for (int i = 0; i < 2; ++i)
+		{
+			float y3 = y * y * y;
+			y *= (y3 + 2.0f * x) / (2.0f * y3 + x);
+		}
+		return y;
 	}
 
-	LabColor::LabColor(double L, double a, double b) :
-		channels(L, a, b)
-	{}
-
-	LabColor::LabColor(const LabColor & Lab) :
-		channels(Lab.m_ch1, Lab.m_ch2, Lab.m_ch3)
-	{}
-
-	double LabColor::GetL() const noexcept
+	// XYZ2Lab with FastCbrt in place of pow(x, 1.0 / 3.0)
+	template <typename T>
+	void XYZ2LabFast(const T& x, const T& y, const T& z,
+		const XYZ& RefWhite,
+		T& l, T& a, T& b)
 	{
-		return m_ch1;
-	}
+		T xr = x / T(RefWhite.X);
+		T yr = y / T(RefWhite.Y);
+		T zr = z / T(RefWhite.Z);
 
-	double LabColor::GetA() const noexcept
-	{
-		return m_ch2;
-	}
+		T fx = (xr > T(kE)) ? FastCbrt(xr) : ((T(kK) * xr + T(16.0)) / T(116.0));
+		T fy = (yr > T(kE)) ? FastCbrt(yr) : ((T(kK) * yr + T(16.0)) / T(116.0));
+		T fz = (zr > T(kE)) ? FastCbrt(zr) : ((T(kK) * zr + T(16.0)) / T(116.0));
 
-	double LabColor::GetB() const noexcept
-	{
-		return m_ch3;
+		l = T(116.0) * fy - T(16.0);
+		a = T(500.0) * (fx - fy);
+		b = T(200.0) * (fy - fz);
 	}
 
-	LabColor& LabColor::operator=(const LabColor& Lab)
-	{
-		m_ch1 = Lab.m_ch1;
-		m_ch2 = Lab.m_ch2;
-		m_ch3 = Lab.m_ch3;
-		return *this;
-	}
+	// Lab2XYZ cubing fy like the other two channels instead of pow((l + 16.0) / 116.0, 3.0)
+	template <typename T>
+	void Lab2XYZFast(const T& l, const T& a, const T& b,
+		const XYZ& RefWhite,
+		T& x, T& y, T& z)
+	{
+		T fy = (l + T(16.0)) / T(116.0);
+		T fx = T(0.002) * a + fy;
+		T fz = fy - T(0.005) * b;
+
+		T fx3 = fx * fx * fx;
+		T fz3 = fz * fz * fz;
+
+		T xr = (fx3 > T(kE)) ? fx3 : ((T(116.0) * fx - T(16.0)) / T(kK));
+		T yr = (l > T(kKE)) ? fy * fy * fy : (l / T(kK));
+		T zr = (fz3 > T(kE)) ? fz3 : ((T(116.0) * fz - T(16.0)) / T(kK));
+
+		x = xr * T(RefWhite.X);
+		y = yr * T(RefWhite.Y);
+		z = zr * T(RefWhite.Z);
+	}
+
+	template <typename T>
+	T DeltaE76(const T l1, const T a1, const T b1,
+		const T l2, const T a2, const T b2)
+	{
+		const T dl = l2 - l1;
+		const T da = a2 - a1;
+		const T db = b2 - b1;
+		return std::sqrt(dl * dl + da * da + db * db);
+	}
+
+	template <typename T>
+	T DeltaE94(const T l1, const T a1, const T b1,
+		const T l2, const T a2, const T b2)
+	{
+		const T c1 = std::sqrt(a1 * a1 + b1 * b1);
+		const T c2 = std::sqrt(a2 * a2 + b2 * b2);
+		const T dl = l2 - l1;
+		const T dc = c2 - c1;
+		const T da = a2 - a1;
+		const T db = b2 - b1;
+		// dH^2, clamped against rounding
+		const T dh2 = std::max(T(0.0), da * da + db * db - dc * dc);
+		const T sc = T(1.0) + T(0.045) * c1;
+		const T sh = T(1.0) + T(0.015) * c1;
+		return std::sqrt(dl * dl + (dc / sc) * (dc / sc) + dh2 / (sh * sh));
+	}
+
+	// CIEDE2000 as in Sharma, Wu, Dalal (2005), kL = kC = kH = 1
+	template <typename T>
+	T DeltaE2000(const T l1, const T a1, const T b1,
+		const T l2, const T a2, const T b2)
+	{
+		const T pi = T(3.14159265358979323846);
+		const T deg = pi / T(180.0);
+		const T pow25_7 = T(6103515625.0);		// 25^7
+
+		const T c1 = std::sqrt(a1 * a1 + b1 * b1);
+		const T c2 = std::sqrt(a2 * a2 + b2 * b2);
+		const T cm = (c1 + c2) / T(2.0);
+		const T cm7 = std::pow(cm, T(7.0));
+		const T g = T(0.5) * (T(1.0) - std::sqrt(cm7 / (cm7 + pow25_7)));
+		const T ap1 = (T(1.0) + g) * a1;
+		const T ap2 = (T(1.0) + g) * a2;
+		const T cp1 = std::sqrt(ap1 * ap1 + b1 * b1);
+		const T cp2 = std::sqrt(ap2 * ap2 + b2 * b2);
+		T hp1 = (ap1 == T(0.0) && b1 == T(0.0)) ? T(0.0) : std::atan2(b1, ap1);
+		T hp2 = (ap2 == T(0.0) && b2 == T(0.0)) ? T(0.0) : std::atan2(b2, ap2);
+		if (hp1 < T(0.0))
+			hp1 += T(2.0) * pi;
+		if (hp2 < T(0.0))
+			hp2 += T(2.0) * pi;
+
+		const T dl = l2 - l1;
+		const T dc = cp2 - cp1;
+		T dh = T(0.0);
+		T hm = hp1 + hp2;
+		if (cp1 * cp2 != T(0.0))
+		{
+			dh = hp2 - hp1;
+			if (dh > pi)
+				dh -= T(2.0) * pi;
+			else if (dh < -pi)
+				dh += T(2.0) * pi;
+			if (std::fabs(hp1 - hp2) <= pi)
+				hm = hm / T(2.0);
+			else
+				hm = (hm < T(2.0) * pi) ? (hm + T(2.0) * pi) / T(2.0) : (hm - T(2.0) * pi) / T(2.0);
+		}
+		const T dH = T(2.0) * std::sqrt(cp1 * cp2) * std::sin(dh / T(2.0));
+
+		const T lm = (l1 + l2) / T(2.0);
+		const T cpm = (cp1 + cp2) / T(2.0);
+		const T t = T(1.0) - T(0.17) * std::cos(hm - T(30.0) * deg) + T(0.24) * std::cos(T(2.0) * hm)
+			+ T(0.32) * std::cos(T(3.0) * hm + T(6.0) * deg) - T(0.20) * std::cos(T(4.0) * hm - T(63.0) * deg);
+		const T dtheta = T(30.0) * deg * std::exp(-((hm / deg - T(275.0)) / T(25.0)) * ((hm / deg - T(275.0)) / T(25.0)));
+		const T cpm7 = std::pow(cpm, T(7.0));
+		const T rc = T(2.0) * std::sqrt(cpm7 / (cpm7 + pow25_7));
+		const T lm50 = (lm - T(50.0)) * (lm - T(50.0));
+		const T sl = T(1.0) + T(0.015) * lm50 / std::sqrt(T(20.0) + lm50);
+		const T sc = T(1.0) + T(0.045) * cpm;
+		const T sh = T(1.0) + T(0.015) * cpm * t;
+		const T rt = -std::sin(T(2.0) * dtheta) * rc;
+
+		const T vl = dl / sl;
+		const T vc = dc / sc;
+		const T vh = dH / sh;
+		return std::sqrt(vl * vl + vc * vc + vh * vh + rt * vc * vh);
+	}
+
+	// the scalar types the templates above are built for
+#define COLOR_INSTANTIATE_SCALAR(T) \
+	template T GetLuminance(const T, const T, const T); \
+	template void GetHSPVL(const T, const T, const T, T&, T&, T&, T&, T&); \
+	template void GetRGBfromHSV(const T, const T, const T, T&, T&, T&); \
+	template T Compand(T, const double); \
+	template T InvCompand(T, const double); \
+	template void RGB2XYZ(const T&, const T&, const T&, const double, const RgbModel&, T&, T&, T&, const XYZ&, const AdaptationEnum); \
+	template void XYZ2RGB(const T&, const T&, const T&, const XYZ&, T&, T&, T&, const double, const RgbModel&, const AdaptationEnum); \
+	template void XYZ2Lab(const T&, const T&, const T&, const XYZ&, T&, T&, T&); \
+	template void Lab2XYZ(const T&, const T&, const T&, const XYZ&, T&, T&, T&); \
+	template void XYZ2LabFast(const T&, const T&, const T&, const XYZ&, T&, T&, T&); \
+	template void Lab2XYZFast(const T&, const T&, const T&, const XYZ&, T&, T&, T&); \
+	template T DeltaE76(const T, const T, const T, const T, const T, const T); \
+	template T DeltaE94(const T, const T, const T, const T, const T, const T); \
+	template T DeltaE2000(const T, const T, const T, const T, const T, const T);
+
+	COLOR_INSTANTIATE_SCALAR(float)
+	COLOR_INSTANTIATE_SCALAR(double)
+
+#undef COLOR_INSTANTIATE_SCALAR
 
-	std::ostream& operator<<(std::ostream& out, const LabColor& Lab)
+	//////////////////////////////////////////////////////////////////////////////////////////////////
+	template <typename T>
+	std::ostream& operator<<(std::ostream& out, const BasicXyzColor<T>& xyz)
 	{
-		out << "Lab(" << Lab.m_ch1 << ", " << Lab.m_ch2 << ", " << Lab.m_ch3 << ")";
+		out << "xyz(" << xyz.GetX() << ", " << xyz.GetY() << ", " << xyz.GetZ() << ")";
 		return out;
 	}
 
-	RgbColor::RgbColor(double Red, double Green, double Blue):
-		channels(Red, Green, Blue)
-	{}
-	RgbColor::RgbColor(const RgbColor& rgb):
-		channels(rgb.m_ch1, rgb.m_ch2, rgb.m_ch3)
-	{}
-	double RgbColor::GetRed() const noexcept
-	{
-		return m_ch1;
-	}
-	double RgbColor::GetGreen() const noexcept
-	{
-		return m_ch2;
-	}
-	double RgbColor::GetBlue() const noexcept
-	{
-		return m_ch3;
-	}
-
-	double RgbColor::GetGamma() const noexcept
-	{
-		return m_gamma;
-	}
-
-	RgbColor& RgbColor::operator= (const RgbColor &rgb)
-	{
-		m_ch1 = rgb.m_ch1;
-		m_ch2 = rgb.m_ch2;
-		m_ch3 = rgb.m_ch3;
-		return *this;
-	}
-
-	std::ostream& operator<< (std::ostream& out, const RgbColor& rgb)
+	template <typename T>
+	std::ostream& operator<<(std::ostream& out, const BasicLabColor<T>& Lab)
 	{
-		out << "rgb(" << rgb.m_ch1 << ", " << rgb.m_ch2 << ", " << rgb.m_ch3 << ")";
+		out << "Lab(" << Lab.GetL() << ", " << Lab.GetA() << ", " << Lab.GetB() << ")";
 		return out;
 	}
 
-	HsvColor::HsvColor(double Hue, double Saturation, double Value) :
-		channels(Hue, Saturation, Value)
-	{}
-	HsvColor::HsvColor(const HsvColor& hsv) :
-		channels(hsv.m_ch1, hsv.m_ch2, hsv.m_ch3), 
-		m_lightness(hsv.m_lightness), 
-		m_luminance(hsv.m_luminance)
-	{}
-	double HsvColor::GetHue() const noexcept
+	template <typename T>
+	std::ostream& operator<< (std::ostream& out, const BasicRgbColor<T>& rgb)
 	{
-		return m_ch1;
-	}
-	double HsvColor::GetSaturation() const noexcept
-	{
-		return m_ch2;
-	}
-	double HsvColor::GetValue() const noexcept
-	{
-		return m_ch3;
-	}
-
-	double HsvColor::GetBrightness() const noexcept
-	{
-		return GetValue();
+		out << "rgb(" << rgb.GetRed() << ", " << rgb.GetGreen() << ", " << rgb.GetBlue() << ")";
+		return out;
 	}
 
-	double HsvColor::GetLightness() noexcept
+	template <typename T>
+	T BasicHsvColor<T>::GetLightness() noexcept
 	{
 		if (m_lightness < 0)
 		{
-			double r = 0;
-			double g = 0;
-			double b = 0;
+			T r = 0;
+			T g = 0;
+			T b = 0;
 			GetRGBfromHSV(m_ch1, m_ch2, m_ch3,
 				r, g, b);
-			double max = std::max(std::max(r, g), b);
-			double min = std::min(std::min(r, g), b);
+			T max = std::max(std::max(r, g), b);
+			T min = std::min(std::min(r, g), b);
 			m_lightness = (min + max) / 2;
 		}
 		return m_lightness;
 	}
 
-	double HsvColor::GetLuminance() noexcept
+	template <typename T>
+	T BasicHsvColor<T>::GetLuminance() noexcept
 	{
 		if (m_luminance < 0)
 		{
-			double r = 0;
-			double g = 0;
-			double b = 0;
+			T r = 0;
+			T g = 0;
+			T b = 0;
 			GetRGBfromHSV(m_ch1, m_ch2, m_ch3,
 				r, g, b);
 			m_luminance = COLORNS::GetLuminance(r, g, b);
@@ -952,88 +655,111 @@ namespace COLORNS
 		return m_luminance;
 	}
 
-	HsvColor& HsvColor::operator= (const HsvColor& hsv)
-	{
-		m_ch1 = hsv.m_ch1;
-		m_ch2 = hsv.m_ch2;
-		m_ch3 = hsv.m_ch3;
-		m_lightness = hsv.m_lightness;
-		m_luminance = hsv.m_luminance;
-		return *this;
-	}
-
-	std::ostream& operator<< (std::ostream& out, const HsvColor& hsv)
+	template <typename T>
+	std::ostream& operator<< (std::ostream& out, const BasicHsvColor<T>& hsv)
 	{
-		out << "hsv(" << hsv.m_ch1 << ", " << hsv.m_ch2 << ", " << hsv.m_ch3 << ")";
+		out << "hsv(" << hsv.GetHue() << ", " << hsv.GetSaturation() << ", " << hsv.GetValue() << ")";
 		return out;
 	}
 
-	void Color::DoRGB()
+	template class BasicXyzColor<float>;
+	template class BasicXyzColor<double>;
+	template class BasicLabColor<float>;
+	template class BasicLabColor<double>;
+	template class BasicRgbColor<float>;
+	template class BasicRgbColor<double>;
+	template class BasicHsvColor<float>;
+	template class BasicHsvColor<double>;
+
+	template std::ostream& operator<< (std::ostream&, const BasicXyzColor<float>&);
+	template std::ostream& operator<< (std::ostream&, const BasicXyzColor<double>&);
+	template std::ostream& operator<< (std::ostream&, const BasicLabColor<float>&);
+	template std::ostream& operator<< (std::ostream&, const BasicLabColor<double>&);
+	template std::ostream& operator<< (std::ostream&, const BasicRgbColor<float>&);
+	template std::ostream& operator<< (std::ostream&, const BasicRgbColor<double>&);
+	template std::ostream& operator<< (std::ostream&, const BasicHsvColor<float>&);
+	template std::ostream& operator<< (std::ostream&, const BasicHsvColor<double>&);
+
+	bool Color::IsValid(ModelEnum model) const noexcept
 	{
-		if (m_valid.mods.rgb == 0)
+		switch (model)
 		{
-			if (m_valid.mods.xyz)
-			{
-				XYZ2RGB(m_xyz.m_ch1, m_xyz.m_ch2, m_xyz.m_ch3,
-					GetRefWhite(),
-					m_rgb.m_ch1, m_rgb.m_ch2, m_rgb.m_ch3,
-					m_rgb.m_gamma, GetRGBModel());
-				m_valid.mods.rgb = 1;
-			}
-			else if (m_valid.mods.hsv)
-			{
-				GetRGBfromHSV(m_hsv.m_ch1, m_hsv.m_ch2, m_hsv.m_ch3,
-					m_rgb.m_ch1, m_rgb.m_ch2, m_rgb.m_ch3);
-				m_valid.mods.rgb = 1;
-			}
+		case ModelEnum::Hsv:
+			return m_valid.mods.hsv != 0;
+		case ModelEnum::Xyz:
+			return m_valid.mods.xyz != 0;
+		case ModelEnum::Lab:
+			return m_valid.mods.lab != 0;
+		default:
+		case ModelEnum::Rgb:
+			return m_valid.mods.rgb != 0;
 		}
 	}
 
-	void Color::DoHSV()
+	void Color::Update(ModelEnum model)
 	{
-		if (m_valid.mods.hsv == 0)
+		if (IsValid(model))
+			return;
+
+		ModelEnum src = model;
+		double cost = 0.0;
+		for (size_t m = 0; m < kModelCount; ++m)
 		{
-			// convert
-			if (m_valid.mods.rgb)
+			const ModelEnum candidate = static_cast<ModelEnum>(m);
+			if (IsValid(candidate) && (src == model || GetConversionRoute(candidate, model).Cost < cost))
 			{
-				GetHSPVL(m_rgb.m_ch1, m_rgb.m_ch2, m_rgb.m_ch3,
-					m_hsv.m_ch1, m_hsv.m_ch2, m_hsv.m_luminance, m_hsv.m_ch3, m_hsv.m_lightness);
-				m_valid.mods.hsv = 1;
+				src = candidate;
+				cost = GetConversionRoute(candidate, model).Cost;
 			}
 		}
-	}
+		if (src == model)
+			return;
 
-	void Color::DoXYZ()
-	{
-		if (m_valid.mods.xyz == 0)
+		double in[3] = { 0.0, 0.0, 0.0 };
+		switch (src)
 		{
-			if (m_valid.mods.lab)
-			{
-				Lab2XYZ(m_lab.m_ch1, m_lab.m_ch2, m_lab.m_ch3,
-					GetRefWhite(),
-					m_xyz.m_ch1, m_xyz.m_ch2, m_xyz.m_ch3);
-				m_valid.mods.xyz = 1;
-			}
-			else
-			{
-				DoRGB();
-				RGB2XYZ(m_rgb.m_ch1, m_rgb.m_ch2, m_rgb.m_ch3,
-					m_rgb.m_gamma, GetRGBModel(),
-					m_xyz.m_ch1, m_xyz.m_ch2, m_xyz.m_ch3, GetRefWhite());
-				m_valid.mods.xyz = 1;
-			}
+		case ModelEnum::Hsv:
+			in[0] = m_hsv.m_ch1; in[1] = m_hsv.m_ch2; in[2] = m_hsv.m_ch3;
+			break;
+		case ModelEnum::Xyz:
+			in[0] = m_xyz.m_ch1; in[1] = m_xyz.m_ch2; in[2] = m_xyz.m_ch3;
+			break;
+		case ModelEnum::Lab:
+			in[0] = m_lab.m_ch1; in[1] = m_lab.m_ch2; in[2] = m_lab.m_ch3;
+			break;
+		default:
+		case ModelEnum::Rgb:
+			in[0] = m_rgb.m_ch1; in[1] = m_rgb.m_ch2; in[2] = m_rgb.m_ch3;
+			break;
 		}
-	}
-
-	void Color::DoLAB()
-	{
-		if (m_valid.mods.lab == 0)
+		// HSV keeps the luminance and lightness GetHSPVL finds on the way, from the RGB
+		// every route to it goes through
+		if (model == ModelEnum::Hsv)
 		{
-			GetXYZ();
-			XYZ2Lab(m_xyz.m_ch1, m_xyz.m_ch2, m_xyz.m_ch3,
-				GetRefWhite(),
-				m_lab.m_ch1, m_lab.m_ch2, m_lab.m_ch3);
+			double rgb[3];
+			ConvertColor(GetPlan(), src, ModelEnum::Rgb, in, rgb);
+			GetHSPVL(rgb[0], rgb[1], rgb[2],
+				m_hsv.m_ch1, m_hsv.m_ch2, m_hsv.m_luminance, m_hsv.m_ch3, m_hsv.m_lightness);
+			m_valid.mods.hsv = 1;
+			return;
+		}
+		double out[3];
+		ConvertColor(GetPlan(), src, model, in, out);
+		switch (model)
+		{
+		case ModelEnum::Xyz:
+			m_xyz = XyzColor(out[0], out[1], out[2]);
+			m_valid.mods.xyz = 1;
+			break;
+		case ModelEnum::Lab:
+			m_lab = LabColor(out[0], out[1], out[2]);
 			m_valid.mods.lab = 1;
+			break;
+		default:
+		case ModelEnum::Rgb:
+			m_rgb = RgbColor(out[0], out[1], out[2]);
+			m_valid.mods.rgb = 1;
+			break;
 		}
 	}
 
@@ -1061,26 +787,145 @@ namespace COLORNS
 		m_valid.reset = 0;
 		m_valid.mods.lab = 1;
 	}
+	Color::Color(const RgbColor& rgb, const ConversionPlan& plan):
+		Color(rgb)
+	{
+		m_plan = &plan;
+	}
+	Color::Color(const HsvColor& hsv, const ConversionPlan& plan):
+		Color(hsv)
+	{
+		m_plan = &plan;
+	}
+	Color::Color(const XyzColor& xyz, const ConversionPlan& plan):
+		Color(xyz)
+	{
+		m_plan = &plan;
+	}
+	Color::Color(const LabColor& lab, const ConversionPlan& plan):
+		Color(lab)
+	{
+		m_plan = &plan;
+	}
+	const ConversionPlan& Color::GetPlan() const
+	{
+		return m_plan ? *m_plan : GetDefaultPlan();
+	}
 	XyzColor Color::GetXYZ()
 	{
-		DoXYZ();
+		Update(ModelEnum::Xyz);
 		return m_xyz;
 	}
 	LabColor Color::GetLAB()
 	{
-		DoLAB();
+		Update(ModelEnum::Lab);
 		return m_lab;
 	}
 	RgbColor Color::GetRGB()
 	{
-		DoRGB();
+		Update(ModelEnum::Rgb);
 		return m_rgb;
 	}
 
 	HsvColor Color::GetHSV()
 	{
-		DoHSV();
+		Update(ModelEnum::Hsv);
 		return m_hsv;
 	}
 
-};
\ No newline at end of file
+	template <typename T>
+	BasicCompactColor<T>::BasicCompactColor(ModelEnum model, T ch1, T ch2, T ch3) :
+		m_ch1(ch1), m_ch2(ch2), m_ch3(ch3), m_model(model)
+	{}
+
+	template <typename T>
+	BasicCompactColor<T>::BasicCompactColor(const RgbColor& rgb) :
+		BasicCompactColor(ModelEnum::Rgb, static_cast<T>(rgb.GetRed()), static_cast<T>(rgb.GetGreen()),
+			static_cast<T>(rgb.GetBlue()))
+	{}
+
+	template <typename T>
+	BasicCompactColor<T>::BasicCompactColor(const HsvColor& hsv) :
+		BasicCompactColor(ModelEnum::Hsv, static_cast<T>(hsv.GetHue()), static_cast<T>(hsv.GetSaturation()),
+			static_cast<T>(hsv.GetValue()))
+	{}
+
+	template <typename T>
+	BasicCompactColor<T>::BasicCompactColor(const XyzColor& xyz) :
+		BasicCompactColor(ModelEnum::Xyz, static_cast<T>(xyz.GetX()), static_cast<T>(xyz.GetY()),
+			static_cast<T>(xyz.GetZ()))
+	{}
+
+	template <typename T>
+	BasicCompactColor<T>::BasicCompactColor(const LabColor& lab) :
+		BasicCompactColor(ModelEnum::Lab, static_cast<T>(lab.GetL()), static_cast<T>(lab.GetA()),
+			static_cast<T>(lab.GetB()))
+	{}
+
+	template <typename T>
+	Color BasicCompactColor<T>::ToColor() const
+	{
+		switch (m_model)
+		{
+		case ModelEnum::Hsv:
+			return Color(HsvColor(m_ch1, m_ch2, m_ch3));
+		case ModelEnum::Xyz:
+			return Color(XyzColor(m_ch1, m_ch2, m_ch3));
+		case ModelEnum::Lab:
+			return Color(LabColor(m_ch1, m_ch2, m_ch3));
+		default:
+			return Color(RgbColor(m_ch1, m_ch2, m_ch3));
+		}
+	}
+
+	template <typename T>
+	ModelEnum BasicCompactColor<T>::GetModel() const noexcept
+	{
+		return m_model;
+	}
+
+	template <typename T>
+	T BasicCompactColor<T>::GetCh1() const noexcept
+	{
+		return m_ch1;
+	}
+
+	template <typename T>
+	T BasicCompactColor<T>::GetCh2() const noexcept
+	{
+		return m_ch2;
+	}
+
+	template <typename T>
+	T BasicCompactColor<T>::GetCh3() const noexcept
+	{
+		return m_ch3;
+	}
+
+	template <typename T>
+	RgbColor BasicCompactColor<T>::GetRGB() const
+	{
+		return ToColor().GetRGB();
+	}
+
+	template <typename T>
+	HsvColor BasicCompactColor<T>::GetHSV() const
+	{
+		return ToColor().GetHSV();
+	}
+
+	template <typename T>
+	XyzColor BasicCompactColor<T>::GetXYZ() const
+	{
+		return ToColor().GetXYZ();
+	}
+
+	template <typename T>
+	LabColor BasicCompactColor<T>::GetLAB() const
+	{
+		return ToColor().GetLAB();
+	}
+
+	template class BasicCompactColor<float>;
+	template class BasicCompactColor<double>;
+};
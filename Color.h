@@ -1,105 +1,123 @@
 #ifndef _COLOR_H_
 #define _COLOR_H_
 
+#include "ColorBuffer.h"
+
 #include <iostream>
+#include <type_traits>
 
 namespace COLORNS
 {
-	// base class with color channels
+	// base class with color channels, T is the scalar type (float or double);
+	// the colors are literal types, see ColorConstexpr.h for compile-time conversions
+	template <typename T = double>
 	class channels
 	{
 	protected:
-		double m_ch1{ 0.0 };
-		double m_ch2{ 0.0 };
-		double m_ch3{ 0.0 };
-		channels() {}
-		channels(double ch1, double ch2, double ch3): 
+		T m_ch1{ 0 };
+		T m_ch2{ 0 };
+		T m_ch3{ 0 };
+		constexpr channels() {}
+		constexpr channels(T ch1, T ch2, T ch3): 
 		m_ch1(ch1), m_ch2(ch2), m_ch3(ch3) {}
 	};
 
-	class XyzColor : public channels
+	template <typename T = double>
+	class BasicXyzColor : public channels<T>
 	{
+	protected:
+		using channels<T>::m_ch1;
+		using channels<T>::m_ch2;
+		using channels<T>::m_ch3;
 
 	public:
-		XyzColor() = default;
-		XyzColor(double X, double Y, double Z);
-		XyzColor(const XyzColor& xyz);
-		double GetX() const noexcept;
-		double GetY() const noexcept;
-		double GetZ() const noexcept;
+		BasicXyzColor() = default;
+		constexpr BasicXyzColor(T X, T Y, T Z) : channels<T>(X, Y, Z) {}
+		constexpr T GetX() const noexcept { return m_ch1; }
+		constexpr T GetY() const noexcept { return m_ch2; }
+		constexpr T GetZ() const noexcept { return m_ch3; }
 
 		friend class Color;
-
-		friend std::ostream& operator<< (std::ostream& out, const XyzColor& xyz);
-
-		XyzColor& operator= (const XyzColor& xyz);
 	};
 
-	std::ostream& operator<< (std::ostream& out, const XyzColor& xyz);
+	typedef BasicXyzColor<> XyzColor;
+
+	template <typename T>
+	std::ostream& operator<< (std::ostream& out, const BasicXyzColor<T>& xyz);
 
-	class LabColor : public channels
+	template <typename T = double>
+	class BasicLabColor : public channels<T>
 	{
+	protected:
+		using channels<T>::m_ch1;
+		using channels<T>::m_ch2;
+		using channels<T>::m_ch3;
 
 	public:
-		LabColor() = default;
-		LabColor(double L, double a, double b);
-		LabColor(const LabColor& Lab);
-		double GetL() const noexcept;
-		double GetA() const noexcept;
-		double GetB() const noexcept;
+		BasicLabColor() = default;
+		constexpr BasicLabColor(T L, T a, T b) : channels<T>(L, a, b) {}
+		constexpr T GetL() const noexcept { return m_ch1; }
+		constexpr T GetA() const noexcept { return m_ch2; }
+		constexpr T GetB() const noexcept { return m_ch3; }
 
 		friend class Color;
-
-		friend std::ostream& operator<< (std::ostream& out, const LabColor& Lab);
-
-		LabColor& operator= (const LabColor& Lab);
 	};
 
-	std::ostream& operator<< (std::ostream& out, const LabColor& Lab);
+	typedef BasicLabColor<> LabColor;
+
+	template <typename T>
+	std::ostream& operator<< (std::ostream& out, const BasicLabColor<T>& Lab);
 
-	class RgbColor : public channels
+	template <typename T = double>
+	class BasicRgbColor : public channels<T>
 	{
-		double m_gamma{-2.2};
+		T m_gamma{ T(-2.2) };
+	protected:
+		using channels<T>::m_ch1;
+		using channels<T>::m_ch2;
+		using channels<T>::m_ch3;
 	public:
-		RgbColor() = default;
-		RgbColor(double Red, double Green, double Blue);
-		RgbColor(const RgbColor& rgb);
-		double GetRed() const noexcept;
-		double GetGreen() const noexcept;
-		double GetBlue() const noexcept;
-		double GetGamma() const noexcept;
+		BasicRgbColor() = default;
+		constexpr BasicRgbColor(T Red, T Green, T Blue) : channels<T>(Red, Green, Blue) {}
+		constexpr T GetRed() const noexcept { return m_ch1; }
+		constexpr T GetGreen() const noexcept { return m_ch2; }
+		constexpr T GetBlue() const noexcept { return m_ch3; }
+		constexpr T GetGamma() const noexcept { return m_gamma; }
 
 		friend class Color;
-
-		friend std::ostream& operator<< (std::ostream& out, const RgbColor& rgb);
-
-		RgbColor& operator= (const RgbColor &rgb);
 	};
 
-	std::ostream& operator<< (std::ostream& out, const RgbColor& rgb);
+	typedef BasicRgbColor<> RgbColor;
 
-	class HsvColor : public channels
+	template <typename T>
+	std::ostream& operator<< (std::ostream& out, const BasicRgbColor<T>& rgb);
+
+	template <typename T = double>
+	class BasicHsvColor : public channels<T>
 	{
-		double m_lightness{ -1.0 };
-		double m_luminance{ -1.0 };
+		T m_lightness{ -1 };
+		T m_luminance{ -1 };
+	protected:
+		using channels<T>::m_ch1;
+		using channels<T>::m_ch2;
+		using channels<T>::m_ch3;
 	public:
-		HsvColor() = default;
-		HsvColor(double Red, double Green, double Blue);
-		HsvColor(const HsvColor& hsv);
-		double GetHue() const noexcept;
-		double GetSaturation() const noexcept;
-		double GetValue() const noexcept;
-		double GetBrightness() const noexcept;
-		double GetLightness() noexcept;
-		double GetLuminance() noexcept;
+		BasicHsvColor() = default;
+		constexpr BasicHsvColor(T Hue, T Saturation, T Value) : channels<T>(Hue, Saturation, Value) {}
+		constexpr T GetHue() const noexcept { return m_ch1; }
+		constexpr T GetSaturation() const noexcept { return m_ch2; }
+		constexpr T GetValue() const noexcept { return m_ch3; }
+		constexpr T GetBrightness() const noexcept { return m_ch3; }
+		T GetLightness() noexcept;
+		T GetLuminance() noexcept;
 
 		friend class Color;
-		friend std::ostream& operator<< (std::ostream& out, const HsvColor& hsv);
-
-		HsvColor& operator= (const HsvColor& rgb);
 	};
 
-	std::ostream& operator<< (std::ostream& out, const HsvColor& hsv);
+	typedef BasicHsvColor<> HsvColor;
+
+	template <typename T>
+	std::ostream& operator<< (std::ostream& out, const BasicHsvColor<T>& hsv);
 
 	class Color
 	{
@@ -122,17 +140,25 @@ namespace COLORNS
 		LabColor m_lab;
 
 		flags m_valid;
+		// the plan the models are derived with, GetDefaultPlan() when null
+		const ConversionPlan* m_plan{ nullptr };
 
-		void DoRGB();
-		void DoHSV();
-		void DoXYZ();
-		void DoLAB();
+		bool IsValid(ModelEnum model) const noexcept;
+		// model from the valid one with the cheapest GetConversionRoute, nothing else is stored
+		void Update(ModelEnum model);
 	public: 
 		Color() = default;
 		Color(const RgbColor& rgb);
 		Color(const HsvColor& hsv);
 		Color(const XyzColor& xyz);
 		Color(const LabColor& lab);
+		// the same in the working space, white and adaptation of plan, which must outlive
+		// the color (GetDefaultPlan and GetColorSpacePlan ones live for the program)
+		Color(const RgbColor& rgb, const ConversionPlan& plan);
+		Color(const HsvColor& hsv, const ConversionPlan& plan);
+		Color(const XyzColor& xyz, const ConversionPlan& plan);
+		Color(const LabColor& lab, const ConversionPlan& plan);
+		const ConversionPlan& GetPlan() const;
 		RgbColor GetRGB();
 		HsvColor GetHSV();
 		XyzColor GetXYZ();
@@ -144,6 +170,49 @@ namespace COLORNS
 		operator XyzColor() { return GetXYZ(); }
 		operator LabColor() { return GetLAB(); }
 	};
+
+	// Compact color for dense arrays: only the triple it was made from and its model.
+	// The other models are derived on each request through Color (sRGB, D50, Bradford),
+	// nothing is cached. 16 bytes for float, 32 for double, trivially copyable.
+	template <typename T = double>
+	class BasicCompactColor
+	{
+		T m_ch1{ 0 };
+		T m_ch2{ 0 };
+		T m_ch3{ 0 };
+		ModelEnum m_model{ ModelEnum::Rgb };
+
+		Color ToColor() const;
+	public:
+		BasicCompactColor() = default;
+		BasicCompactColor(ModelEnum model, T ch1, T ch2, T ch3);
+		BasicCompactColor(const RgbColor& rgb);
+		BasicCompactColor(const HsvColor& hsv);
+		BasicCompactColor(const XyzColor& xyz);
+		BasicCompactColor(const LabColor& lab);
+
+		ModelEnum GetModel() const noexcept;
+		// the stored triple, in GetModel() order
+		T GetCh1() const noexcept;
+		T GetCh2() const noexcept;
+		T GetCh3() const noexcept;
+
+		RgbColor GetRGB() const;
+		HsvColor GetHSV() const;
+		XyzColor GetXYZ() const;
+		LabColor GetLAB() const;
+	};
+
+	typedef BasicCompactColor<> CompactColor;
+
+	static_assert(sizeof(BasicCompactColor<float>) == 16, "BasicCompactColor<float> must stay 16 bytes");
+	static_assert(sizeof(BasicCompactColor<double>) == 32, "BasicCompactColor<double> must stay 32 bytes");
+	static_assert(sizeof(BasicRgbColor<float>) == 4 * sizeof(float), "no double in the float colors");
+	static_assert(std::is_trivially_copyable<BasicCompactColor<float>>::value, "memcpy-able arrays");
+	static_assert(std::is_trivially_copyable<BasicCompactColor<double>>::value, "memcpy-able arrays");
+	static_assert(std::is_trivially_copyable<RgbColor>::value && std::is_trivially_copyable<HsvColor>::value
+		&& std::is_trivially_copyable<XyzColor>::value && std::is_trivially_copyable<LabColor>::value
+		&& std::is_trivially_copyable<Color>::value, "memcpy-able arrays");
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,728 @@
+#include "ColorBatch.h"
+#include "ColorImage.h"
+#include "ColorPlan.h"
+#include "ColorPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace COLORNS
+{
+	// bytes read from the input per pass
+	constexpr size_t kBatchReadSize = 1 << 20;
+	// longest text output per color: 3 fields of sign, 20 digits, point, 9 digits, separator
+	constexpr size_t kBatchMaxRowText = 3 * 32;
+
+	const char* GetBatchUsage()
+	{
+		return "usage: ColorCalc --from rgb|hsv|xyz|lab --to rgb|hsv|xyz|lab [--in file|-] [--out file|-]\n"
+			"\t[--format csv|tsv|bin|ppm8|ppm16|pfm] [--accuracy exact|high|display8] [--precision 0..9]\n"
+			"       ColorCalc --in image --diff image [--out map.pfm] [--delta 76|94|2000] [--threshold value]\n"
+			"\t[--accuracy exact|high|display8]\n"
+			"       ColorCalc --help|-h\n"
+			"without arguments ColorCalc asks for one color interactively\n";
+	}
+
+	namespace
+	{
+		bool ParseModelName(const std::string& name, ModelEnum& model)
+		{
+			if (name == "rgb")
+				model = ModelEnum::Rgb;
+			else if (name == "hsv")
+				model = ModelEnum::Hsv;
+			else if (name == "xyz")
+				model = ModelEnum::Xyz;
+			else if (name == "lab")
+				model = ModelEnum::Lab;
+			else
+				return false;
+			return true;
+		}
+	}
+
+	bool ParseBatchArgs(int argc, char* argv[], BatchOptions& options, std::string& error)
+	{
+		bool from = false;
+		bool to = false;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--help" || arg == "-h")
+			{
+				options.Help = true;
+				return true;
+			}
+			if (i + 1 >= argc)
+			{
+				error = "missing value for " + arg;
+				return false;
+			}
+			const std::string value = argv[++i];
+			bool ok = true;
+			if (arg == "--from")
+				ok = from = ParseModelName(value, options.From);
+			else if (arg == "--to")
+				ok = to = ParseModelName(value, options.To);
+			else if (arg == "--in")
+				options.In = value;
+			else if (arg == "--out")
+				options.Out = value;
+			else if (arg == "--format")
+			{
+				if (value == "csv")
+					options.Format = BatchFormatEnum::Csv;
+				else if (value == "tsv")
+					options.Format = BatchFormatEnum::Tsv;
+				else if (value == "bin")
+					options.Format = BatchFormatEnum::Binary;
+				else if (value == "ppm8")
+					options.Format = BatchFormatEnum::Ppm8;
+				else if (value == "ppm16")
+					options.Format = BatchFormatEnum::Ppm16;
+				else if (value == "pfm")
+					options.Format = BatchFormatEnum::Pfm;
+				else
+					ok = false;
+			}
+			else if (arg == "--accuracy")
+			{
+				if (value == "exact")
+					options.Accuracy = AccuracyEnum::Exact;
+				else if (value == "high")
+					options.Accuracy = AccuracyEnum::High;
+				else if (value == "display8")
+					options.Accuracy = AccuracyEnum::Display8;
+				else
+					ok = false;
+			}
+			else if (arg == "--diff")
+				options.Diff = value;
+			else if (arg == "--delta")
+			{
+				if (value == "76")
+					options.Delta = DeltaEEnum::CIE76;
+				else if (value == "94")
+					options.Delta = DeltaEEnum::CIE94;
+				else if (value == "2000")
+					options.Delta = DeltaEEnum::CIEDE2000;
+				else
+					ok = false;
+			}
+			else if (arg == "--threshold")
+			{
+				char* end = nullptr;
+				const double threshold = strtod(value.c_str(), &end);
+				ok = *end == '\0' && threshold >= 0.0;
+				if (ok)
+					options.Threshold = static_cast<float>(threshold);
+			}
+			else if (arg == "--precision")
+			{
+				char* end = nullptr;
+				const long precision = strtol(value.c_str(), &end, 10);
+				ok = *end == '\0' && precision >= 0 && precision <= 9;
+				if (ok)
+					options.Precision = static_cast<int>(precision);
+			}
+			else
+			{
+				error = "unknown option " + arg;
+				return false;
+			}
+			if (!ok)
+			{
+				error = "bad value for " + arg + ": " + value;
+				return false;
+			}
+		}
+		if (!options.Diff.empty())
+		{
+			if (options.In == "-")
+			{
+				error = "--diff needs an --in image";
+				return false;
+			}
+			return true;
+		}
+		if (!from || !to)
+		{
+			error = "--from and --to are required";
+			return false;
+		}
+		return true;
+	}
+
+	namespace
+	{
+		// Plain decimal numbers ([+-]digits[.digits][e[+-]digits]) are parsed here,
+		// anything else (inf, nan, hex, more than 22 powers of ten) by strtod.
+		// On success p points past the number.
+		bool ParseBatchNumber(const char*& p, double& value)
+		{
+			static const double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+				1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+			const char* s = p;
+			const bool negative = (*s == '-');
+			if (*s == '-' || *s == '+')
+				++s;
+			uint64_t mantissa = 0;
+			int digits = 0;
+			int exponent = 0;
+			bool any = false;
+			for (; *s >= '0' && *s <= '9'; ++s, any = true)
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<unsigned>(*s - '0');
+					if (mantissa)
+						++digits;
+				}
+				else
+				{
+					++exponent;
+				}
+			}
+			if (*s == '.')
+			{
+				for (++s; *s >= '0' && *s <= '9'; ++s, any = true)
+				{
+					if (digits < 19)
+					{
+						mantissa = mantissa * 10 + static_cast<unsigned>(*s - '0');
+						if (mantissa)
+							++digits;
+						--exponent;
+					}
+				}
+			}
+			bool fast = any;
+			if (fast && (*s == 'e' || *s == 'E'))
+			{
+				const char* e = s + 1;
+				const bool minus = (*e == '-');
+				if (*e == '-' || *e == '+')
+					++e;
+				int scale = 0;
+				fast = (*e >= '0' && *e <= '9');
+				for (; *e >= '0' && *e <= '9'; ++e)
+					scale = (scale < 1000) ? scale * 10 + (*e - '0') : scale;
+				exponent += minus ? -scale : scale;
+				s = e;
+			}
+			if (fast && exponent >= -22 && exponent <= 22)
+			{
+				double v = static_cast<double>(mantissa);
+				v = (exponent < 0) ? v / kPow10[-exponent] : v * kPow10[exponent];
+				value = negative ? -v : v;
+				p = s;
+				return true;
+			}
+
+			char* end = nullptr;
+			value = strtod(p, &end);
+			if (end == p)
+				return false;
+			p = end;
+			return true;
+		}
+
+		// one line (NUL terminated) of three separated numbers, blanks around them allowed
+		bool ParseBatchLine(const char* p, char separator, float c[3])
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				while (*p == ' ' || (*p == '\t' && separator != '\t'))
+					++p;
+				double value;
+				if (!ParseBatchNumber(p, value))
+					return false;
+				c[i] = static_cast<float>(value);
+				while (*p == ' ' || (*p == '\t' && separator != '\t'))
+					++p;
+				if (i < 2)
+				{
+					if (*p != separator)
+						return false;
+					++p;
+				}
+			}
+			while (*p == ' ' || *p == '\t' || *p == '\r')
+				++p;
+			return *p == '\0';
+		}
+
+		// fixed point with precision digits after the point, trailing zeros dropped
+		char* FormatBatchNumber(char* out, float v, int precision)
+		{
+			static const int64_t kScale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+				10000000, 100000000, 1000000000 };
+
+			if (v != v)
+			{
+				memcpy(out, "nan", 3);
+				return out + 3;
+			}
+			const double d = v;
+			if (std::fabs(d) >= 1e9)
+				return out + snprintf(out, kBatchMaxRowText / 3, "%.*g", precision + 1, d);
+			const int64_t scale = kScale[precision];
+			const int64_t scaled = static_cast<int64_t>(std::fabs(d) * static_cast<double>(scale) + 0.5);
+			if (d < 0 && scaled)
+				*out++ = '-';
+			int64_t whole = scaled / scale;
+			int64_t fraction = scaled % scale;
+
+			char digits[24];
+			int count = 0;
+			do
+			{
+				digits[count++] = static_cast<char>('0' + whole % 10);
+				whole /= 10;
+			} while (whole);
+			while (count)
+				*out++ = digits[--count];
+
+			if (fraction)
+			{
+				*out++ = '.';
+				int width = precision;
+				while (fraction % 10 == 0)
+				{
+					fraction /= 10;
+					--width;
+				}
+				for (int i = width - 1; i >= 0; --i)
+				{
+					out[i] = static_cast<char>('0' + fraction % 10);
+					fraction /= 10;
+				}
+				out += width;
+			}
+			return out;
+		}
+
+		// one chunk of parsed rows: convert, mark the rejected ones, write
+		class BatchWriter
+		{
+			const BatchOptions& m_options;
+			const ConversionPlan m_plan;
+			std::ostream& m_out;
+			float m_lo[3];
+			float m_hi[3];
+			std::vector<float> m_colors;
+			std::vector<unsigned char> m_valid;
+			std::vector<char> m_text;
+			size_t m_rows{ 0 };
+			size_t m_total{ 0 };
+			size_t m_rejected{ 0 };
+		public:
+			BatchWriter(const BatchOptions& options, std::ostream& out) :
+				m_options(options), m_plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford, options.Accuracy),
+				m_out(out), m_colors(kBatchRows * 3), m_valid(kBatchRows), m_text(kBatchRows * kBatchMaxRowText)
+			{
+				GetModelRange(options.From, m_lo, m_hi);
+			}
+
+			size_t GetTotal() const noexcept
+			{
+				return m_total;
+			}
+
+			size_t GetRejected() const noexcept
+			{
+				return m_rejected;
+			}
+
+			// a parsed row (c) or a row that didn't parse (nullptr); where is the line
+			// or record number for the message
+			void Add(const float* c, size_t where)
+			{
+				float* dst = &m_colors[m_rows * 3];
+				bool valid = (c != nullptr);
+				if (valid)
+				{
+					for (int i = 0; i < 3; ++i)
+					{
+						// !(a <= b) catches NaN
+						if (!(c[i] >= m_lo[i] && c[i] <= m_hi[i]))
+						{
+							std::cerr << ((m_options.Format == BatchFormatEnum::Binary) ? "record " : "line ")
+								<< where << ": channel " << (i + 1) << " value " << c[i]
+								<< " out of range [" << m_lo[i] << ", " << m_hi[i] << "]\n";
+							valid = false;
+							break;
+						}
+					}
+				}
+				else
+				{
+					std::cerr << "line " << where << ": expected three numbers\n";
+				}
+				if (valid)
+				{
+					dst[0] = c[0];
+					dst[1] = c[1];
+					dst[2] = c[2];
+				}
+				else
+				{
+					dst[0] = dst[1] = dst[2] = 0.0f;
+					++m_rejected;
+				}
+				m_valid[m_rows++] = valid ? 1 : 0;
+				++m_total;
+				if (m_rows == kBatchRows)
+					Flush();
+			}
+
+			void Flush()
+			{
+				if (m_rows == 0)
+					return;
+				float* colors = m_colors.data();
+				ConvertBuffer(m_plan, m_options.From, m_options.To, colors, colors, m_rows);
+				const float nan = std::numeric_limits<float>::quiet_NaN();
+				for (size_t i = 0; i < m_rows; ++i)
+					if (!m_valid[i])
+						colors[i * 3] = colors[i * 3 + 1] = colors[i * 3 + 2] = nan;
+
+				if (m_options.Format == BatchFormatEnum::Binary)
+				{
+					m_out.write(reinterpret_cast<const char*>(colors), static_cast<std::streamsize>(m_rows * 3 * sizeof(float)));
+				}
+				else
+				{
+					const char separator = (m_options.Format == BatchFormatEnum::Tsv) ? '\t' : ',';
+					char* text = m_text.data();
+					for (size_t i = 0; i < m_rows * 3; i += 3)
+					{
+						text = FormatBatchNumber(text, colors[i], m_options.Precision);
+						*text++ = separator;
+						text = FormatBatchNumber(text, colors[i + 1], m_options.Precision);
+						*text++ = separator;
+						text = FormatBatchNumber(text, colors[i + 2], m_options.Precision);
+						*text++ = '\n';
+					}
+					m_out.write(m_text.data(), text - m_text.data());
+				}
+				m_rows = 0;
+			}
+		};
+
+		void ReadBatchText(std::istream& in, char separator, BatchWriter& writer)
+		{
+			std::vector<char> buffer(kBatchReadSize + 1);
+			char* data = buffer.data();
+			size_t have = 0;
+			size_t line = 0;
+			bool skipping = false;	// inside a line longer than the buffer
+			bool eof = false;
+			while (!eof || have)
+			{
+				if (!eof)
+				{
+					in.read(data + have, static_cast<std::streamsize>(kBatchReadSize - have));
+					have += static_cast<size_t>(in.gcount());
+					eof = !in;
+				}
+
+				size_t start = 0;
+				for (;;)
+				{
+					char* begin = data + start;
+					char* end = static_cast<char*>(memchr(begin, '\n', have - start));
+					if (!end)
+					{
+						if (!eof || start == have)
+							break;
+						end = data + have;	// last line without a newline
+					}
+					*end = '\0';
+					start = (end == data + have) ? have : static_cast<size_t>(end - data) + 1;
+					++line;
+					if (skipping)
+					{
+						skipping = false;
+						continue;
+					}
+					const char* p = begin;
+					while (*p == ' ' || *p == '\t' || *p == '\r')
+						++p;
+					if (*p == '\0' || *p == '#')
+						continue;
+					float c[3];
+					writer.Add(ParseBatchLine(p, separator, c) ? c : nullptr, line);
+				}
+
+				if (start == 0 && have == kBatchReadSize)
+				{
+					// no newline in a full buffer: reject the line once and drop the rest of it
+					if (!skipping)
+						writer.Add(nullptr, line + 1);
+					skipping = true;
+					have = 0;
+					continue;
+				}
+				memmove(data, data + start, have - start);
+				have -= start;
+			}
+		}
+
+		// false when the input ends inside a record
+		bool ReadBatchBinary(std::istream& in, BatchWriter& writer)
+		{
+			std::vector<float> colors(kBatchRows * 3);
+			const size_t bytes = colors.size() * sizeof(float);
+			size_t record = 0;
+			for (;;)
+			{
+				in.read(reinterpret_cast<char*>(colors.data()), static_cast<std::streamsize>(bytes));
+				const size_t got = static_cast<size_t>(in.gcount());
+				const size_t rows = got / (3 * sizeof(float));
+				for (size_t i = 0; i < rows; ++i)
+					writer.Add(&colors[i * 3], ++record);
+				if (got % (3 * sizeof(float)))
+				{
+					std::cerr << "record " << record + 1 << ": truncated, " << got % (3 * sizeof(float)) << " trailing bytes ignored\n";
+					return false;
+				}
+				if (!in)
+					return true;
+			}
+		}
+
+		int RunBatchImage(const BatchOptions& options)
+		{
+			if (options.In == "-" || options.Out == "-")
+			{
+				std::cerr << "image formats need --in and --out files\n";
+				return 2;
+			}
+			const ImageFormatEnum format = (options.Format == BatchFormatEnum::Ppm8) ? ImageFormatEnum::Ppm8
+				: ((options.Format == BatchFormatEnum::Ppm16) ? ImageFormatEnum::Ppm16 : ImageFormatEnum::Pfm);
+			const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford, options.Accuracy);
+			std::string error;
+			if (!ConvertImage(GetDefaultPool(), plan, options.In, options.From, options.Out, options.To, format, error))
+			{
+				std::cerr << error << "\n";
+				return 2;
+			}
+			return 0;
+		}
+
+		// one input of the image diff: mapped, and decoded to top-down RGB floats unless
+		// the mapped pixels can go to DiffImages as they are
+		typedef struct _DiffSource
+		{
+			MappedFile File;
+			ImageInfo Info;
+			std::vector<float> Decoded;
+			const unsigned char* Pixels{ nullptr };
+		} DiffSource;
+
+		bool OpenDiffSource(const std::string& path, DiffSource& source, std::string& error)
+		{
+			if (!source.File.OpenRead(path))
+			{
+				error = "can't open " + path;
+				return false;
+			}
+			if (!ReadImageHeader(source.File.GetData(), source.File.GetSize(), source.Info, error))
+			{
+				error = path + ": " + error;
+				return false;
+			}
+			source.Pixels = source.File.GetData() + source.Info.DataOffset;
+			return true;
+		}
+
+		bool IsDiffCodes(const ImageInfo& info)
+		{
+			return info.Format == ImageFormatEnum::Ppm8 && info.MaxValue == 255;
+		}
+
+		bool IsDiffFloats(const DiffSource& source)
+		{
+			return source.Info.Format == ImageFormatEnum::Pfm && source.Info.BigEndian == IsBigEndianHost()
+				&& reinterpret_cast<uintptr_t>(source.Pixels) % alignof(float) == 0;
+		}
+
+		// RGB in [0, 1], rows top to bottom
+		void DecodeDiffSource(DiffSource& source)
+		{
+			const ImageInfo& info = source.Info;
+			const size_t row = info.Width * 3;
+			source.Decoded.resize(row * info.Height);
+			for (size_t y = 0; y < info.Height; ++y)
+			{
+				const bool pfm = (info.Format == ImageFormatEnum::Pfm);
+				const unsigned char* src = source.Pixels + (pfm ? info.Height - 1 - y : y) * row * ImageSampleSize(info.Format);
+				float* dst = source.Decoded.data() + y * row;
+				for (size_t i = 0; i < row; ++i)
+				{
+					if (pfm)
+					{
+						unsigned char b[4];
+						memcpy(b, src + i * 4, 4);
+						if (info.BigEndian != IsBigEndianHost())
+						{
+							unsigned char t = b[0]; b[0] = b[3]; b[3] = t;
+							t = b[1]; b[1] = b[2]; b[2] = t;
+						}
+						memcpy(&dst[i], b, 4);
+					}
+					else
+					{
+						const unsigned code = (info.Format == ImageFormatEnum::Ppm16) ? ((src[i * 2] << 8) | src[i * 2 + 1]) : src[i];
+						dst[i] = static_cast<float>(code > info.MaxValue ? info.MaxValue : code) / info.MaxValue;
+					}
+				}
+			}
+		}
+
+		int RunBatchDiff(const BatchOptions& options)
+		{
+			DiffSource first, second;
+			std::string error;
+			if (!OpenDiffSource(options.In, first, error) || !OpenDiffSource(options.Diff, second, error))
+			{
+				std::cerr << error << "\n";
+				return 2;
+			}
+			const size_t width = first.Info.Width;
+			const size_t height = first.Info.Height;
+			if (second.Info.Width != width || second.Info.Height != height)
+			{
+				std::cerr << options.In << " and " << options.Diff << " differ in size\n";
+				return 2;
+			}
+
+			// both 8-bit P6 or both native PF go to DiffImages straight from the mapping,
+			// anything else is decoded first; PF rows stay bottom to top only in the mapping
+			const bool codes = IsDiffCodes(first.Info) && IsDiffCodes(second.Info);
+			const bool mapped = codes || (IsDiffFloats(first) && IsDiffFloats(second));
+			if (!mapped)
+			{
+				DecodeDiffSource(first);
+				DecodeDiffSource(second);
+			}
+			const bool bottomUp = mapped && !codes;
+
+			// Pf: the grayscale PFM, the same header layout as PF
+			MappedFile target;
+			float* map = nullptr;
+			if (options.Out != "-")
+			{
+				std::string header = MakeImageHeader(ImageFormatEnum::Pfm, width, height);
+				header[1] = 'f';
+				if (!target.Create(options.Out, header.size() + width * height * sizeof(float)))
+				{
+					std::cerr << "can't create " << options.Out << "\n";
+					return 2;
+				}
+				memcpy(target.GetData(), header.data(), header.size());
+				map = reinterpret_cast<float*>(target.GetData() + header.size());
+			}
+
+			const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford, options.Accuracy);
+			const size_t n = width * height;
+			DiffStats stats;
+			if (codes)
+				stats = DiffImages(GetDefaultPool(), plan, options.Delta, first.Pixels, second.Pixels, map, n, options.Threshold);
+			else if (mapped)
+				stats = DiffImages(GetDefaultPool(), plan, options.Delta, reinterpret_cast<const float*>(first.Pixels),
+					reinterpret_cast<const float*>(second.Pixels), map, n, options.Threshold);
+			else
+				stats = DiffImages(GetDefaultPool(), plan, options.Delta, first.Decoded.data(), second.Decoded.data(),
+					map, n, options.Threshold);
+
+			if (map && !bottomUp)
+			{
+				for (size_t y = 0; y < height / 2; ++y)
+					std::swap_ranges(map + y * width, map + (y + 1) * width, map + (height - 1 - y) * width);
+			}
+
+			const size_t maxRow = stats.MaxIndex / width;
+			std::cout << "pixels " << stats.Pixels << "\n"
+				<< "mean " << stats.Mean << "\n"
+				<< "rms " << stats.Rms << "\n"
+				<< "p95 " << stats.P95 << "\n"
+				<< "max " << stats.Max << " at " << stats.MaxIndex % width << "," << (bottomUp ? height - 1 - maxRow : maxRow) << "\n"
+				<< "over " << stats.Over << " (threshold " << options.Threshold << ")\n";
+			return stats.Over ? 1 : 0;
+		}
+	}
+
+	int RunBatch(const BatchOptions& options)
+	{
+		if (!options.Diff.empty())
+			return RunBatchDiff(options);
+		if (options.Format == BatchFormatEnum::Ppm8 || options.Format == BatchFormatEnum::Ppm16
+			|| options.Format == BatchFormatEnum::Pfm)
+			return RunBatchImage(options);
+
+		const bool binary = (options.Format == BatchFormatEnum::Binary);
+		std::ios::sync_with_stdio(false);
+#ifdef _WIN32
+		if (binary && options.In == "-")
+			_setmode(_fileno(stdin), _O_BINARY);
+		if (binary && options.Out == "-")
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+		std::ifstream inFile;
+		std::ofstream outFile;
+		if (options.In != "-")
+		{
+			inFile.open(options.In, std::ios::binary);
+			if (!inFile)
+			{
+				std::cerr << "can't open " << options.In << "\n";
+				return 2;
+			}
+		}
+		if (options.Out != "-")
+		{
+			outFile.open(options.Out, binary ? std::ios::binary : std::ios::out);
+			if (!outFile)
+			{
+				std::cerr << "can't create " << options.Out << "\n";
+				return 2;
+			}
+		}
+		std::istream& in = (options.In != "-") ? static_cast<std::istream&>(inFile) : std::cin;
+		std::ostream& out = (options.Out != "-") ? static_cast<std::ostream&>(outFile) : std::cout;
+
+		BatchWriter writer(options, out);
+		bool complete = true;
+		if (binary)
+			complete = ReadBatchBinary(in, writer);
+		else
+			ReadBatchText(in, (options.Format == BatchFormatEnum::Tsv) ? '\t' : ',', writer);
+		writer.Flush();
+		out.flush();
+
+		if (in.bad() || !out)
+		{
+			std::cerr << "I/O error\n";
+			return 2;
+		}
+		std::cerr << writer.GetTotal() << " rows, " << writer.GetRejected() << " rejected\n";
+		return (writer.GetRejected() || !complete) ? 1 : 0;
+	}
+};
@@ -0,0 +1,65 @@
+#ifndef _COLORBATCH_H_
+#define _COLORBATCH_H_
+
+#include "ColorBuffer.h"
+#include "ColorCompand.h"
+#include "ColorDelta.h"
+
+#include <string>
+
+namespace COLORNS
+{
+	enum class BatchFormatEnum
+	{
+		Csv = 0,		// one color per line, "c1,c2,c3"
+		Tsv = 1,		// the same with tabs
+		Binary = 2,		// raw float32 triples, native byte order
+		Ppm8 = 3,		// images, see ConvertImage: the input's P6 or PF header is read,
+		Ppm16 = 4,		// the output is written as 8-bit P6, 16-bit P6 or PF
+		Pfm = 5
+	};
+
+	typedef struct _BatchOptions
+	{
+		ModelEnum From{ ModelEnum::Rgb };
+		ModelEnum To{ ModelEnum::Lab };
+		BatchFormatEnum Format{ BatchFormatEnum::Csv };
+		AccuracyEnum Accuracy{ AccuracyEnum::Exact };
+		int Precision{ 6 };		// digits after the point in text output, 0..9
+		std::string In{ "-" };	// file name or "-" for stdin
+		std::string Out{ "-" };	// file name or "-" for stdout
+		std::string Diff;		// image diff: the image compared with In
+		DeltaEEnum Delta{ DeltaEEnum::CIEDE2000 };
+		float Threshold{ 1.0f };	// image diff: pixels above it fail
+		bool Help{ false };			// --help or -h: print GetBatchUsage() and exit 0
+	} BatchOptions;
+
+	// usage text for the command line below
+	const char* GetBatchUsage();
+
+	// ColorCalc --from rgb|hsv|xyz|lab --to rgb|hsv|xyz|lab [--in file|-] [--out file|-]
+	//	[--format csv|tsv|bin|ppm8|ppm16|pfm] [--accuracy exact|high|display8] [--precision 0..9]
+	// ColorCalc --in image --diff image [--out map.pfm] [--delta 76|94|2000] [--threshold value]
+	//	[--accuracy exact|high|display8]
+	// ColorCalc --help|-h sets Help, the other arguments are then ignored
+	// false with a message in error on a bad argument
+	bool ParseBatchArgs(int argc, char* argv[], BatchOptions& options, std::string& error);
+
+	// Streams In to Out in chunks of kBatchRows colors, memory use does not depend on
+	// the input size. Text lines that are empty or start with '#' are skipped.
+	// Rows that don't parse or fall outside GetModelRange(From) are reported on stderr
+	// with their line (record for Binary) number and written as nan so the output keeps
+	// one row per input row.
+	// The image formats need file names for In and Out and convert the whole image
+	// through memory-mapped files, without the per-row checks.
+	// Returns the exit code: 0 all rows converted, 1 some rows rejected (or a truncated
+	// binary record), 2 I/O error.
+	// With Diff set the two RGB images (P6 or PF, same size) are compared instead, see
+	// DiffImages: the statistics go to stdout, the difference map to Out as a grayscale
+	// PFM ("Pf") unless Out is "-". Exit code 1 when some pixels are above Threshold.
+	int RunBatch(const BatchOptions& options);
+
+	constexpr size_t kBatchRows = 4096;
+};
+
+#endif
@@ -0,0 +1,2288 @@
+#include "Color.h"
+#include "ColorBuffer.h"
+#include "ColorCache.h"
+#include "ColorConstexpr.h"
+#include "ColorDelta.h"
+#include "ColorGamut.h"
+#include "ColorGraph.h"
+#include "ColorLut.h"
+#include "ColorPalette.h"
+#include "ColorPlan.h"
+#include "ColorPool.h"
+#include "ColorRegistry.h"
+#include "ColorSimd.h"
+#include "ColorSpectral.h"
+#include "ColorTemperature.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace COLORNS;
+
+// colorcalc_bench [--quick] [--verify] [--filter text] [--min-time ms] [--out file]
+// Times every conversion edge and prints one JSON document (stdout or --out).
+// Each case repeats its batch until --min-time has passed (20 ms, --quick: one pass)
+// and reports the average; progress goes to stderr. With 4 or more hardware threads
+// the pool case checks its efficiency up to half of them and exits with 1 under it.
+// --verify instead sweeps grids of inputs through every fast path (compand
+// approximations and tables, the Lab kernels, the SIMD levels, ConvertBuffer tiers,
+// the color differences, Lut3D, PaletteIndex, ExtractPalette, GamutMap, ConversionCache,
+// the constexpr conversions, the conversion graph and Color, SpectralTable, the CCT,
+// the color space registry)
+// against the double reference functions, times ConvertBuffer against its declared
+// Mpix/s floors and exits with 1 if any path exceeds its tolerance or runs under its floor.
+
+namespace
+{
+	const size_t kBatches[] = { 256, 16384, 1 << 20 };
+	// the frame of the thread scaling cases
+	constexpr size_t kFrameWidth = 6000;
+	constexpr size_t kFrameHeight = 4000;
+	// Parallel efficiency the tiled ConvertBuffer is expected to hold up to the physical
+	// core count: the tiles share nothing, the loss is the pool's hand-off and the memory
+	// bandwidth of the frame (576 MB in and out). SMT threads past the cores add less, so
+	// only the runs up to half the hardware threads are checked against it.
+	constexpr double kPoolExpectedEfficiency = 0.85;
+
+	const char* const kRgbNames[kRgbModelCount] = { "AdobeRgb", "AppleRgb", "BestRgb", "BetaRgb",
+		"BruceRgb", "CieRgb", "ColorMatchRgb", "DonRgb4", "EciRgb2", "EktaSpacePS5", "NtscRgb",
+		"PalSecamRgb", "ProPhotoRgb", "SmpteCRgb", "sRGB", "WideGamutRgb" };
+	const char* const kAdaptationNames[] = { "bradford", "vonkries", "none" };
+	const char* const kAccuracyNames[] = { "exact", "high", "display8" };
+	const char* const kSimdNames[] = { "scalar", "sse4.2", "avx2", "avx512" };
+
+	typedef struct _BenchCase
+	{
+		std::string Name;
+		std::string Space{ "-" };		// RgbEnum name, "-" when the edge doesn't use one
+		std::string Adaptation{ "-" };
+		std::string Accuracy{ "-" };
+		size_t Batch{ 0 };
+		unsigned Threads{ 1 };
+		size_t Iterations{ 0 };
+		double NsPerPixel{ 0.0 };
+		double BytesPerPixel{ 0.0 };	// input read per pixel, 0 when the case doesn't report GB/s
+		// thread scaling cases: against the same case on one thread, 0 for the others
+		double Speedup{ 0.0 };
+		double Efficiency{ 0.0 };		// Speedup / Threads
+		double ExpectedEfficiency{ 0.0 };
+		bool ScalingChecked{ false };	// Efficiency was checked against ExpectedEfficiency
+	} BenchCase;
+
+	// ULP distance buckets: 0, 1, 2-4, 5-16, 17-256, 257-65536, more
+	constexpr int kUlpBuckets = 7;
+	// double results of paths with a looser abs tolerance (the approximation tiers) are
+	// millions of double ULPs off: those count float ULPs against the rounded reference
+	constexpr double kDoubleUlpTolerance = 1e-9;
+	const char* const kUlpNames[kUlpBuckets] = { "0", "1", "2-4", "5-16", "17-256", "257-65536", "more" };
+
+	// error of one fast path against the reference over a sweep
+	typedef struct _AccuracyCase
+	{
+		std::string Name;
+		std::string Metric;			// what Tolerance bounds: "abs" or "de2000"
+		double Tolerance{ 0.0 };
+		size_t Samples{ 0 };
+		double MaxAbs{ 0.0 };
+		double MaxDeltaE{ 0.0 };	// 0 for paths not ending in Lab, RGB or XYZ
+		bool FloatUlps{ true };		// Ulps counts float ULPs, else double ones
+		size_t Ulps[kUlpBuckets]{};
+	} AccuracyCase;
+
+	// best throughput of one path against its declared floor
+	typedef struct _ThroughputCase
+	{
+		std::string Name;
+		size_t Batch{ 0 };
+		double Floor{ 0.0 };		// Mpix/s
+		double MpixPerS{ 0.0 };
+	} ThroughputCase;
+
+	typedef struct _BenchOptions
+	{
+		double MinTime{ 0.02 };		// seconds per case
+		bool Verify{ false };
+		std::string Filter;
+		std::string Out{ "-" };
+	} BenchOptions;
+
+	// results go here so the compiler can't drop the work
+	volatile double g_sink = 0.0;
+
+	// deterministic inputs in [lo, hi) per channel
+	std::vector<double> MakeInput(size_t n, const double lo[3], const double hi[3])
+	{
+		std::vector<double> v(n * 3);
+		uint32_t state = 0x12345678u;
+		for (size_t i = 0; i < v.size(); ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			const size_t c = i % 3;
+			v[i] = lo[c] + (hi[c] - lo[c]) * ((state >> 8) * (1.0 / 16777216.0));
+		}
+		return v;
+	}
+
+	int64_t OrderedBits(double v)
+	{
+		int64_t bits;
+		memcpy(&bits, &v, sizeof(bits));
+		return (bits < 0) ? INT64_MIN - bits : bits;
+	}
+
+	int32_t OrderedBits(float v)
+	{
+		int32_t bits;
+		memcpy(&bits, &v, sizeof(bits));
+		return (bits < 0) ? INT32_MIN - bits : bits;
+	}
+
+	int UlpBucket(uint64_t ulps)
+	{
+		return (ulps == 0) ? 0 : (ulps == 1) ? 1 : (ulps <= 4) ? 2 : (ulps <= 16) ? 3
+			: (ulps <= 256) ? 4 : (ulps <= 65536) ? 5 : 6;
+	}
+
+	// collects the errors of one path
+	class AccuracyCheck
+	{
+		AccuracyCase m_case;
+
+		void AddAbs(double error)
+		{
+			++m_case.Samples;
+			if (!(error <= m_case.MaxAbs))
+				m_case.MaxAbs = std::isnan(error) ? INFINITY : error;
+		}
+
+		void AddFloatUlps(float value, double reference)
+		{
+			const int32_t a = OrderedBits(value), b = OrderedBits(static_cast<float>(reference));
+			++m_case.Ulps[(value != value) ? kUlpBuckets - 1
+				: UlpBucket((a > b) ? uint64_t(int64_t(a) - b) : uint64_t(int64_t(b) - a))];
+		}
+	public:
+		AccuracyCheck(const std::string& name, const char* metric, double tolerance)
+		{
+			m_case.Name = name;
+			m_case.Metric = metric;
+			m_case.Tolerance = tolerance;
+			m_case.FloatUlps = m_case.Metric != "abs" || tolerance > kDoubleUlpTolerance;
+		}
+
+		// a double result, ULPs in double for the tight paths, else in float against the
+		// reference rounded to float
+		void Add(double value, double reference)
+		{
+			AddAbs(std::fabs(value - reference));
+			if (m_case.FloatUlps)
+			{
+				AddFloatUlps(static_cast<float>(value), reference);
+				return;
+			}
+			const int64_t a = OrderedBits(value), b = OrderedBits(reference);
+			++m_case.Ulps[(value != value) ? kUlpBuckets - 1
+				: UlpBucket((a > b) ? uint64_t(a) - uint64_t(b) : uint64_t(b) - uint64_t(a))];
+		}
+
+		// a float result, ULPs against the reference rounded to float
+		void Add(float value, double reference)
+		{
+			AddAbs(std::fabs(value - reference));
+			AddFloatUlps(value, reference);
+		}
+
+		void AddDeltaE(double de)
+		{
+			if (!(de <= m_case.MaxDeltaE))
+				m_case.MaxDeltaE = std::isnan(de) ? INFINITY : de;
+		}
+
+		const AccuracyCase& GetCase() const noexcept
+		{
+			return m_case;
+		}
+	};
+
+	class Bench
+	{
+		const BenchOptions& m_options;
+		std::vector<BenchCase> m_cases;
+		std::vector<AccuracyCase> m_accuracy;
+		std::vector<ThroughputCase> m_throughput;
+		bool m_failed{ false };
+	public:
+		explicit Bench(const BenchOptions& options) : m_options(options) {}
+
+		bool IsSelected(const std::string& name) const
+		{
+			return m_options.Filter.empty() || name.find(m_options.Filter) != std::string::npos;
+		}
+
+		bool IsFailed() const noexcept
+		{
+			return m_failed;
+		}
+
+		// records the sweep and checks it against its tolerance
+		void Check(const AccuracyCheck& check)
+		{
+			const AccuracyCase& c = check.GetCase();
+			if (!IsSelected(c.Name))
+				return;
+			const double error = (c.Metric == "abs") ? c.MaxAbs : c.MaxDeltaE;
+			const bool passed = error <= c.Tolerance;
+			std::cerr << (passed ? "ok   " : "FAIL ") << c.Name << ": max abs " << c.MaxAbs
+				<< ", max dE2000 " << c.MaxDeltaE << ", " << c.Metric << " tolerance " << c.Tolerance << "\n";
+			m_failed = m_failed || !passed;
+			m_accuracy.push_back(c);
+		}
+
+		// a thread scaling run: fails when its efficiency is under the expected one
+		void CheckScaling(BenchCase& c)
+		{
+			c.ScalingChecked = true;
+			const bool passed = c.Efficiency >= c.ExpectedEfficiency;
+			std::cerr << (passed ? "ok   " : "FAIL ") << c.Name << " x" << c.Threads << ": efficiency "
+				<< c.Efficiency << ", expected " << c.ExpectedEfficiency << "\n";
+			m_failed = m_failed || !passed;
+		}
+
+		// times body (one pass over batch pixels) and checks the fastest of kThroughputPasses
+		// against floor; the best pass, not the mean, so a busy machine doesn't fail it
+		void CheckThroughput(const std::string& name, size_t batch, double floor, const std::function<void()>& body)
+		{
+			if (!IsSelected(name))
+				return;
+			typedef std::chrono::steady_clock clock;
+			const int kThroughputPasses = 5;
+			body();
+			double best = INFINITY;
+			for (int i = 0; i < kThroughputPasses; ++i)
+			{
+				const clock::time_point start = clock::now();
+				body();
+				best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+			}
+			ThroughputCase c;
+			c.Name = name;
+			c.Batch = batch;
+			c.Floor = floor;
+			c.MpixPerS = batch / best * 1e-6;
+			const bool passed = c.MpixPerS >= floor;
+			std::cerr << (passed ? "ok   " : "FAIL ") << name << ": " << c.MpixPerS << " Mpix/s, floor "
+				<< floor << "\n";
+			m_failed = m_failed || !passed;
+			m_throughput.push_back(c);
+		}
+
+		// runs body (one pass over c.Batch pixels) unless the filter skips the case;
+		// the recorded case, nullptr when skipped
+		BenchCase* Run(BenchCase c, const std::function<void()>& body)
+		{
+			if (!IsSelected(c.Name))
+				return nullptr;
+			typedef std::chrono::steady_clock clock;
+			body();		// warm up caches, tables and the pool
+			const clock::time_point start = clock::now();
+			double elapsed = 0.0;
+			do
+			{
+				body();
+				++c.Iterations;
+				elapsed = std::chrono::duration<double>(clock::now() - start).count();
+			} while (elapsed < m_options.MinTime);
+			c.NsPerPixel = elapsed * 1e9 / (static_cast<double>(c.Iterations) * c.Batch);
+			std::cerr << c.Name << " " << c.Space << " " << c.Adaptation << " " << c.Accuracy
+				<< " " << c.Batch << " x" << c.Threads << ": " << c.NsPerPixel << " ns/pixel\n";
+			m_cases.push_back(c);
+			return &m_cases.back();
+		}
+
+		void Write(std::ostream& out) const
+		{
+			out << "{\n\t\"benchmark\": \"colorcalc\",\n\t\"version\": 1,\n";
+			out << "\t\"simd\": \"" << kSimdNames[static_cast<int>(GetSimdSupport())] << "\",\n";
+			out << "\t\"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+			out << "\t\"results\": [";
+			for (size_t i = 0; i < m_cases.size(); ++i)
+			{
+				const BenchCase& c = m_cases[i];
+				out << (i ? ",\n" : "\n") << std::setprecision(6)
+					<< "\t\t{ \"name\": \"" << c.Name << "\", \"space\": \"" << c.Space
+					<< "\", \"adaptation\": \"" << c.Adaptation << "\", \"accuracy\": \"" << c.Accuracy
+					<< "\", \"batch\": " << c.Batch << ", \"threads\": " << c.Threads
+					<< ", \"iterations\": " << c.Iterations
+					<< ", \"ns_per_pixel\": " << c.NsPerPixel
+					<< ", \"mpix_per_s\": " << 1e3 / c.NsPerPixel;
+				if (c.BytesPerPixel > 0.0)
+					out << ", \"gb_per_s\": " << c.BytesPerPixel / c.NsPerPixel;
+				if (c.Speedup > 0.0)
+					out << ", \"speedup\": " << c.Speedup << ", \"efficiency\": " << c.Efficiency
+						<< ", \"expected_efficiency\": " << c.ExpectedEfficiency
+						<< ", \"scaling_checked\": " << (c.ScalingChecked ? "true" : "false");
+				out << " }";
+			}
+			out << "\n\t],\n\t\"accuracy\": [";
+			for (size_t i = 0; i < m_accuracy.size(); ++i)
+			{
+				const AccuracyCase& c = m_accuracy[i];
+				// JSON has no inf: a NaN result shows as 1e308
+				out << (i ? ",\n" : "\n") << std::setprecision(6)
+					<< "\t\t{ \"name\": \"" << c.Name << "\", \"metric\": \"" << c.Metric
+					<< "\", \"tolerance\": " << c.Tolerance << ", \"samples\": " << c.Samples
+					<< ", \"max_abs\": " << (std::isinf(c.MaxAbs) ? 1e308 : c.MaxAbs)
+					<< ", \"max_de2000\": " << (std::isinf(c.MaxDeltaE) ? 1e308 : c.MaxDeltaE)
+					<< ", \"passed\": " << (((c.Metric == "abs") ? c.MaxAbs : c.MaxDeltaE) <= c.Tolerance ? "true" : "false")
+					<< ", \"ulp_unit\": \"" << (c.FloatUlps ? "float" : "double") << "\", \"ulps\": {";
+				for (int b = 0; b < kUlpBuckets; ++b)
+					out << (b ? ", \"" : " \"") << kUlpNames[b] << "\": " << c.Ulps[b];
+				out << " } }";
+			}
+			out << "\n\t],\n\t\"throughput\": [";
+			for (size_t i = 0; i < m_throughput.size(); ++i)
+			{
+				const ThroughputCase& c = m_throughput[i];
+				out << (i ? ",\n" : "\n") << std::setprecision(6)
+					<< "\t\t{ \"name\": \"" << c.Name << "\", \"batch\": " << c.Batch
+					<< ", \"mpix_per_s\": " << c.MpixPerS << ", \"floor\": " << c.Floor
+					<< ", \"passed\": " << (c.MpixPerS >= c.Floor ? "true" : "false") << " }";
+			}
+			out << "\n\t]\n}\n";
+		}
+	};
+
+	const double kRgbLo[3] = { 0.0, 0.0, 0.0 };
+	const double kRgbHi[3] = { 1.0, 1.0, 1.0 };
+	const double kHsvHi[3] = { 360.0, 1.0, 1.0 };
+	const double kXyzHi[3] = { 0.95, 1.0, 0.82 };
+	const double kLabLo[3] = { 0.0, -100.0, -100.0 };
+	const double kLabHi[3] = { 100.0, 100.0, 100.0 };
+
+	// the scalar double functions of ColorSpace.h, one pixel per call
+	void BenchScalar(Bench& bench)
+	{
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		for (size_t batch : kBatches)
+		{
+			const std::vector<double> rgb = MakeInput(batch, kRgbLo, kRgbHi);
+			const std::vector<double> hsv = MakeInput(batch, kRgbLo, kHsvHi);
+			const std::vector<double> xyz = MakeInput(batch, kRgbLo, kXyzHi);
+			const std::vector<double> lab = MakeInput(batch, kLabLo, kLabHi);
+			std::vector<double> out(batch * 3);
+
+			BenchCase c;
+			c.Batch = batch;
+			c.Name = "rgb2hsv";
+			bench.Run(c, [&]()
+			{
+				for (size_t i = 0; i < batch * 3; i += 3)
+				{
+					double p, l;
+					GetHSPVL(rgb[i], rgb[i + 1], rgb[i + 2], out[i], out[i + 1], p, out[i + 2], l);
+				}
+				g_sink = g_sink + out[0];
+			});
+			c.Name = "hsv2rgb";
+			bench.Run(c, [&]()
+			{
+				for (size_t i = 0; i < batch * 3; i += 3)
+					GetRGBfromHSV(hsv[i], hsv[i + 1], hsv[i + 2], out[i], out[i + 1], out[i + 2]);
+				g_sink = g_sink + out[0];
+			});
+			c.Name = "xyz2lab";
+			bench.Run(c, [&]()
+			{
+				for (size_t i = 0; i < batch * 3; i += 3)
+					XYZ2Lab(xyz[i], xyz[i + 1], xyz[i + 2], white, out[i], out[i + 1], out[i + 2]);
+				g_sink = g_sink + out[0];
+			});
+			c.Name = "lab2xyz";
+			bench.Run(c, [&]()
+			{
+				for (size_t i = 0; i < batch * 3; i += 3)
+					Lab2XYZ(lab[i], lab[i + 1], lab[i + 2], white, out[i], out[i + 1], out[i + 2]);
+				g_sink = g_sink + out[0];
+			});
+
+			for (size_t s = 0; s < kRgbModelCount; ++s)
+			{
+				const RgbModel& model = GetRGBModel(static_cast<RgbEnum>(s));
+				for (int a = 0; a < 3; ++a)
+				{
+					const AdaptationEnum method = static_cast<AdaptationEnum>(a);
+					c.Space = kRgbNames[s];
+					c.Adaptation = kAdaptationNames[a];
+					c.Name = "rgb2xyz";
+					bench.Run(c, [&]()
+					{
+						for (size_t i = 0; i < batch * 3; i += 3)
+							RGB2XYZ(rgb[i], rgb[i + 1], rgb[i + 2], model.GammaRGB, model,
+								out[i], out[i + 1], out[i + 2], white, method);
+						g_sink = g_sink + out[0];
+					});
+					c.Name = "xyz2rgb";
+					bench.Run(c, [&]()
+					{
+						for (size_t i = 0; i < batch * 3; i += 3)
+							XYZ2RGB(xyz[i], xyz[i + 1], xyz[i + 2], white,
+								out[i], out[i + 1], out[i + 2], model.GammaRGB, model, method);
+						g_sink = g_sink + out[0];
+					});
+				}
+			}
+		}
+	}
+
+	// Color's lazy getters: every getter of a fresh RGB color, RGB -> Lab -> XYZ -> RGB,
+	// and the routes across the chain (HSV -> Lab, Lab -> HSV)
+	void BenchColor(Bench& bench)
+	{
+		for (size_t batch : kBatches)
+		{
+			const std::vector<double> rgb = MakeInput(batch, kRgbLo, kRgbHi);
+			const std::vector<double> hsv = MakeInput(batch, kRgbLo, kHsvHi);
+			const std::vector<double> lab = MakeInput(batch, kLabLo, kLabHi);
+			BenchCase c;
+			c.Batch = batch;
+			c.Space = "sRGB";
+			c.Adaptation = "bradford";
+			c.Name = "color_rgb_all";
+			bench.Run(c, [&]()
+			{
+				double sum = 0.0;
+				for (size_t i = 0; i < batch * 3; i += 3)
+				{
+					Color clr(RgbColor(rgb[i], rgb[i + 1], rgb[i + 2]));
+					sum += clr.GetHSV().GetHue() + clr.GetXYZ().GetY() + clr.GetLAB().GetL();
+				}
+				g_sink = g_sink + sum;
+			});
+			c.Name = "color_roundtrip";
+			bench.Run(c, [&]()
+			{
+				double sum = 0.0;
+				for (size_t i = 0; i < batch * 3; i += 3)
+				{
+					Color lab(Color(RgbColor(rgb[i], rgb[i + 1], rgb[i + 2])).GetLAB());
+					Color xyz(lab.GetXYZ());
+					sum += xyz.GetRGB().GetRed();
+				}
+				g_sink = g_sink + sum;
+			});
+			c.Name = "color_hsv2lab";
+			bench.Run(c, [&]()
+			{
+				double sum = 0.0;
+				for (size_t i = 0; i < batch * 3; i += 3)
+					sum += Color(HsvColor(hsv[i], hsv[i + 1], hsv[i + 2])).GetLAB().GetL();
+				g_sink = g_sink + sum;
+			});
+			c.Name = "color_lab2hsv";
+			bench.Run(c, [&]()
+			{
+				double sum = 0.0;
+				for (size_t i = 0; i < batch * 3; i += 3)
+					sum += Color(LabColor(lab[i], lab[i + 1], lab[i + 2])).GetHSV().GetHue();
+				g_sink = g_sink + sum;
+			});
+		}
+	}
+
+	// ConvertBuffer per accuracy, the uint8 path, the LUT and the pool scaling
+	void BenchBuffers(Bench& bench)
+	{
+		for (size_t batch : kBatches)
+		{
+			std::vector<float> rgb(batch * 3), lab(batch * 3), out(batch * 3);
+			std::vector<uint8_t> codes(batch * 3);
+			const std::vector<double> r = MakeInput(batch, kRgbLo, kRgbHi);
+			const std::vector<double> l = MakeInput(batch, kLabLo, kLabHi);
+			for (size_t i = 0; i < batch * 3; ++i)
+			{
+				rgb[i] = static_cast<float>(r[i]);
+				lab[i] = static_cast<float>(l[i]);
+				codes[i] = static_cast<uint8_t>(r[i] * 255.0);
+			}
+
+			// the second image of the diff: the codes reversed
+			const std::vector<uint8_t> codes2(codes.rbegin(), codes.rend());
+
+			BenchCase c;
+			c.Batch = batch;
+			c.Space = "sRGB";
+			c.Adaptation = "bradford";
+			for (int a = 0; a < 3; ++a)
+			{
+				const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+					static_cast<AccuracyEnum>(a));
+				c.Accuracy = kAccuracyNames[a];
+				c.Name = "buffer_rgb2lab";
+				bench.Run(c, [&]()
+				{
+					ConvertBuffer(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), out.data(), batch);
+					g_sink = g_sink + out[0];
+				});
+				c.Name = "buffer_lab2rgb";
+				bench.Run(c, [&]()
+				{
+					ConvertBuffer(plan, ModelEnum::Lab, ModelEnum::Rgb, lab.data(), out.data(), batch);
+					g_sink = g_sink + out[0];
+				});
+				c.Name = "buffer_u8_2lab";
+				bench.Run(c, [&]()
+				{
+					ConvertBuffer(plan, ModelEnum::Lab, codes.data(), out.data(), batch);
+					g_sink = g_sink + out[0];
+				});
+				c.Name = "diff_images_u8_de2000";
+				bench.Run(c, [&]()
+				{
+					const DiffStats stats = DiffImages(plan, DeltaEEnum::CIEDE2000,
+						codes.data(), codes2.data(), out.data(), batch);
+					g_sink = g_sink + stats.Mean;
+				});
+			}
+
+			const char* const deltaNames[] = { "delta_e76", "delta_e94", "delta_e2000" };
+			c.Accuracy = "-";
+			for (int f = 0; f < 3; ++f)
+			{
+				c.Name = deltaNames[f];
+				bench.Run(c, [&]()
+				{
+					DeltaEBuffer(static_cast<DeltaEEnum>(f), lab.data(), rgb.data(), out.data(), batch);
+					g_sink = g_sink + out[0];
+				});
+			}
+
+			const Lut3D lut(GetDefaultPlan(), ModelEnum::Rgb, ModelEnum::Lab, 33);
+			c.Accuracy = "-";
+			c.Name = "lut33_tetrahedral_rgb2lab";
+			bench.Run(c, [&]()
+			{
+				lut.Apply(rgb.data(), out.data(), batch, LutInterpEnum::Tetrahedral);
+				g_sink = g_sink + out[0];
+			});
+			c.Name = "lut33_trilinear_rgb2lab";
+			bench.Run(c, [&]()
+			{
+				lut.Apply(rgb.data(), out.data(), batch, LutInterpEnum::Trilinear);
+				g_sink = g_sink + out[0];
+			});
+		}
+
+		// thread scaling on a 24 megapixel frame (6000 x 4000): 1, 2, 4 ... hardware threads,
+		// speedup and efficiency against the one thread run; the frame only when selected
+		if (!bench.IsSelected("pool_rgb2lab_24mp"))
+			return;
+		const size_t frame = kFrameWidth * kFrameHeight;
+		std::vector<float> rgb(frame * 3), out(frame * 3);
+		const std::vector<double> r = MakeInput(frame, kRgbLo, kRgbHi);
+		for (size_t i = 0; i < frame * 3; ++i)
+			rgb[i] = static_cast<float>(r[i]);
+		const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+			AccuracyEnum::High);
+		const unsigned hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+		if (hardware < 4)
+			std::cerr << "pool_rgb2lab_24mp: " << hardware << " hardware threads, scaling not verified\n";
+		double single = 0.0;
+		for (unsigned threads = 1; ; threads = (threads * 2 < hardware) ? threads * 2 : hardware)
+		{
+			ThreadPool pool(threads);
+			BenchCase c;
+			c.Name = "pool_rgb2lab_24mp";
+			c.Space = "sRGB";
+			c.Adaptation = "bradford";
+			c.Accuracy = "high";
+			c.Batch = frame;
+			c.Threads = threads;
+			BenchCase* result = bench.Run(c, [&]()
+			{
+				ConvertBuffer(pool, plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), out.data(), frame);
+				g_sink = g_sink + out[0];
+			});
+			if (!result)
+				break;
+			if (threads == 1)
+				single = result->NsPerPixel;
+			result->Speedup = single / result->NsPerPixel;
+			result->Efficiency = result->Speedup / threads;
+			result->ExpectedEfficiency = kPoolExpectedEfficiency;
+			if (threads > 1 && threads <= hardware / 2)
+				bench.CheckScaling(*result);
+			if (threads == hardware)
+				break;
+		}
+	}
+	// palette sizes of the PaletteIndex cases
+	const size_t kPalettes[] = { 256, 4096 };
+
+	std::vector<LabColor> MakePalette(size_t n)
+	{
+		// a different sequence than the query colors: every other value
+		const std::vector<double> v = MakeInput(n * 2, kLabLo, kLabHi);
+		std::vector<LabColor> palette;
+		for (size_t i = 0; i < n; ++i)
+			palette.push_back(LabColor(v[i * 6], v[i * 6 + 4], v[i * 6 + 2]));
+		return palette;
+	}
+
+	// the O(N P) search PaletteIndex replaces, the same float dE76
+	uint32_t BruteNearest(const std::vector<float>& palette, const float* q, float& distance)
+	{
+		uint32_t best = kPaletteNone;
+		float bestD2 = INFINITY;
+		for (size_t i = 0; i < palette.size(); i += 3)
+		{
+			const float dl = palette[i] - q[0];
+			const float da = palette[i + 1] - q[1];
+			const float db = palette[i + 2] - q[2];
+			const float d2 = dl * dl + da * da + db * db;
+			if (d2 < bestD2)
+			{
+				bestD2 = d2;
+				best = static_cast<uint32_t>(i / 3);
+			}
+		}
+		distance = std::sqrt(bestD2);
+		return best;
+	}
+
+	std::vector<float> PalettePlanes(const std::vector<LabColor>& palette)
+	{
+		std::vector<float> v;
+		for (const LabColor& c : palette)
+		{
+			v.push_back(static_cast<float>(c.GetL()));
+			v.push_back(static_cast<float>(c.GetA()));
+			v.push_back(static_cast<float>(c.GetB()));
+		}
+		return v;
+	}
+
+	// PaletteIndex against brute force, dE2000 re-ranking and the pool on the largest batch
+	void BenchPalette(Bench& bench)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+		for (size_t size : kPalettes)
+		{
+			const std::vector<LabColor> palette = MakePalette(size);
+			const std::vector<float> flat = PalettePlanes(palette);
+			const PaletteIndex index(palette);
+			const std::string prefix = "palette" + std::to_string(size) + "_";
+			for (size_t batch : kBatches)
+			{
+				const std::vector<double> l = MakeInput(batch, kLabLo, kLabHi);
+				const std::vector<float> lab(l.begin(), l.end());
+				std::vector<uint32_t> ids(batch);
+				std::vector<float> distance(batch);
+				BenchCase c;
+				c.Batch = batch;
+				c.Name = prefix + "kdtree";
+				bench.Run(c, [&]()
+				{
+					index.Match(lab.data(), ids.data(), distance.data(), batch);
+					g_sink = g_sink + distance[0];
+				});
+				c.Name = prefix + "kdtree_de2000";
+				bench.Run(c, [&]()
+				{
+					index.Match(lab.data(), ids.data(), distance.data(), batch, DeltaEEnum::CIEDE2000);
+					g_sink = g_sink + distance[0];
+				});
+				// brute force at 1M colors would take seconds per pass
+				if (batch <= 16384)
+				{
+					c.Name = prefix + "brute";
+					bench.Run(c, [&]()
+					{
+						for (size_t i = 0; i < batch; ++i)
+							ids[i] = BruteNearest(flat, &lab[i * 3], distance[i]);
+						g_sink = g_sink + distance[0];
+					});
+				}
+				if (batch == kBatches[sizeof(kBatches) / sizeof(kBatches[0]) - 1] && hardware > 1)
+				{
+					ThreadPool pool(hardware);
+					c.Name = prefix + "kdtree";
+					c.Threads = hardware;
+					bench.Run(c, [&]()
+					{
+						index.Match(pool, lab.data(), ids.data(), distance.data(), batch);
+						g_sink = g_sink + distance[0];
+					});
+				}
+			}
+		}
+
+		// k-means extraction of 8 colors from 8-bit codes, the pool on the largest batch
+		const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+			AccuracyEnum::High);
+		for (size_t batch : kBatches)
+		{
+			std::vector<uint8_t> codes(batch * 3);
+			const std::vector<double> r = MakeInput(batch, kRgbLo, kRgbHi);
+			for (size_t i = 0; i < batch * 3; ++i)
+				codes[i] = static_cast<uint8_t>(r[i] * 255.0);
+			BenchCase c;
+			c.Name = "palette_extract_u8_k8";
+			c.Space = "sRGB";
+			c.Adaptation = "bradford";
+			c.Accuracy = "high";
+			c.Batch = batch;
+			bench.Run(c, [&]()
+			{
+				const std::vector<PaletteEntry> colors = ExtractPalette(plan, codes.data(), batch);
+				g_sink = g_sink + colors[0].Weight;
+			});
+			if (batch == kBatches[sizeof(kBatches) / sizeof(kBatches[0]) - 1] && hardware > 1)
+			{
+				ThreadPool pool(hardware);
+				c.Threads = hardware;
+				bench.Run(c, [&]()
+				{
+					const std::vector<PaletteEntry> colors = ExtractPalette(pool, plan, codes.data(), batch);
+					g_sink = g_sink + colors[0].Weight;
+				});
+			}
+		}
+	}
+
+	// GamutMap on Lab colors spread over the whole Lab range, most of them out of
+	// sRGB: the test alone, clipping and chroma reduction, the pool on the largest batch
+	void BenchGamut(Bench& bench)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+		const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+			AccuracyEnum::High);
+		const GamutMap gamut(plan);
+		const char* const modeNames[] = { "gamut_test_lab", "gamut_clip_lab", "gamut_chroma_lab" };
+		for (size_t batch : kBatches)
+		{
+			const std::vector<double> l = MakeInput(batch, kLabLo, kLabHi);
+			const std::vector<float> lab(l.begin(), l.end());
+			std::vector<float> rgb(batch * 3);
+			std::vector<uint8_t> mask(batch);
+			BenchCase c;
+			c.Space = "sRGB";
+			c.Adaptation = "bradford";
+			c.Accuracy = "high";
+			c.Batch = batch;
+			for (int m = 0; m < 3; ++m)
+			{
+				c.Name = modeNames[m];
+				bench.Run(c, [&]()
+				{
+					const size_t outside = gamut.Map(ModelEnum::Lab, lab.data(), rgb.data(), mask.data(), batch,
+						static_cast<GamutEnum>(m));
+					g_sink = g_sink + static_cast<double>(outside);
+				});
+			}
+			if (batch == kBatches[sizeof(kBatches) / sizeof(kBatches[0]) - 1] && hardware > 1)
+			{
+				ThreadPool pool(hardware);
+				c.Name = modeNames[2];
+				c.Threads = hardware;
+				bench.Run(c, [&]()
+				{
+					const size_t outside = gamut.Map(pool, ModelEnum::Lab, lab.data(), rgb.data(), mask.data(),
+						batch);
+					g_sink = g_sink + static_cast<double>(outside);
+				});
+			}
+		}
+	}
+
+	// an image of n pixels drawn from colors distinct 8-bit colors, the palette
+	// order scrambled so neighbours differ
+	std::vector<uint8_t> MakePaletteImage(size_t n, size_t colors)
+	{
+		const std::vector<double> r = MakeInput(colors, kRgbLo, kRgbHi);
+		std::vector<uint8_t> image(n * 3);
+		for (size_t i = 0; i < n; ++i)
+		{
+			const size_t c = (i * 2654435761u) % colors;
+			for (int j = 0; j < 3; ++j)
+				image[i * 3 + j] = static_cast<uint8_t>(r[c * 3 + j] * 255.0);
+		}
+		return image;
+	}
+
+	// ConversionCache on a 4096 color image against the plain conversion (the
+	// buffer_u8_2lab cases), a warm cache: every lookup hits
+	void BenchCache(Bench& bench)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+		for (size_t batch : kBatches)
+		{
+			const std::vector<uint8_t> codes = MakePaletteImage(batch, 4096);
+			std::vector<float> rgb(codes.begin(), codes.end());
+			for (float& v : rgb)
+				v /= 255.0f;
+			std::vector<float> out(batch * 3);
+			BenchCase c;
+			c.Batch = batch;
+			c.Space = "sRGB";
+			c.Adaptation = "bradford";
+			for (int a = 0; a < 2; ++a)
+			{
+				const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+					static_cast<AccuracyEnum>(a));
+				ConversionCache cache;
+				c.Accuracy = kAccuracyNames[a];
+				c.Threads = 1;
+				c.Name = "cache_u8_2lab_palette4096";
+				bench.Run(c, [&]()
+				{
+					cache.Convert(plan, ModelEnum::Lab, codes.data(), out.data(), batch);
+					g_sink = g_sink + out[0];
+				});
+				c.Name = "cache_rgb2lab_palette4096";
+				bench.Run(c, [&]()
+				{
+					cache.Convert(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), out.data(), batch);
+					g_sink = g_sink + out[0];
+				});
+				if (batch == kBatches[sizeof(kBatches) / sizeof(kBatches[0]) - 1] && hardware > 1)
+				{
+					ThreadPool pool(hardware);
+					c.Name = "cache_u8_2lab_palette4096";
+					c.Threads = hardware;
+					bench.Run(c, [&]()
+					{
+						cache.Convert(pool, plan, ModelEnum::Lab, codes.data(), out.data(), batch);
+						g_sink = g_sink + out[0];
+					});
+				}
+			}
+		}
+	}
+
+	// SpectralTable on reflectance spectra: a 31 band spectrophotometer sampling (400 to
+	// 700 nm every 10 nm) and a 121 band hyperspectral cube (400 to 1000 nm every 5 nm,
+	// the bands past 780 nm carry no weight), interleaved (BIP) and planar (BSQ)
+	void BenchSpectral(Bench& bench)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+		// the largest cube is 127 MB
+		const size_t cubeBatches[] = { 256, 16384, 1 << 18 };
+		const SpectralTable meter(IlluminantEnum::D50, ObserverEnum::Cie1931, 400, 10, 31);
+		const SpectralTable cube(IlluminantEnum::D50, ObserverEnum::Cie1931, 400, 5, 121);
+		for (int t = 0; t < 2; ++t)
+		{
+			const SpectralTable& table = t ? cube : meter;
+			const size_t bands = table.GetBands();
+			const size_t* batches = t ? cubeBatches : kBatches;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const size_t batch = batches[k];
+				std::vector<float> in(batch * bands);
+				for (size_t i = 0; i < in.size(); ++i)
+					in[i] = static_cast<float>((i * 2654435761u) % 1000) / 999.0f;
+				std::vector<float> out(batch * 3);
+				for (int layout = 0; layout < 2; ++layout)
+				{
+					BenchCase c;
+					c.Name = std::string("spectral_") + std::to_string(bands) + "band_"
+						+ (layout ? "planar" : "interleaved");
+					c.Batch = batch;
+					c.BytesPerPixel = static_cast<double>(bands * sizeof(float));
+					bench.Run(c, [&]()
+					{
+						table.Integrate(in.data(), out.data(), batch, static_cast<LayoutEnum>(layout));
+						g_sink = g_sink + out[0];
+					});
+					if (k == 2 && hardware > 1)
+					{
+						ThreadPool pool(hardware);
+						c.Threads = hardware;
+						bench.Run(c, [&]()
+						{
+							table.Integrate(pool, in.data(), out.data(), batch, static_cast<LayoutEnum>(layout));
+							g_sink = g_sink + out[0];
+						});
+					}
+				}
+			}
+		}
+	}
+
+	// XYZ (Y = 1) of the color Duv off the Planckian locus at T
+	void MakeLightXyz(double T, double duv, double xyz[3])
+	{
+		double u, v, u1, v1;
+		GetPlanckianUV(T, u, v);
+		GetPlanckianUV(T * 1.0001, u1, v1);
+		const double length = std::sqrt((u1 - u) * (u1 - u) + (v1 - v) * (v1 - v));
+		// the normal pointing up: the tangent towards lower T turned left
+		const double cu = u - (v1 - v) / length * duv;
+		const double cv = v + (u1 - u) / length * duv;
+		const double x = 3.0 * cu / (2.0 * cu - 8.0 * cv + 4.0);
+		const double y = 2.0 * cv / (2.0 * cu - 8.0 * cv + 4.0);
+		xyz[0] = x / y;
+		xyz[1] = 1.0;
+		xyz[2] = (1.0 - x - y) / y;
+	}
+
+	// CCTBuffer on light sources from 1500 to 20000 K, |Duv| up to 0.02
+	void BenchCct(Bench& bench)
+	{
+		const unsigned hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+		const double lo[3] = { 1e6 / 20000.0, -0.02, 0.05 };
+		const double hi[3] = { 1e6 / 1500.0, 0.02, 1.0 };
+		for (size_t batch : kBatches)
+		{
+			const std::vector<double> light = MakeInput(batch, lo, hi);
+			std::vector<float> xyz(batch * 3);
+			for (size_t i = 0; i < batch; ++i)
+			{
+				double c[3];
+				MakeLightXyz(1e6 / light[i * 3], light[i * 3 + 1], c);
+				for (int k = 0; k < 3; ++k)
+					xyz[i * 3 + k] = static_cast<float>(c[k] * light[i * 3 + 2]);
+			}
+			std::vector<float> cct(batch), duv(batch);
+			BenchCase c;
+			c.Name = "cct_duv_xyz";
+			c.Batch = batch;
+			bench.Run(c, [&]()
+			{
+				CCTBuffer(xyz.data(), cct.data(), duv.data(), batch);
+				g_sink = g_sink + cct[0];
+			});
+			if (batch == kBatches[sizeof(kBatches) / sizeof(kBatches[0]) - 1] && hardware > 1)
+			{
+				ThreadPool pool(hardware);
+				c.Threads = hardware;
+				bench.Run(c, [&]()
+				{
+					CCTBuffer(pool, xyz.data(), cct.data(), duv.data(), batch);
+					g_sink = g_sink + cct[0];
+				});
+			}
+		}
+	}
+
+	// ConvertSpaces per accuracy tier against the double reference, RGB 0..1
+	const double kRegistryTolerance[] = { 1e-6, 5e-6, 2e-4 };
+
+	// Display P3: the DCI-P3 primaries, D65, the sRGB curve
+	ColorSpaceDesc MakeDisplayP3()
+	{
+		ColorSpaceDesc desc;
+		desc.xr = 0.680;
+		desc.yr = 0.320;
+		desc.xg = 0.265;
+		desc.yg = 0.690;
+		desc.xb = 0.150;
+		desc.yb = 0.060;
+		desc.White = GetWhiteFromXY(0.3127, 0.3290);
+		desc.Gamma = -2.2;
+		return desc;
+	}
+
+	void BenchRegistry(Bench& bench)
+	{
+		const ColorSpaceHandle p3 = RegisterColorSpace(MakeDisplayP3());
+		const ColorSpaceHandle adobe = static_cast<ColorSpaceHandle>(RgbEnum::AdobeRgb);
+		for (size_t batch : kBatches)
+		{
+			std::vector<float> rgb(batch * 3), out(batch * 3);
+			const std::vector<double> r = MakeInput(batch, kRgbLo, kRgbHi);
+			for (size_t i = 0; i < batch * 3; ++i)
+				rgb[i] = static_cast<float>(r[i]);
+
+			BenchCase c;
+			c.Name = "space_p3_to_adobe";
+			c.Batch = batch;
+			c.Space = "DisplayP3";
+			c.Adaptation = "bradford";
+			c.BytesPerPixel = 24;
+			for (int a = 0; a < 3; ++a)
+			{
+				c.Accuracy = kAccuracyNames[a];
+				bench.Run(c, [&]()
+				{
+					ConvertSpaces(p3, adobe, rgb.data(), out.data(), batch, LayoutEnum::Interleaved,
+						AdaptationEnum::amBradford, static_cast<AccuracyEnum>(a));
+					g_sink = g_sink + out[0];
+				});
+			}
+		}
+	}
+
+	// grid points per axis of the verify sweeps
+	constexpr int kVerifySteps = 64;
+
+	// kVerifySteps^3 colors from lo to hi, both ends included, or offset by half a step
+	std::vector<float> MakeGrid(ModelEnum model, bool offset = false)
+	{
+		float lo[3], hi[3];
+		GetModelRange(model, lo, hi);
+		const double shift = offset ? 0.5 : 0.0;
+		const double steps = offset ? kVerifySteps : kVerifySteps - 1;
+		std::vector<float> grid;
+		grid.reserve(kVerifySteps * kVerifySteps * kVerifySteps * 3);
+		for (int i = 0; i < kVerifySteps; ++i)
+			for (int j = 0; j < kVerifySteps; ++j)
+				for (int k = 0; k < kVerifySteps; ++k)
+				{
+					grid.push_back(static_cast<float>(lo[0] + (hi[0] - lo[0]) * (i + shift) / steps));
+					grid.push_back(static_cast<float>(lo[1] + (hi[1] - lo[1]) * (j + shift) / steps));
+					grid.push_back(static_cast<float>(lo[2] + (hi[2] - lo[2]) * (k + shift) / steps));
+				}
+		return grid;
+	}
+
+	const char* GetGammaName(double gamma)
+	{
+		return (gamma < 0.0) ? "srgb" : (gamma == 0.0) ? "lstar" : (gamma < 2.0) ? "g18" : "g22";
+	}
+
+	// CompandApprox against Compand / InvCompand over [-1, 1] (bound: GetAccuracyBound),
+	// InvCompandTable bit for bit
+	void VerifyCompand(Bench& bench)
+	{
+		std::vector<double> gammas;
+		for (size_t s = 0; s < kRgbModelCount; ++s)
+		{
+			const double gamma = GetRGBModel(static_cast<RgbEnum>(s)).GammaRGB;
+			if (std::find(gammas.begin(), gammas.end(), gamma) == gammas.end())
+				gammas.push_back(gamma);
+		}
+		for (double gamma : gammas)
+		{
+			for (int a = 1; a < 3; ++a)
+			{
+				const AccuracyEnum accuracy = static_cast<AccuracyEnum>(a);
+				const CompandApprox& approx = GetCompandApprox(gamma, accuracy);
+				AccuracyCheck compand(std::string("compand_") + kAccuracyNames[a] + "_" + GetGammaName(gamma),
+					"abs", GetAccuracyBound(accuracy));
+				AccuracyCheck inverse(std::string("inv_compand_") + kAccuracyNames[a] + "_" + GetGammaName(gamma),
+					"abs", GetAccuracyBound(accuracy));
+				for (int i = 0; i <= 1 << 16; ++i)
+				{
+					const double v = -1.0 + i / 32768.0;
+					compand.Add(approx.Compand(v), Compand(v, gamma));
+					inverse.Add(approx.InvCompand(v), InvCompand(v, gamma));
+				}
+				bench.Check(compand);
+				bench.Check(inverse);
+			}
+			for (int bits : { 8, 10, 12, 16 })
+			{
+				const InvCompandTable& table = GetInvCompandTable(gamma, bits);
+				AccuracyCheck check("inv_compand_table" + std::to_string(bits) + "_" + GetGammaName(gamma), "abs", 0.0);
+				for (unsigned code = 0; code <= table.GetMaxCode(); ++code)
+					check.Add(table[code], InvCompand(code / static_cast<double>(table.GetMaxCode()), gamma));
+				bench.Check(check);
+			}
+		}
+	}
+
+	// adds the three channels of a Lab result and its dE2000
+	template <typename T>
+	void AddLab(AccuracyCheck& check, const T lab[3], const double ref[3])
+	{
+		for (int c = 0; c < 3; ++c)
+			check.Add(lab[c], ref[c]);
+		check.AddDeltaE(DeltaE2000<double>(lab[0], lab[1], lab[2], ref[0], ref[1], ref[2]));
+	}
+
+	// adds the three channels of an XYZ result and its dE2000 under white
+	template <typename T>
+	void AddXyz(AccuracyCheck& check, const T xyz[3], const double ref[3], const XYZ& white)
+	{
+		double lab[3], labRef[3];
+		for (int c = 0; c < 3; ++c)
+			check.Add(xyz[c], ref[c]);
+		XYZ2Lab<double>(xyz[0], xyz[1], xyz[2], white, lab[0], lab[1], lab[2]);
+		XYZ2Lab<double>(ref[0], ref[1], ref[2], white, labRef[0], labRef[1], labRef[2]);
+		check.AddDeltaE(DeltaE2000<double>(lab[0], lab[1], lab[2], labRef[0], labRef[1], labRef[2]));
+	}
+
+	// XYZ2LabFast / Lab2XYZFast and the float instantiations against the double XYZ2Lab / Lab2XYZ
+	void VerifyLab(Bench& bench)
+	{
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		const std::vector<float> xyz = MakeGrid(ModelEnum::Xyz);
+		const std::vector<float> lab = MakeGrid(ModelEnum::Lab);
+
+		AccuracyCheck fastLab("xyz2lab_fast", "abs", 1e-10);
+		AccuracyCheck fastXyz("lab2xyz_fast", "abs", 1e-12);
+		AccuracyCheck floatLab("xyz2lab_float", "abs", 2e-4);
+		AccuracyCheck floatXyz("lab2xyz_float", "abs", 1e-6);
+		AccuracyCheck fastFloatLab("xyz2lab_fast_float", "abs", 2e-4);
+		AccuracyCheck fastFloatXyz("lab2xyz_fast_float", "abs", 1e-6);
+		for (size_t i = 0; i < xyz.size(); i += 3)
+		{
+			double ref[3], out[3];
+			float outf[3];
+			XYZ2Lab<double>(xyz[i], xyz[i + 1], xyz[i + 2], white, ref[0], ref[1], ref[2]);
+			XYZ2LabFast<double>(xyz[i], xyz[i + 1], xyz[i + 2], white, out[0], out[1], out[2]);
+			AddLab(fastLab, out, ref);
+			XYZ2Lab<float>(xyz[i], xyz[i + 1], xyz[i + 2], white, outf[0], outf[1], outf[2]);
+			AddLab(floatLab, outf, ref);
+			XYZ2LabFast<float>(xyz[i], xyz[i + 1], xyz[i + 2], white, outf[0], outf[1], outf[2]);
+			AddLab(fastFloatLab, outf, ref);
+
+			Lab2XYZ<double>(lab[i], lab[i + 1], lab[i + 2], white, ref[0], ref[1], ref[2]);
+			Lab2XYZFast<double>(lab[i], lab[i + 1], lab[i + 2], white, out[0], out[1], out[2]);
+			AddXyz(fastXyz, out, ref, white);
+			Lab2XYZ<float>(lab[i], lab[i + 1], lab[i + 2], white, outf[0], outf[1], outf[2]);
+			AddXyz(floatXyz, outf, ref, white);
+			Lab2XYZFast<float>(lab[i], lab[i + 1], lab[i + 2], white, outf[0], outf[1], outf[2]);
+			AddXyz(fastFloatXyz, outf, ref, white);
+		}
+		bench.Check(fastLab);
+		bench.Check(fastXyz);
+		bench.Check(floatLab);
+		bench.Check(floatXyz);
+		bench.Check(fastFloatLab);
+		bench.Check(fastFloatXyz);
+	}
+
+	// every SIMD level this CPU runs against the double reference, bounds
+	// kSimdXyzTolerance / kSimdLabTolerance / kSimdDeltaETolerance as declared in ColorSimd.h
+	void VerifySimd(Bench& bench)
+	{
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		const Mtx3x3& m = GetDefaultPlan().GetRGB2XYZ();
+		const Mtx3x3f mf = MtxConvert3x3<float>(m);
+		const std::vector<float> rgb = MakeGrid(ModelEnum::Rgb);
+		const std::vector<float> xyz = MakeGrid(ModelEnum::Xyz);
+		// Lab of the XYZ grid, the range the Lab tolerance is declared for
+		std::vector<float> lab(xyz.size());
+		for (size_t i = 0; i < xyz.size(); i += 3)
+		{
+			double l, a, b;
+			XYZ2Lab<double>(xyz[i], xyz[i + 1], xyz[i + 2], white, l, a, b);
+			lab[i] = static_cast<float>(l);
+			lab[i + 1] = static_cast<float>(a);
+			lab[i + 2] = static_cast<float>(b);
+		}
+		const size_t n = rgb.size() / 3;
+		for (int level = 0; level <= static_cast<int>(GetSimdSupport()); ++level)
+		{
+			const SimdKernels& kernels = GetSimdKernels(static_cast<SimdEnum>(level));
+			const std::string prefix = std::string("simd_") + kSimdNames[level] + "_";
+			std::vector<float> c[3];
+			AccuracyCheck mtx(prefix + "mtx3x3", "abs", kSimdXyzTolerance);
+			AccuracyCheck toLab(prefix + "xyz2lab", "abs", kSimdLabTolerance);
+			AccuracyCheck toXyz(prefix + "lab2xyz", "abs", kSimdXyzTolerance);
+
+			for (int k = 0; k < 3; ++k)
+				c[k].assign(n, 0.0f);
+			for (size_t i = 0; i < n; ++i)
+				for (int k = 0; k < 3; ++k)
+					c[k][i] = rgb[i * 3 + k];
+			kernels.Mtx3x3(mf, c[0].data(), c[1].data(), c[2].data(), n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				const double r = rgb[i * 3], g = rgb[i * 3 + 1], b = rgb[i * 3 + 2];
+				const float out[3] = { c[0][i], c[1][i], c[2][i] };
+				const double ref[3] = { r * m.m[0][0] + g * m.m[1][0] + b * m.m[2][0],
+					r * m.m[0][1] + g * m.m[1][1] + b * m.m[2][1],
+					r * m.m[0][2] + g * m.m[1][2] + b * m.m[2][2] };
+				AddXyz(mtx, out, ref, white);
+			}
+
+			for (size_t i = 0; i < n; ++i)
+				for (int k = 0; k < 3; ++k)
+					c[k][i] = xyz[i * 3 + k];
+			kernels.XYZ2Lab(white, c[0].data(), c[1].data(), c[2].data(), n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				double ref[3];
+				const float out[3] = { c[0][i], c[1][i], c[2][i] };
+				XYZ2Lab<double>(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2], white, ref[0], ref[1], ref[2]);
+				AddLab(toLab, out, ref);
+			}
+
+			for (size_t i = 0; i < n; ++i)
+				for (int k = 0; k < 3; ++k)
+					c[k][i] = lab[i * 3 + k];
+			kernels.Lab2XYZ(white, c[0].data(), c[1].data(), c[2].data(), n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				double ref[3];
+				const float out[3] = { c[0][i], c[1][i], c[2][i] };
+				Lab2XYZ<double>(lab[i * 3], lab[i * 3 + 1], lab[i * 3 + 2], white, ref[0], ref[1], ref[2]);
+				AddXyz(toXyz, out, ref, white);
+			}
+			bench.Check(mtx);
+			bench.Check(toLab);
+			bench.Check(toXyz);
+
+			// Lab pairs: the grid against the grid reversed, plus near pairs
+			AccuracyCheck de(prefix + "de2000", "abs", kSimdDeltaETolerance);
+			std::vector<float> p[6];
+			for (size_t i = 0; i < n; ++i)
+			{
+				const size_t j = (i % 2) ? n - 1 - i : i;
+				for (int k = 0; k < 3; ++k)
+				{
+					p[k].push_back(lab[i * 3 + k]);
+					p[k + 3].push_back(lab[j * 3 + k] + ((i % 2) ? 0.0f : 0.37f * (k + 1)));
+				}
+			}
+			std::vector<float> out(n);
+			kernels.DeltaE2000(p[0].data(), p[1].data(), p[2].data(), p[3].data(), p[4].data(), p[5].data(),
+				out.data(), n);
+			for (size_t i = 0; i < n; ++i)
+				de.Add(out[i], DeltaE2000<double>(p[0][i], p[1][i], p[2][i], p[3][i], p[4][i], p[5][i]));
+			bench.Check(de);
+		}
+	}
+
+	// the reference path of the default plan: RGB2XYZ / XYZ2RGB / XYZ2Lab / Lab2XYZ in double
+	void ReferenceConvert(ModelEnum src, ModelEnum dst, const float in[3], double out[3])
+	{
+		const RgbModel& model = GetRGBModel(RgbEnum::sRGB);
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		double xyz[3];
+		if (src == ModelEnum::Rgb)
+			RGB2XYZ<double>(in[0], in[1], in[2], model.GammaRGB, model, xyz[0], xyz[1], xyz[2], white);
+		else if (src == ModelEnum::Lab)
+			Lab2XYZ<double>(in[0], in[1], in[2], white, xyz[0], xyz[1], xyz[2]);
+		else
+			for (int c = 0; c < 3; ++c)
+				xyz[c] = in[c];
+		if (dst == ModelEnum::Rgb)
+			XYZ2RGB<double>(xyz[0], xyz[1], xyz[2], white, out[0], out[1], out[2], model.GammaRGB, model);
+		else if (dst == ModelEnum::Lab)
+			XYZ2Lab<double>(xyz[0], xyz[1], xyz[2], white, out[0], out[1], out[2]);
+		else
+			for (int c = 0; c < 3; ++c)
+				out[c] = xyz[c];
+	}
+
+	// dE2000 of two RGB results, through the reference path
+	double RgbDeltaE(const float rgb[3], const double ref[3])
+	{
+		double lab[3], labRef[3];
+		const float r[3] = { static_cast<float>(ref[0]), static_cast<float>(ref[1]), static_cast<float>(ref[2]) };
+		ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, rgb, lab);
+		ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, r, labRef);
+		return DeltaE2000<double>(lab[0], lab[1], lab[2], labRef[0], labRef[1], labRef[2]);
+	}
+
+	// max dE2000 of ConvertBuffer per accuracy tier on sRGB, D50, Bradford
+	const double kBufferDeltaE[3] = { 1e-3, 2e-3, 5e-2 };
+	// max dE2000 of a 33^3 Lut3D, RGB -> Lab
+	const double kLutDeltaE = 0.5;
+	// max dE2000 a PaletteIndex match with kPaletteCandidates re-ranked may lose
+	// (about 1 in 4000 colors misses the nearest one, by about 1)
+	const double kPaletteRefineTolerance = 1.5;
+	// max |dL| and dH of a GamutMap chroma reduction
+	const double kGamutLabTolerance = 0.02;
+
+	// ConvertBuffer tiers and the uint8 path against the reference, inputs in gamut
+	// (XYZ and Lab inputs are the reference conversions of the RGB grid); Lut3D
+	// off its nodes
+	void VerifyBuffers(Bench& bench)
+	{
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		const std::vector<float> rgb = MakeGrid(ModelEnum::Rgb);
+		const size_t n = rgb.size() / 3;
+		std::vector<float> xyz(rgb.size()), lab(rgb.size()), out(rgb.size());
+		for (size_t i = 0; i < rgb.size(); i += 3)
+		{
+			double x[3], l[3];
+			ReferenceConvert(ModelEnum::Rgb, ModelEnum::Xyz, &rgb[i], x);
+			ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, &rgb[i], l);
+			for (int c = 0; c < 3; ++c)
+			{
+				xyz[i + c] = static_cast<float>(x[c]);
+				lab[i + c] = static_cast<float>(l[c]);
+			}
+		}
+		// 8-bit codes 0, 4, 8 ... 252, 255 per channel
+		std::vector<uint8_t> codes;
+		std::vector<float> codeRgb;
+		for (int i = 0; i <= 64; ++i)
+			for (int j = 0; j <= 64; ++j)
+				for (int k = 0; k <= 64; ++k)
+					for (int v : { i, j, k })
+					{
+						codes.push_back(static_cast<uint8_t>((v < 64) ? v * 4 : 255));
+						codeRgb.push_back(codes.back() / 255.0f);
+					}
+
+		typedef struct _Edge
+		{
+			const char* Name;
+			ModelEnum From;
+			ModelEnum To;
+			const std::vector<float>* In;
+		} Edge;
+		const Edge edges[] = { { "rgb2xyz", ModelEnum::Rgb, ModelEnum::Xyz, &rgb },
+			{ "rgb2lab", ModelEnum::Rgb, ModelEnum::Lab, &rgb },
+			{ "xyz2rgb", ModelEnum::Xyz, ModelEnum::Rgb, &xyz },
+			{ "xyz2lab", ModelEnum::Xyz, ModelEnum::Lab, &xyz },
+			{ "lab2rgb", ModelEnum::Lab, ModelEnum::Rgb, &lab },
+			{ "lab2xyz", ModelEnum::Lab, ModelEnum::Xyz, &lab } };
+
+		for (int a = 0; a < 3; ++a)
+		{
+			const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+				static_cast<AccuracyEnum>(a));
+			const std::string prefix = std::string("buffer_") + kAccuracyNames[a] + "_";
+			for (const Edge& edge : edges)
+			{
+				AccuracyCheck check(prefix + edge.Name, "de2000", kBufferDeltaE[a]);
+				const std::vector<float>& in = *edge.In;
+				ConvertBuffer(plan, edge.From, edge.To, in.data(), out.data(), n);
+				for (size_t i = 0; i < in.size(); i += 3)
+				{
+					double ref[3];
+					ReferenceConvert(edge.From, edge.To, &in[i], ref);
+					if (edge.To == ModelEnum::Lab)
+						AddLab(check, &out[i], ref);
+					else if (edge.To == ModelEnum::Xyz)
+						AddXyz(check, &out[i], ref, white);
+					else
+					{
+						for (int c = 0; c < 3; ++c)
+							check.Add(out[i + c], ref[c]);
+						check.AddDeltaE(RgbDeltaE(&out[i], ref));
+					}
+				}
+				bench.Check(check);
+			}
+
+			AccuracyCheck check(prefix + "u8_2lab", "de2000", kBufferDeltaE[a]);
+			std::vector<float> codeLab(codes.size());
+			ConvertBuffer(plan, ModelEnum::Lab, codes.data(), codeLab.data(), codes.size() / 3);
+			for (size_t i = 0; i < codes.size(); i += 3)
+			{
+				double ref[3];
+				ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, &codeRgb[i], ref);
+				AddLab(check, &codeLab[i], ref);
+			}
+			bench.Check(check);
+		}
+
+		// DeltaEBuffer CIE76 / CIE94 (float) against the double functions, Lab grid against its reverse
+		for (int f = 0; f < 2; ++f)
+		{
+			AccuracyCheck check(f ? "delta_e94" : "delta_e76", "abs", 1e-4);
+			std::vector<float> reversed(lab.rbegin(), lab.rend());
+			DeltaEBuffer(static_cast<DeltaEEnum>(f), lab.data(), reversed.data(), out.data(), n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				const float* p = &lab[i * 3];
+				const float* q = &reversed[i * 3];
+				check.Add(out[i], f ? DeltaE94<double>(p[0], p[1], p[2], q[0], q[1], q[2])
+					: DeltaE76<double>(p[0], p[1], p[2], q[0], q[1], q[2]));
+			}
+			bench.Check(check);
+		}
+
+		const Lut3D lut(GetDefaultPlan(), ModelEnum::Rgb, ModelEnum::Lab, 33);
+		const std::vector<float> offGrid = MakeGrid(ModelEnum::Rgb, true);
+		for (int interp = 0; interp < 2; ++interp)
+		{
+			AccuracyCheck check(interp ? "lut33_tetrahedral_rgb2lab" : "lut33_trilinear_rgb2lab", "de2000", kLutDeltaE);
+			lut.Apply(offGrid.data(), out.data(), n, static_cast<LutInterpEnum>(interp));
+			for (size_t i = 0; i < offGrid.size(); i += 3)
+			{
+				double ref[3];
+				ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, &offGrid[i], ref);
+				AddLab(check, &out[i], ref);
+			}
+			bench.Check(check);
+		}
+	}
+
+	// ConvertBuffer throughput, Mpix/s per accuracy tier: interleaved sRGB -> Lab (D50,
+	// Bradford) on the 1M batch, one thread, optimized build, as measured on a current
+	// x86 core. The floor is a fixed fraction of it: noise and a busy host stay above,
+	// a 2x regression falls below. Re-measure when the reference machine changes.
+	const double kBufferMeasuredMpix[] = { 10.0, 24.0, 30.0 };
+	const double kBufferFloorFraction = 0.6;
+
+	void VerifyThroughput(Bench& bench)
+	{
+		const size_t batch = kBatches[sizeof(kBatches) / sizeof(kBatches[0]) - 1];
+		std::vector<float> rgb(batch * 3), out(batch * 3);
+		const std::vector<double> r = MakeInput(batch, kRgbLo, kRgbHi);
+		for (size_t i = 0; i < batch * 3; ++i)
+			rgb[i] = static_cast<float>(r[i]);
+		for (int a = 0; a < 3; ++a)
+		{
+			const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+				static_cast<AccuracyEnum>(a));
+			const std::string name = std::string("throughput_rgb2lab_") + kAccuracyNames[a];
+			bench.CheckThroughput(name, batch, kBufferMeasuredMpix[a] * kBufferFloorFraction, [&]()
+			{
+				ConvertBuffer(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), out.data(), batch);
+				g_sink = g_sink + out[0];
+			});
+		}
+	}
+
+	// PaletteIndex nearest and 8 nearest (dE76) against brute force: the same distances,
+	// the pool the same as serial; the dE2000 re-ranking against the brute force
+	// dE2000 nearest, off by the colors outside the dE76 candidates; ExtractPalette
+	void VerifyPalette(Bench& bench)
+	{
+		const std::vector<LabColor> palette = MakePalette(kPalettes[sizeof(kPalettes) / sizeof(kPalettes[0]) - 1]);
+		const std::vector<float> flat = PalettePlanes(palette);
+		const PaletteIndex index(palette);
+		const std::vector<float> lab = MakeGrid(ModelEnum::Lab, true);
+		const size_t n = lab.size() / 3;
+
+		std::vector<uint32_t> ids(n), poolIds(n);
+		std::vector<float> distance(n), poolDistance(n);
+		index.Match(lab.data(), ids.data(), distance.data(), n);
+		ThreadPool pool;
+		index.Match(pool, lab.data(), poolIds.data(), poolDistance.data(), n);
+		AccuracyCheck nearest("palette_nearest", "abs", 0.0);
+		AccuracyCheck parallel("palette_nearest_pool", "abs", 0.0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			float brute;
+			BruteNearest(flat, &lab[i * 3], brute);
+			nearest.Add(distance[i], brute);
+			parallel.Add(poolDistance[i], distance[i]);
+		}
+		bench.Check(nearest);
+		bench.Check(parallel);
+
+		// every 16th color: the sorted brute force distances take a while
+		AccuracyCheck knearest("palette_knearest8", "abs", 0.0);
+		std::vector<float> all(palette.size());
+		for (size_t i = 0; i < n; i += 16)
+		{
+			const float* q = &lab[i * 3];
+			uint32_t found[8];
+			float d[8];
+			const size_t count = index.KNearest(q[0], q[1], q[2], 8, found, d);
+			for (size_t j = 0; j < palette.size(); ++j)
+			{
+				const float dl = flat[j * 3] - q[0];
+				const float da = flat[j * 3 + 1] - q[1];
+				const float db = flat[j * 3 + 2] - q[2];
+				all[j] = std::sqrt(dl * dl + da * da + db * db);
+			}
+			std::partial_sort(all.begin(), all.begin() + 8, all.end());
+			for (size_t j = 0; j < 8; ++j)
+				knearest.Add(j < count ? d[j] : INFINITY, all[j]);
+		}
+		bench.Check(knearest);
+
+		// every 64th color, the brute force dE2000 is in double
+		AccuracyCheck refined("palette_nearest_de2000", "abs", kPaletteRefineTolerance);
+		index.Match(lab.data(), ids.data(), distance.data(), n, DeltaEEnum::CIEDE2000);
+		for (size_t i = 0; i < n; i += 64)
+		{
+			const float* q = &lab[i * 3];
+			double best = INFINITY;
+			for (const LabColor& c : palette)
+				best = std::min(best, DeltaE2000<double>(c.GetL(), c.GetA(), c.GetB(), q[0], q[1], q[2]));
+			refined.Add(distance[i], best);
+		}
+		bench.Check(refined);
+
+		// k-means on an image of 6 flat colors in set shares, scattered over it:
+		// the colors and shares come back, the pool the same as serial
+		const uint8_t flatColors[6][3] = { { 200, 30, 40 }, { 20, 180, 60 }, { 30, 40, 200 },
+			{ 240, 240, 230 }, { 10, 10, 10 }, { 250, 200, 0 } };
+		const size_t shares[6] = { 30, 25, 20, 12, 8, 5 };
+		const size_t pixels = 1 << 20;
+		std::vector<uint8_t> image(pixels * 3);
+		for (size_t i = 0; i < pixels; ++i)
+		{
+			size_t slot = (i * 37) % 100;
+			int color = 0;
+			while (slot >= shares[color])
+				slot -= shares[color++];
+			std::copy(flatColors[color], flatColors[color] + 3, &image[i * 3]);
+		}
+		const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+			AccuracyEnum::Exact);
+		PaletteOptions options;
+		options.Colors = 6;
+		const std::vector<PaletteEntry> colors = ExtractPalette(plan, image.data(), pixels, options);
+		const std::vector<PaletteEntry> poolColors = ExtractPalette(pool, plan, image.data(), pixels, options);
+		AccuracyCheck extract("palette_extract", "abs", kBufferDeltaE[0]);
+		AccuracyCheck extractPool("palette_extract_pool", "abs", 0.0);
+		for (size_t c = 0; c < 6; ++c)
+		{
+			const float rgb[3] = { flatColors[c][0] / 255.0f, flatColors[c][1] / 255.0f, flatColors[c][2] / 255.0f };
+			double ref[3];
+			ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, rgb, ref);
+			const bool found = c < colors.size();
+			const bool same = found && c < poolColors.size();
+			extract.Add(found ? colors[c].Lab.GetL() : INFINITY, ref[0]);
+			extract.Add(found ? colors[c].Lab.GetA() : INFINITY, ref[1]);
+			extract.Add(found ? colors[c].Lab.GetB() : INFINITY, ref[2]);
+			extract.Add(found ? colors[c].Weight : INFINITY, shares[c] / 100.0);
+			extractPool.Add(same ? poolColors[c].Lab.GetL() : INFINITY, found ? colors[c].Lab.GetL() : 0.0);
+			extractPool.Add(same ? static_cast<double>(poolColors[c].Pixels) : INFINITY,
+				found ? static_cast<double>(colors[c].Pixels) : 0.0);
+		}
+		bench.Check(extract);
+		bench.Check(extractPool);
+	}
+
+	// GamutMap on the Lab grid against the double reference: the mask agrees with
+	// the reference RGB (colors within kGamutEpsilon of the boundary test either
+	// way), chroma reduction keeps L and hue (as the dH distance) and lands in gamut,
+	// the pool the same as serial
+	void VerifyGamut(Bench& bench)
+	{
+		const ConversionPlan plan(RgbEnum::sRGB, IlluminantEnum::D50, AdaptationEnum::amBradford,
+			AccuracyEnum::Exact);
+		const GamutMap gamut(plan);
+		const std::vector<float> lab = MakeGrid(ModelEnum::Lab, true);
+		const size_t n = lab.size() / 3;
+		std::vector<float> rgb(lab.size()), poolRgb(lab.size());
+		std::vector<uint8_t> mask(n), poolMask(n);
+		gamut.Map(ModelEnum::Lab, lab.data(), rgb.data(), mask.data(), n);
+		ThreadPool pool;
+		gamut.Map(pool, ModelEnum::Lab, lab.data(), poolRgb.data(), poolMask.data(), n);
+
+		AccuracyCheck test("gamut_test", "abs", 0.0);
+		AccuracyCheck chroma("gamut_chroma_lh", "abs", kGamutLabTolerance);
+		AccuracyCheck inside("gamut_chroma_range", "abs", 0.0);
+		AccuracyCheck parallel("gamut_chroma_pool", "abs", 0.0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			const float* c = &lab[i * 3];
+			double ref[3];
+			ReferenceConvert(ModelEnum::Lab, ModelEnum::Rgb, c, ref);
+			double excess = 0.0;
+			for (int j = 0; j < 3; ++j)
+				excess = std::max(excess, std::max(-ref[j], ref[j] - 1.0));
+			if (std::fabs(excess - kGamutEpsilon) > kGamutEpsilon)
+				test.Add(static_cast<double>(mask[i]), excess > kGamutEpsilon ? 1.0 : 0.0);
+
+			for (int j = 0; j < 3; ++j)
+			{
+				const double v = rgb[i * 3 + j];
+				inside.Add(std::min(std::max(v, 0.0), 1.0), v);
+				parallel.Add(poolRgb[i * 3 + j], rgb[i * 3 + j]);
+			}
+			parallel.Add(static_cast<double>(poolMask[i]), static_cast<double>(mask[i]));
+			if (mask[i] == 0)
+				continue;
+			double mapped[3];
+			ReferenceConvert(ModelEnum::Rgb, ModelEnum::Lab, &rgb[i * 3], mapped);
+			// hue difference as a distance at the mapped chroma
+			const double hue = std::atan2(c[1] * mapped[2] - c[2] * mapped[1], c[1] * mapped[1] + c[2] * mapped[2]);
+			const double chromaMapped = std::sqrt(mapped[1] * mapped[1] + mapped[2] * mapped[2]);
+			chroma.Add(mapped[0], std::min(std::max(static_cast<double>(c[0]), 0.0), 100.0));
+			chroma.Add(std::fabs(2.0 * chromaMapped * std::sin(0.5 * hue)), 0.0);
+		}
+		bench.Check(test);
+		bench.Check(chroma);
+		bench.Check(inside);
+		bench.Check(parallel);
+	}
+
+	// ConversionCache against ConvertBuffer on the Exact plan, where a batch and a lone
+	// color convert the same: cold and warm, a cache too small for the image (evicting
+	// all along) and the pool; 8 fractional bits against the conversion of the rounded colors
+	void VerifyCache(Bench& bench)
+	{
+		const ConversionPlan& plan = GetDefaultPlan();
+		const size_t n = 1 << 18;
+		const std::vector<uint8_t> codes = MakePaletteImage(n, 4096);
+		std::vector<float> rgb(codes.begin(), codes.end());
+		for (float& v : rgb)
+			v /= 255.0f;
+		std::vector<float> ref(n * 3), out(n * 3);
+
+		ConvertBuffer(plan, ModelEnum::Lab, codes.data(), ref.data(), n);
+		ConversionCache cache;
+		AccuracyCheck codesCheck("cache_u8_2lab", "abs", 0.0);
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			cache.Convert(plan, ModelEnum::Lab, codes.data(), out.data(), n);
+			for (size_t i = 0; i < n * 3; ++i)
+				codesCheck.Add(out[i], ref[i]);
+		}
+		bench.Check(codesCheck);
+
+		CacheOptions small;
+		small.Capacity = 1024;
+		ConversionCache evicting(small);
+		ThreadPool pool;
+		AccuracyCheck evictCheck("cache_u8_2lab_evict_pool", "abs", 0.0);
+		evicting.Convert(pool, plan, ModelEnum::Lab, codes.data(), out.data(), n);
+		for (size_t i = 0; i < n * 3; ++i)
+			evictCheck.Add(out[i], ref[i]);
+		bench.Check(evictCheck);
+
+		ConvertBuffer(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), ref.data(), n);
+		AccuracyCheck floatCheck("cache_rgb2lab", "abs", 0.0);
+		cache.Convert(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), out.data(), n);
+		for (size_t i = 0; i < n * 3; ++i)
+			floatCheck.Add(out[i], ref[i]);
+		bench.Check(floatCheck);
+
+		CacheOptions rounded;
+		rounded.Bits = 8;
+		ConversionCache quantized(rounded);
+		std::vector<float> steps(rgb.size());
+		for (size_t i = 0; i < rgb.size(); ++i)
+			steps[i] = std::round(rgb[i] * 256.0f) / 256.0f;
+		ConvertBuffer(plan, ModelEnum::Rgb, ModelEnum::Lab, steps.data(), ref.data(), n);
+		AccuracyCheck roundCheck("cache_rgb2lab_bits8", "abs", 0.0);
+		quantized.Convert(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb.data(), out.data(), n);
+		for (size_t i = 0; i < n * 3; ++i)
+			roundCheck.Add(out[i], ref[i]);
+		bench.Check(roundCheck);
+	}
+
+	// the reference path with HSV: GetHSPVL / GetRGBfromHSV on the RGB side of it
+	void ReferenceModel(ModelEnum src, ModelEnum dst, const double in[3], double out[3])
+	{
+		if (src == dst)
+		{
+			std::copy(in, in + 3, out);
+			return;
+		}
+		const RgbModel& model = GetRGBModel(RgbEnum::sRGB);
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		double rgb[3] = { in[0], in[1], in[2] };
+		double xyz[3] = { in[0], in[1], in[2] };
+		if (src == ModelEnum::Hsv)
+			GetRGBfromHSV<double>(in[0], in[1], in[2], rgb[0], rgb[1], rgb[2]);
+		const bool rgbSide = (src == ModelEnum::Hsv || src == ModelEnum::Rgb);
+		if (rgbSide && (dst == ModelEnum::Xyz || dst == ModelEnum::Lab))
+			RGB2XYZ<double>(rgb[0], rgb[1], rgb[2], model.GammaRGB, model, xyz[0], xyz[1], xyz[2], white);
+		else if (src == ModelEnum::Lab)
+			Lab2XYZ<double>(in[0], in[1], in[2], white, xyz[0], xyz[1], xyz[2]);
+		if (!rgbSide && (dst == ModelEnum::Rgb || dst == ModelEnum::Hsv))
+			XYZ2RGB<double>(xyz[0], xyz[1], xyz[2], white, rgb[0], rgb[1], rgb[2], model.GammaRGB, model);
+
+		double p = 0.0, l = 0.0;
+		switch (dst)
+		{
+		case ModelEnum::Hsv:
+			GetHSPVL<double>(rgb[0], rgb[1], rgb[2], out[0], out[1], p, out[2], l);
+			break;
+		case ModelEnum::Xyz:
+			std::copy(xyz, xyz + 3, out);
+			break;
+		case ModelEnum::Lab:
+			XYZ2Lab<double>(xyz[0], xyz[1], xyz[2], white, out[0], out[1], out[2]);
+			break;
+		default:
+			std::copy(rgb, rgb + 3, out);
+			break;
+		}
+	}
+
+	// hue is circular (359.9 and 0.1 are 0.2 apart) and its error is scaled by the
+	// saturation: the hue of a near gray is noise
+	void AddModel(AccuracyCheck& check, ModelEnum model, const double out[3], const double ref[3])
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			double value = out[c];
+			if (model == ModelEnum::Hsv && c == 0)
+			{
+				double dh = value - ref[c];
+				if (std::fabs(dh) > 180.0)
+					dh += (dh < 0.0) ? 360.0 : -360.0;
+				value = ref[c] + dh * ref[1];
+			}
+			check.Add(value, ref[c]);
+		}
+	}
+
+	const char* const kModelNames[kModelCount] = { "rgb", "hsv", "xyz", "lab" };
+
+	// ConvertColor along every route and Color's getters from every source model against
+	// the reference, with the luminance and lightness of a derived HSV; the sources are the
+	// reference conversions of the RGB grid, in gamut
+	void VerifyGraph(Bench& bench)
+	{
+		const std::vector<float> rgb = MakeGrid(ModelEnum::Rgb, true);
+		const ConversionPlan& plan = GetDefaultPlan();
+		AccuracyCheck color("color_getters", "abs", 1e-9);
+		AccuracyCheck hspvl("color_hsv_luminance", "abs", 1e-9);
+		for (size_t from = 0; from < kModelCount; ++from)
+		{
+			const ModelEnum src = static_cast<ModelEnum>(from);
+			for (size_t to = 0; to < kModelCount; ++to)
+			{
+				if (to == from)
+					continue;
+				const ModelEnum dst = static_cast<ModelEnum>(to);
+				AccuracyCheck check(std::string("graph_") + kModelNames[from] + "2" + kModelNames[to], "abs", 1e-9);
+				for (size_t i = 0; i < rgb.size(); i += 3)
+				{
+					const double grid[3] = { rgb[i], rgb[i + 1], rgb[i + 2] };
+					double in[3], ref[3], out[3];
+					ReferenceModel(ModelEnum::Rgb, src, grid, in);
+					ReferenceModel(src, dst, in, ref);
+					ConvertColor(plan, src, dst, in, out);
+					AddModel(check, dst, out, ref);
+				}
+				bench.Check(check);
+			}
+
+			// every getter, in model order, of a fresh color of src
+			for (size_t i = 0; i < rgb.size(); i += 3 * 61)
+			{
+				const double grid[3] = { rgb[i], rgb[i + 1], rgb[i + 2] };
+				double in[3];
+				ReferenceModel(ModelEnum::Rgb, src, grid, in);
+				Color clr;
+				switch (src)
+				{
+				case ModelEnum::Hsv:
+					clr = Color(HsvColor(in[0], in[1], in[2]));
+					break;
+				case ModelEnum::Xyz:
+					clr = Color(XyzColor(in[0], in[1], in[2]));
+					break;
+				case ModelEnum::Lab:
+					clr = Color(LabColor(in[0], in[1], in[2]));
+					break;
+				default:
+					clr = Color(RgbColor(in[0], in[1], in[2]));
+					break;
+				}
+				const RgbColor r = clr.GetRGB();
+				const HsvColor h = clr.GetHSV();
+				const XyzColor x = clr.GetXYZ();
+				const LabColor l = clr.GetLAB();
+				const double outs[kModelCount][3] = { { r.GetRed(), r.GetGreen(), r.GetBlue() },
+					{ h.GetHue(), h.GetSaturation(), h.GetValue() }, { x.GetX(), x.GetY(), x.GetZ() },
+					{ l.GetL(), l.GetA(), l.GetB() } };
+				for (size_t m = 0; m < kModelCount; ++m)
+				{
+					double ref[3];
+					ReferenceModel(src, static_cast<ModelEnum>(m), in, ref);
+					AddModel(color, static_cast<ModelEnum>(m), outs[m], ref);
+				}
+
+				// luminance and lightness of the HSV derived from another model: the
+				// GetHSPVL values of its RGB, not a round trip through GetRGBfromHSV
+				if (src != ModelEnum::Hsv)
+				{
+					double ref[3], hue = 0.0, sat = 0.0, p = 0.0, v = 0.0, light = 0.0;
+					ReferenceModel(src, ModelEnum::Rgb, in, ref);
+					GetHSPVL<double>(ref[0], ref[1], ref[2], hue, sat, p, v, light);
+					HsvColor hsv = clr.GetHSV();
+					hspvl.Add(hsv.GetLuminance(), p);
+					hspvl.Add(hsv.GetLightness(), light);
+				}
+			}
+		}
+		bench.Check(color);
+		bench.Check(hspvl);
+	}
+
+	// evaluated by the compiler: these have to be constant expressions
+	constexpr RgbColor kConstexprRgb[] = { RgbColor(1.0, 1.0, 1.0), RgbColor(0.0, 0.0, 0.0),
+		RgbColor(1.0, 0.0, 0.0), RgbColor(0.0, 1.0, 0.0), RgbColor(0.0, 0.0, 1.0), RgbColor(0.2, 0.5, 0.9) };
+	constexpr LabColor kConstexprLab[] = { ToLab(kConstexprRgb[0]), ToLab(kConstexprRgb[1]),
+		ToLab(kConstexprRgb[2]), ToLab(kConstexprRgb[3]), ToLab(kConstexprRgb[4]), ToLab(kConstexprRgb[5]) };
+	static_assert(kConstexprLab[0].GetL() > 99.999 && kConstexprLab[0].GetL() < 100.001, "constexpr white");
+
+	// the constexpr conversions against the runtime double ones, one working space per
+	// companding curve; the compile-time table against Color
+	void VerifyConstexpr(Bench& bench)
+	{
+		const XYZ white = GetRefWhite(IlluminantEnum::D50);
+		const std::vector<float> rgb = MakeGrid(ModelEnum::Rgb);
+		const std::vector<float> lab = MakeGrid(ModelEnum::Lab);
+		for (RgbEnum space : { RgbEnum::sRGB, RgbEnum::AdobeRgb, RgbEnum::ProPhotoRgb, RgbEnum::EciRgb2 })
+		{
+			const RgbModel& model = GetRGBModel(space);
+			const std::string name = kRgbNames[static_cast<size_t>(space)];
+			AccuracyCheck toLab("constexpr_rgb2lab_" + name, "abs", 1e-11);
+			AccuracyCheck toRgb("constexpr_lab2rgb_" + name, "abs", 1e-11);
+			for (size_t i = 0; i < rgb.size(); i += 3)
+			{
+				double xyz[3], ref[3], out[3];
+				RGB2XYZ<double>(rgb[i], rgb[i + 1], rgb[i + 2], model.GammaRGB, model, xyz[0], xyz[1], xyz[2], white);
+				XYZ2Lab<double>(xyz[0], xyz[1], xyz[2], white, ref[0], ref[1], ref[2]);
+				RGB2XYZConst<double>(rgb[i], rgb[i + 1], rgb[i + 2], model.GammaRGB, model, xyz[0], xyz[1], xyz[2], white);
+				XYZ2LabConst<double>(xyz[0], xyz[1], xyz[2], white, out[0], out[1], out[2]);
+				AddLab(toLab, out, ref);
+
+				Lab2XYZ<double>(lab[i], lab[i + 1], lab[i + 2], white, xyz[0], xyz[1], xyz[2]);
+				XYZ2RGB<double>(xyz[0], xyz[1], xyz[2], white, ref[0], ref[1], ref[2], model.GammaRGB, model);
+				Lab2XYZConst<double>(lab[i], lab[i + 1], lab[i + 2], white, xyz[0], xyz[1], xyz[2]);
+				XYZ2RGBConst<double>(xyz[0], xyz[1], xyz[2], white, out[0], out[1], out[2], model.GammaRGB, model);
+				for (int c = 0; c < 3; ++c)
+					toRgb.Add(out[c], ref[c]);
+			}
+			bench.Check(toLab);
+			bench.Check(toRgb);
+		}
+
+		AccuracyCheck table("constexpr_table", "abs", 1e-11);
+		for (size_t i = 0; i < sizeof(kConstexprRgb) / sizeof(kConstexprRgb[0]); ++i)
+		{
+			const LabColor ref = Color(kConstexprRgb[i]).GetLAB();
+			const double expected[3] = { ref.GetL(), ref.GetA(), ref.GetB() };
+			const double out[3] = { kConstexprLab[i].GetL(), kConstexprLab[i].GetA(), kConstexprLab[i].GetB() };
+			AddLab(table, out, expected);
+		}
+		bench.Check(table);
+	}
+
+	// A, C, D50 to D75 and E as in GetRefWhite (C from its 10 nm table: 2e-3)
+	const IlluminantEnum kSpectralIlluminants[] = { IlluminantEnum::A, IlluminantEnum::C, IlluminantEnum::D50,
+		IlluminantEnum::D55, IlluminantEnum::D65, IlluminantEnum::D75, IlluminantEnum::E };
+	const char* const kSpectralNames[] = { "a", "c", "d50", "d55", "d65", "d75", "e" };
+	const double kSpectralWhiteTolerance = 5e-4;
+
+	void AddSpectral(AccuracyCheck& check, const XyzColor& xyz, const XyzColor& ref)
+	{
+		check.Add(xyz.GetX(), ref.GetX());
+		check.Add(xyz.GetY(), ref.GetY());
+		check.Add(xyz.GetZ(), ref.GetZ());
+	}
+
+	// SpectralTable: the perfect reflector at 5, 10 and 20 nm against the GetRefWhite
+	// whites; spectra linear between 20 nm knots, which every sampling integrates
+	// exactly, and smooth ones (the sampling error) against their 5 nm integration;
+	// the SIMD kernels of every level and the pool against the double Integrate
+	void VerifySpectral(Bench& bench)
+	{
+		const int intervals[] = { 5, 10, 20 };
+		for (size_t w = 0; w < sizeof(kSpectralIlluminants) / sizeof(kSpectralIlluminants[0]); ++w)
+		{
+			const IlluminantEnum illuminant = kSpectralIlluminants[w];
+			const XYZ ref = GetRefWhite(illuminant);
+			AccuracyCheck white(std::string("spectral_white_") + kSpectralNames[w], "abs",
+				(illuminant == IlluminantEnum::C) ? 2e-3 : kSpectralWhiteTolerance);
+			for (int interval : intervals)
+			{
+				const size_t bands = (kSpectralLast - kSpectralFirst) / interval + 1;
+				const SpectralTable table(illuminant, ObserverEnum::Cie1931, kSpectralFirst, interval, bands);
+				const std::vector<double> ones(bands, 1.0);
+				AddSpectral(white, table.Integrate(ones.data()), XyzColor(ref.X, ref.Y, ref.Z));
+			}
+			bench.Check(white);
+		}
+		// ASTM E308 10 degree D65
+		AccuracyCheck white10("spectral_white_d65_10deg", "abs", kSpectralWhiteTolerance);
+		const SpectralTable table10(IlluminantEnum::D65, ObserverEnum::Cie1964, kSpectralFirst, 5, kSpectralSamples);
+		const std::vector<double> ones(kSpectralSamples, 1.0);
+		AddSpectral(white10, table10.Integrate(ones.data()), XyzColor(0.94811, 1.0, 1.07304));
+		bench.Check(white10);
+
+		// knots every 20 nm; 360 to 830 nm every 10 nm covers the skipped bands
+		const int formats[][3] = { { 380, 10, 41 }, { 380, 20, 21 }, { 360, 10, 48 } };
+		const double smoothTolerance[] = { 5e-3, 3e-2, 5e-3 };
+		for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+		{
+			const int first = formats[f][0], interval = formats[f][1];
+			const size_t bands = static_cast<size_t>(formats[f][2]);
+			const std::string name = "spectral_" + std::to_string(first) + "_" + std::to_string(interval) + "nm_";
+			AccuracyCheck linear(name + "linear", "abs", 1e-12);
+			AccuracyCheck smooth(name + "smooth", "abs", smoothTolerance[f]);
+			for (ObserverEnum observer : { ObserverEnum::Cie1931, ObserverEnum::Cie1964 })
+				for (IlluminantEnum illuminant : { IlluminantEnum::A, IlluminantEnum::D50, IlluminantEnum::D65 })
+				{
+					const SpectralTable ref(illuminant, observer, kSpectralFirst, kSpectralInterval, kSpectralSamples);
+					const SpectralTable table(illuminant, observer, first, interval, bands);
+					std::vector<double> fine(kSpectralSamples), coarse(bands);
+					for (int k = 0; k < 64; ++k)
+					{
+						// knot values in [0, 1], constant past the ends
+						double knots[21];
+						for (int j = 0; j < 21; ++j)
+							knots[j] = static_cast<double>(((k * 21 + j) * 2654435761u) % 1000) / 999.0;
+						auto knotted = [&](double nm)
+						{
+							const double t = std::min(std::max((nm - 380.0) / 20.0, 0.0), 20.0);
+							const int j = std::min(static_cast<int>(t), 19);
+							return knots[j] + (t - j) * (knots[j + 1] - knots[j]);
+						};
+						// periods of 120 to 372 nm
+						auto wave = [&](double nm)
+						{
+							return 0.5 + 0.45 * std::sin(2.0 * 3.14159265358979 * (nm - 380.0) / (120.0 + 4.0 * k) + k);
+						};
+						for (size_t i = 0; i < kSpectralSamples; ++i)
+							fine[i] = knotted(kSpectralFirst + kSpectralInterval * double(i));
+						for (size_t i = 0; i < bands; ++i)
+							coarse[i] = knotted(first + interval * double(i));
+						AddSpectral(linear, table.Integrate(coarse.data()), ref.Integrate(fine.data()));
+						for (size_t i = 0; i < kSpectralSamples; ++i)
+							fine[i] = wave(kSpectralFirst + kSpectralInterval * double(i));
+						for (size_t i = 0; i < bands; ++i)
+							coarse[i] = wave(first + interval * double(i));
+						AddSpectral(smooth, table.Integrate(coarse.data()), ref.Integrate(fine.data()));
+					}
+				}
+			bench.Check(linear);
+			bench.Check(smooth);
+		}
+
+		// a 121 band cube, an odd count of spectra for the tails
+		const SpectralTable cube(IlluminantEnum::D65, ObserverEnum::Cie1931, 380, 5, 121);
+		const size_t bands = cube.GetBands();
+		const size_t n = 4099;
+		std::vector<float> bip(n * bands), bsq(n * bands);
+		for (size_t i = 0; i < bip.size(); ++i)
+			bip[i] = static_cast<float>((i * 2654435761u) % 1000) / 999.0f;
+		for (size_t i = 0; i < n; ++i)
+			for (size_t b = 0; b < bands; ++b)
+				bsq[b * n + i] = bip[i * bands + b];
+		std::vector<XyzColor> ref;
+		std::vector<double> spectrum(bands);
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t b = 0; b < bands; ++b)
+				spectrum[b] = bip[i * bands + b];
+			ref.push_back(cube.Integrate(spectrum.data()));
+		}
+		size_t lo = 0, count = 0;
+		const float* weights = cube.GetWeights(lo, count);
+		for (int level = 0; level <= static_cast<int>(GetSimdSupport()); ++level)
+		{
+			const SimdKernels& kernels = GetSimdKernels(static_cast<SimdEnum>(level));
+			const std::string prefix = std::string("simd_") + kSimdNames[level] + "_spectral_";
+			AccuracyCheck interleaved(prefix + "interleaved", "abs", kSimdSpectralTolerance);
+			AccuracyCheck planar(prefix + "planar", "abs", kSimdSpectralTolerance);
+			std::vector<float> c[3];
+			for (int k = 0; k < 3; ++k)
+				c[k].assign(n, 0.0f);
+			kernels.SpectralInterleaved(weights, count, bip.data() + lo, bands, c[0].data(), c[1].data(),
+				c[2].data(), n);
+			for (size_t i = 0; i < n; ++i)
+				AddSpectral(interleaved, XyzColor(c[0][i], c[1][i], c[2][i]), ref[i]);
+			kernels.SpectralPlanar(weights, count, bsq.data() + lo * n, n, c[0].data(), c[1].data(),
+				c[2].data(), n);
+			for (size_t i = 0; i < n; ++i)
+				AddSpectral(planar, XyzColor(c[0][i], c[1][i], c[2][i]), ref[i]);
+			bench.Check(interleaved);
+			bench.Check(planar);
+		}
+
+		// the pool against the serial result, small tiles (whole chunks, the same tails)
+		ThreadPool pool(4);
+		AccuracyCheck parallel("spectral_pool", "abs", 0.0);
+		std::vector<float> serial(n * 3), tiled(n * 3);
+		cube.Integrate(bip.data(), serial.data(), n);
+		cube.Integrate(pool, bip.data(), tiled.data(), n, LayoutEnum::Interleaved, 512);
+		for (size_t i = 0; i < n * 3; ++i)
+			parallel.Add(tiled[i], serial[i]);
+		cube.Integrate(bsq.data(), serial.data(), n, LayoutEnum::Planar);
+		cube.Integrate(pool, bsq.data(), tiled.data(), n, LayoutEnum::Planar, 512);
+		for (size_t i = 0; i < n * 3; ++i)
+			parallel.Add(tiled[i], serial[i]);
+		bench.Check(parallel);
+	}
+
+	// CCT and Duv by their definition: the closest point of the Planckian locus in
+	// (u, v), a 5 mired scan, then golden section in mired
+	void ReferenceCct(const double xyz[3], double& cct, double& duv)
+	{
+		const double den = xyz[0] + 15.0 * xyz[1] + 3.0 * xyz[2];
+		const double u = 4.0 * xyz[0] / den, v = 6.0 * xyz[1] / den;
+		auto distance = [&](double mired)
+		{
+			double pu, pv;
+			GetPlanckianUV(1e6 / mired, pu, pv);
+			return (u - pu) * (u - pu) + (v - pv) * (v - pv);
+		};
+		const double lo = 1e6 / kCctMax, hi = 1e6 / kCctMin;
+		double best = lo, bestDistance = distance(lo);
+		for (double m = lo + 5.0; m <= hi; m += 5.0)
+		{
+			const double d = distance(m);
+			if (d < bestDistance)
+			{
+				best = m;
+				bestDistance = d;
+			}
+		}
+		double a = std::max(lo, best - 5.0), b = std::min(hi, best + 5.0);
+		for (int i = 0; i < 60; ++i)
+		{
+			const double c = b - 0.6180339887498949 * (b - a), d = a + 0.6180339887498949 * (b - a);
+			if (distance(c) < distance(d))
+				b = d;
+			else
+				a = c;
+		}
+		const double mired = 0.5 * (a + b);
+		double pu, pv, pu1, pv1;
+		GetPlanckianUV(1e6 / mired, pu, pv);
+		GetPlanckianUV(1e6 / (mired + 0.01), pu1, pv1);
+		cct = 1e6 / mired;
+		duv = std::sqrt(distance(mired));
+		// above the locus: left of the tangent towards higher mired
+		duv = ((u - pu) * -(pv1 - pv) + (v - pv) * (pu1 - pu) < 0.0) ? -duv : duv;
+	}
+
+	// CCT of the GetRefWhite whites against the CCTs of the illuminants (the whites
+	// are rounded and come from other tables: a few K); XYZ2CCT against ReferenceCct
+	// from 1000 to 100000 K and |Duv| up to 0.05, CCT in mired; CCTBuffer layouts and pool
+	void VerifyCct(Bench& bench)
+	{
+		// the worst white, F2, is 5.39 K off
+		const double kCctWhiteTolerance = 5.4;
+		const char* const names[] = { "a", "b", "c", "d50", "d55", "d65", "d75", "e", "f2", "f7", "f11" };
+		const double ccts[] = { 2856.0, 4874.0, 6774.0, 5003.0, 5503.0, 6504.0, 7504.0, 5454.0, 4230.0,
+			6500.0, 4000.0 };
+		for (size_t i = 0; i < sizeof(ccts) / sizeof(ccts[0]); ++i)
+		{
+			AccuracyCheck white(std::string("cct_white_") + names[i], "abs", kCctWhiteTolerance);
+			const XYZ w = GetRefWhite(static_cast<IlluminantEnum>(i));
+			double cct, duv;
+			XYZ2CCT(w.X, w.Y, w.Z, cct, duv);
+			white.Add(cct, ccts[i]);
+			bench.Check(white);
+		}
+
+		AccuracyCheck mired("cct_mired", "abs", 2e-3);
+		AccuracyCheck offset("cct_duv", "abs", 1e-6);
+		std::vector<float> xyz;
+		for (double T = kCctMin; T <= kCctMax; T *= 1.03)
+			for (int k = -5; k <= 5; ++k)
+			{
+				double c[3], cct, duv, refCct, refDuv;
+				MakeLightXyz(T, 0.01 * k, c);
+				XYZ2CCT(c[0], c[1], c[2], cct, duv);
+				ReferenceCct(c, refCct, refDuv);
+				mired.Add(1e6 / cct, 1e6 / refCct);
+				offset.Add(duv, refDuv);
+				for (int j = 0; j < 3; ++j)
+					xyz.push_back(static_cast<float>(c[j]));
+			}
+		bench.Check(mired);
+		bench.Check(offset);
+
+		const size_t n = xyz.size() / 3;
+		std::vector<float> planes(n * 3);
+		for (size_t i = 0; i < n; ++i)
+			for (size_t k = 0; k < 3; ++k)
+				planes[k * n + i] = xyz[i * 3 + k];
+		std::vector<float> cct(n), duv(n), cct2(n), duv2(n);
+		CCTBuffer(xyz.data(), cct.data(), duv.data(), n);
+		ThreadPool pool(4);
+		AccuracyCheck layouts("cct_buffers", "abs", 0.0);
+		CCTBuffer(planes.data(), cct2.data(), duv2.data(), n, LayoutEnum::Planar);
+		for (size_t i = 0; i < n; ++i)
+		{
+			layouts.Add(cct2[i], cct[i]);
+			layouts.Add(duv2[i], duv[i]);
+		}
+		CCTBuffer(pool, xyz.data(), cct2.data(), duv2.data(), n, LayoutEnum::Interleaved, 97);
+		for (size_t i = 0; i < n; ++i)
+		{
+			layouts.Add(cct2[i], cct[i]);
+			layouts.Add(duv2[i], duv[i]);
+		}
+		bench.Check(layouts);
+	}
+
+	// the built-in spaces through the registry against ConversionPlan, Display P3 against
+	// its published matrix, the handles and cached plans, ConvertSpaces against RGB -> XYZ
+	// -> RGB of the two plans in double, Color on a registered plan
+	void VerifyRegistry(Bench& bench)
+	{
+		AccuracyCheck builtin("registry_builtin", "abs", 0.0);
+		for (size_t s = 0; s < kRgbModelCount; ++s)
+		{
+			const ConversionPlan ref(static_cast<RgbEnum>(s));
+			const ConversionPlan& plan = GetColorSpacePlan(static_cast<ColorSpaceHandle>(s));
+			for (int i = 0; i < 3; ++i)
+				for (int j = 0; j < 3; ++j)
+				{
+					builtin.Add(plan.GetRGB2XYZ().m[i][j], ref.GetRGB2XYZ().m[i][j]);
+					builtin.Add(plan.GetXYZ2RGB().m[i][j], ref.GetXYZ2RGB().m[i][j]);
+				}
+		}
+		bench.Check(builtin);
+
+		// XYZ = M rgb, the published figures to 8 decimals
+		const double kP3[3][3] = { { 0.48657095, 0.26566769, 0.19821729 },
+			{ 0.22897456, 0.69173852, 0.07928691 }, { 0.0, 0.04511338, 1.04394437 } };
+		const ColorSpaceHandle p3 = RegisterColorSpace(MakeDisplayP3());
+		AccuracyCheck matrix("registry_p3_matrix", "abs", 1e-8);
+		const ConversionPlan& native = GetColorSpacePlan(p3, IlluminantEnum::D65, AdaptationEnum::amNone);
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				matrix.Add(native.GetRGB2XYZ().m[j][i], kP3[i][j]);
+		bench.Check(matrix);
+
+		// a new space gets a new handle, a known one its handle back, collinear primaries
+		// or a gamma that is not finite none
+		ColorSpaceDesc srgb;
+		srgb.xr = 0.64;
+		srgb.yr = 0.33;
+		srgb.xg = 0.30;
+		srgb.yg = 0.60;
+		srgb.xb = 0.15;
+		srgb.yb = 0.06;
+		srgb.White = GetRGBModel(RgbEnum::sRGB).RefWhiteRGB;
+		srgb.Gamma = -2.2;
+		ColorSpaceDesc line = MakeDisplayP3();
+		line.xb = 0.5 * (line.xr + line.xg);
+		line.yb = 0.5 * (line.yr + line.yg);
+		ColorSpaceDesc noGamma = MakeDisplayP3();
+		noGamma.Gamma = NAN;
+		ColorSpaceDesc infGamma = MakeDisplayP3();
+		infGamma.Gamma = INFINITY;
+		AccuracyCheck handles("registry_handles", "abs", 0.0);
+		const ColorSpaceHandle got[] = { RegisterColorSpace(MakeDisplayP3()), RegisterColorSpace(srgb),
+			RegisterColorSpace(line), RegisterColorSpace(noGamma), RegisterColorSpace(infGamma),
+			GetColorSpacePlan(p3, IlluminantEnum::D65).GetSpace(), GetColorSpacePlan(kColorSpaceNone).GetSpace() };
+		const ColorSpaceHandle expected[] = { p3, static_cast<ColorSpaceHandle>(RgbEnum::sRGB), kColorSpaceNone,
+			kColorSpaceNone, kColorSpaceNone, p3, static_cast<ColorSpaceHandle>(RgbEnum::sRGB) };
+		for (size_t i = 0; i < sizeof(got) / sizeof(got[0]); ++i)
+			handles.Add(static_cast<double>(got[i]), static_cast<double>(expected[i]));
+		handles.Add((p3 >= kRgbModelCount && p3 < GetColorSpaceCount()) ? 1.0 : 0.0, 1.0);
+		const ConversionPlan* first = &GetColorSpacePlan(p3, IlluminantEnum::D65);
+		handles.Add((first == &GetColorSpacePlan(p3, IlluminantEnum::D65)) ? 1.0 : 0.0, 1.0);
+		// out of range settings get the default plan
+		const ConversionPlan& unknown = GetColorSpacePlan(p3, static_cast<IlluminantEnum>(99),
+			static_cast<AdaptationEnum>(7), static_cast<AccuracyEnum>(-1));
+		handles.Add((&unknown == &GetColorSpacePlan(p3)) ? 1.0 : 0.0, 1.0);
+		bench.Check(handles);
+
+		const ColorSpaceHandle adobe = static_cast<ColorSpaceHandle>(RgbEnum::AdobeRgb);
+		const std::vector<float> rgb = MakeGrid(ModelEnum::Rgb);
+		const size_t n = rgb.size() / 3;
+		const ConversionPlan& from = GetColorSpacePlan(p3);
+		const ConversionPlan& to = GetColorSpacePlan(adobe);
+		std::vector<double> ref(rgb.size());
+		for (size_t i = 0; i < rgb.size(); i += 3)
+		{
+			double x, y, z;
+			from.RGB2XYZ(rgb[i], rgb[i + 1], rgb[i + 2], x, y, z);
+			to.XYZ2RGB(x, y, z, ref[i], ref[i + 1], ref[i + 2]);
+		}
+		std::vector<float> out(rgb.size());
+		for (int a = 0; a < 3; ++a)
+		{
+			AccuracyCheck check(std::string("registry_p3_to_adobe_") + kAccuracyNames[a], "abs", kRegistryTolerance[a]);
+			ConvertSpaces(p3, adobe, rgb.data(), out.data(), n, LayoutEnum::Interleaved, AdaptationEnum::amBradford,
+				static_cast<AccuracyEnum>(a));
+			for (size_t i = 0; i < rgb.size(); ++i)
+				check.Add(out[i], ref[i]);
+			bench.Check(check);
+		}
+
+		// planar and the pool against the interleaved result, bit for bit
+		ConvertSpaces(p3, adobe, rgb.data(), out.data(), n, LayoutEnum::Interleaved, AdaptationEnum::amBradford,
+			AccuracyEnum::High);
+		std::vector<float> planes(rgb.size()), out2(rgb.size());
+		for (size_t i = 0; i < n; ++i)
+			for (size_t k = 0; k < 3; ++k)
+				planes[k * n + i] = rgb[i * 3 + k];
+		AccuracyCheck layouts("registry_buffers", "abs", 0.0);
+		ConvertSpaces(p3, adobe, planes.data(), out2.data(), n, LayoutEnum::Planar, AdaptationEnum::amBradford,
+			AccuracyEnum::High);
+		for (size_t i = 0; i < n; ++i)
+			for (size_t k = 0; k < 3; ++k)
+				layouts.Add(out2[k * n + i], out[i * 3 + k]);
+		ThreadPool pool(4);
+		ConvertSpaces(pool, p3, adobe, rgb.data(), out2.data(), n, LayoutEnum::Interleaved, AdaptationEnum::amBradford,
+			AccuracyEnum::High, 512);
+		for (size_t i = 0; i < rgb.size(); ++i)
+			layouts.Add(out2[i], out[i]);
+		bench.Check(layouts);
+
+		AccuracyCheck color("registry_color", "abs", 1e-12);
+		for (size_t i = 0; i < rgb.size(); i += 3 * 97)
+		{
+			Color c(RgbColor(rgb[i], rgb[i + 1], rgb[i + 2]), from);
+			const XyzColor xyz = c.GetXYZ();
+			double x, y, z;
+			from.RGB2XYZ(rgb[i], rgb[i + 1], rgb[i + 2], x, y, z);
+			color.Add(xyz.GetX(), x);
+			color.Add(xyz.GetY(), y);
+			color.Add(xyz.GetZ(), z);
+		}
+		bench.Check(color);
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if (arg == "--quick")
+			options.MinTime = 0.0;
+		else if (arg == "--verify")
+			options.Verify = true;
+		else if (arg == "--filter" && i + 1 < argc)
+			options.Filter = argv[++i];
+		else if (arg == "--min-time" && i + 1 < argc)
+			options.MinTime = atof(argv[++i]) / 1000.0;
+		else if (arg == "--out" && i + 1 < argc)
+			options.Out = argv[++i];
+		else
+		{
+			std::cerr << "usage: colorcalc_bench [--quick] [--verify] [--filter text] [--min-time ms] [--out file]\n";
+			return 2;
+		}
+	}
+
+	Bench bench(options);
+	if (options.Verify)
+	{
+		VerifyCompand(bench);
+		VerifyLab(bench);
+		VerifySimd(bench);
+		VerifyBuffers(bench);
+		VerifyThroughput(bench);
+		VerifyPalette(bench);
+		VerifyGamut(bench);
+		VerifyCache(bench);
+		VerifyConstexpr(bench);
+		VerifyGraph(bench);
+		VerifySpectral(bench);
+		VerifyCct(bench);
+		VerifyRegistry(bench);
+	}
+	else
+	{
+		BenchScalar(bench);
+		BenchColor(bench);
+		BenchBuffers(bench);
+		BenchPalette(bench);
+		BenchGamut(bench);
+		BenchCache(bench);
+		BenchSpectral(bench);
+		BenchCct(bench);
+		BenchRegistry(bench);
+	}
+
+	if (options.Out == "-")
+	{
+		bench.Write(std::cout);
+	}
+	else
+	{
+		std::ofstream out(options.Out);
+		bench.Write(out);
+		if (!out)
+		{
+			std::cerr << "can't write " << options.Out << "\n";
+			return 2;
+		}
+	}
+	return bench.IsFailed() ? 1 : 0;
+}
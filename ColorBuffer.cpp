@@ -0,0 +1,547 @@
+#include "ColorBuffer.h"
+#include "ColorPlan.h"
+#include "ColorCompand.h"
+#include "ColorSimd.h"
+#include "ColorPool.h"
+
+namespace COLORNS
+{
+	namespace
+	{
+		// pixels converted per pass, the scratch planes stay in L1
+		constexpr size_t kChunk = 256;
+
+		// Exact plans convert in double (pow() companding, the pow-free Lab kernels
+		// that match the reference to ~1e-12), the faster tiers in float through the SIMD kernels
+		template <typename T>
+		struct Planes
+		{
+			T c1[kChunk];
+			T c2[kChunk];
+			T c3[kChunk];
+		};
+
+		// models are connected in a chain: HSV - RGB - XYZ - Lab
+		int ChainPos(ModelEnum model)
+		{
+			switch (model)
+			{
+			case ModelEnum::Hsv:
+				return 0;
+			case ModelEnum::Rgb:
+				return 1;
+			case ModelEnum::Xyz:
+				return 2;
+			default:
+			case ModelEnum::Lab:
+				return 3;
+			}
+		}
+	}
+
+	void GetModelRange(ModelEnum model, float lo[3], float hi[3])
+	{
+		switch (model)
+		{
+		case ModelEnum::Hsv:
+			lo[0] = 0.0f; hi[0] = 360.0f;
+			lo[1] = 0.0f; hi[1] = 1.0f;
+			lo[2] = 0.0f; hi[2] = 1.0f;
+			break;
+		case ModelEnum::Xyz:
+			lo[0] = 0.0f; hi[0] = 1.25f;
+			lo[1] = 0.0f; hi[1] = 1.0f;
+			lo[2] = 0.0f; hi[2] = 1.25f;
+			break;
+		case ModelEnum::Lab:
+			lo[0] = 0.0f; hi[0] = 100.0f;
+			lo[1] = -128.0f; hi[1] = 128.0f;
+			lo[2] = -128.0f; hi[2] = 128.0f;
+			break;
+		default:
+		case ModelEnum::Rgb:
+			for (int i = 0; i < 3; ++i)
+			{
+				lo[i] = 0.0f;
+				hi[i] = 1.0f;
+			}
+			break;
+		}
+	}
+
+	namespace
+	{
+		template <typename T>
+		void LoadChunk(const float* in, size_t n, size_t first, size_t count, LayoutEnum layout, Planes<T>& p)
+		{
+			if (layout == LayoutEnum::Interleaved)
+			{
+				const float* src = in + first * 3;
+				for (size_t i = 0; i < count; ++i)
+				{
+					p.c1[i] = src[i * 3];
+					p.c2[i] = src[i * 3 + 1];
+					p.c3[i] = src[i * 3 + 2];
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					p.c1[i] = in[first + i];
+					p.c2[i] = in[n + first + i];
+					p.c3[i] = in[2 * n + first + i];
+				}
+			}
+		}
+
+		template <typename T>
+		void StoreChunk(float* out, size_t n, size_t first, size_t count, LayoutEnum layout, const Planes<T>& p)
+		{
+			if (layout == LayoutEnum::Interleaved)
+			{
+				float* dst = out + first * 3;
+				for (size_t i = 0; i < count; ++i)
+				{
+					dst[i * 3] = static_cast<float>(p.c1[i]);
+					dst[i * 3 + 1] = static_cast<float>(p.c2[i]);
+					dst[i * 3 + 2] = static_cast<float>(p.c3[i]);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					out[first + i] = static_cast<float>(p.c1[i]);
+					out[n + first + i] = static_cast<float>(p.c2[i]);
+					out[2 * n + first + i] = static_cast<float>(p.c3[i]);
+				}
+			}
+		}
+
+		template <typename T>
+		void Hsv2RgbChunk(Planes<T>& p, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				T r, g, b;
+				GetRGBfromHSV(p.c1[i], p.c2[i], p.c3[i], r, g, b);
+				p.c1[i] = r;
+				p.c2[i] = g;
+				p.c3[i] = b;
+			}
+		}
+
+		template <typename T>
+		void Rgb2HsvChunk(Planes<T>& p, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				T h, s, lum, v, l;
+				GetHSPVL(p.c1[i], p.c2[i], p.c3[i], h, s, lum, v, l);
+				p.c1[i] = h;
+				p.c2[i] = s;
+				p.c3[i] = v;
+			}
+		}
+
+		void Linear2XyzChunk(Planes<double>& p, size_t count, const ConversionPlan& plan)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				double x, y, z;
+				plan.LinearRGB2XYZ(p.c1[i], p.c2[i], p.c3[i], x, y, z);
+				p.c1[i] = x;
+				p.c2[i] = y;
+				p.c3[i] = z;
+			}
+		}
+
+		void Linear2XyzChunk(Planes<float>& p, size_t count, const ConversionPlan& plan)
+		{
+			GetSimdKernels().Mtx3x3(MtxConvert3x3<float>(plan.GetRGB2XYZ()), p.c1, p.c2, p.c3, count);
+		}
+
+		void Rgb2XyzChunk(Planes<double>& p, size_t count, const ConversionPlan& plan)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				double x, y, z;
+				plan.RGB2XYZ(p.c1[i], p.c2[i], p.c3[i], x, y, z);
+				p.c1[i] = x;
+				p.c2[i] = y;
+				p.c3[i] = z;
+			}
+		}
+
+		void Rgb2XyzChunk(Planes<float>& p, size_t count, const ConversionPlan& plan)
+		{
+			const CompandApprox& compand = plan.GetCompand();
+			for (size_t i = 0; i < count; ++i)
+			{
+				p.c1[i] = static_cast<float>(compand.InvCompand(p.c1[i]));
+				p.c2[i] = static_cast<float>(compand.InvCompand(p.c2[i]));
+				p.c3[i] = static_cast<float>(compand.InvCompand(p.c3[i]));
+			}
+			Linear2XyzChunk(p, count, plan);
+		}
+
+		void Xyz2RgbChunk(Planes<double>& p, size_t count, const ConversionPlan& plan)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				double r, g, b;
+				plan.XYZ2RGB(p.c1[i], p.c2[i], p.c3[i], r, g, b);
+				p.c1[i] = r;
+				p.c2[i] = g;
+				p.c3[i] = b;
+			}
+		}
+
+		void Xyz2RgbChunk(Planes<float>& p, size_t count, const ConversionPlan& plan)
+		{
+			GetSimdKernels().Mtx3x3(MtxConvert3x3<float>(plan.GetXYZ2RGB()), p.c1, p.c2, p.c3, count);
+			const CompandApprox& compand = plan.GetCompand();
+			for (size_t i = 0; i < count; ++i)
+			{
+				p.c1[i] = static_cast<float>(compand.Compand(p.c1[i]));
+				p.c2[i] = static_cast<float>(compand.Compand(p.c2[i]));
+				p.c3[i] = static_cast<float>(compand.Compand(p.c3[i]));
+			}
+		}
+
+		void Xyz2LabChunk(Planes<double>& p, size_t count, const XYZ& white)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				double l, a, b;
+				XYZ2LabFast(p.c1[i], p.c2[i], p.c3[i], white, l, a, b);
+				p.c1[i] = l;
+				p.c2[i] = a;
+				p.c3[i] = b;
+			}
+		}
+
+		void Xyz2LabChunk(Planes<float>& p, size_t count, const XYZ& white)
+		{
+			GetSimdKernels().XYZ2Lab(white, p.c1, p.c2, p.c3, count);
+		}
+
+		void Lab2XyzChunk(Planes<double>& p, size_t count, const XYZ& white)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				double x, y, z;
+				Lab2XYZFast(p.c1[i], p.c2[i], p.c3[i], white, x, y, z);
+				p.c1[i] = x;
+				p.c2[i] = y;
+				p.c3[i] = z;
+			}
+		}
+
+		void Lab2XyzChunk(Planes<float>& p, size_t count, const XYZ& white)
+		{
+			GetSimdKernels().Lab2XYZ(white, p.c1, p.c2, p.c3, count);
+		}
+
+		template <typename T>
+		void ConvertChunk(const ConversionPlan& plan, Planes<T>& p, size_t count, int from, int to)
+		{
+			const XYZ& white = plan.GetRefWhite();
+			// walk the chain one edge at a time
+			for (int pos = from; pos != to; pos += (to > from) ? 1 : -1)
+			{
+				switch ((to > from) ? pos : -pos)
+				{
+				case 0:		// HSV -> RGB
+					Hsv2RgbChunk(p, count);
+					break;
+				case 1:		// RGB -> XYZ
+					Rgb2XyzChunk(p, count, plan);
+					break;
+				case 2:		// XYZ -> Lab
+					Xyz2LabChunk(p, count, white);
+					break;
+				case -1:	// RGB -> HSV
+					Rgb2HsvChunk(p, count);
+					break;
+				case -2:	// XYZ -> RGB
+					Xyz2RgbChunk(p, count, plan);
+					break;
+				case -3:	// Lab -> XYZ
+					Lab2XyzChunk(p, count, white);
+					break;
+				}
+			}
+		}
+
+		// colors [begin, end) of the n in the buffer
+		template <typename T>
+		void ConvertFloats(const ConversionPlan& plan,
+			ModelEnum src_model, ModelEnum dst_model,
+			const float* in, float* out, size_t n, size_t begin, size_t end,
+			LayoutEnum layout)
+		{
+			const int from = ChainPos(src_model);
+			const int to = ChainPos(dst_model);
+
+			Planes<T> p;
+			for (size_t first = begin; first < end; first += kChunk)
+			{
+				size_t count = (end - first < kChunk) ? (end - first) : kChunk;
+				LoadChunk(in, n, first, count, layout, p);
+				ConvertChunk(plan, p, count, from, to);
+				StoreChunk(out, n, first, count, layout, p);
+			}
+		}
+	}
+
+	void ConvertBuffer(ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout)
+	{
+		ConvertBuffer(GetDefaultPlan(), src_model, dst_model, in, out, n, layout);
+	}
+
+	namespace
+	{
+		void ConvertFloatRange(const ConversionPlan& plan,
+			ModelEnum src_model, ModelEnum dst_model,
+			const float* in, float* out, size_t n, size_t begin, size_t end,
+			LayoutEnum layout)
+		{
+			if (plan.GetAccuracy() == AccuracyEnum::Exact)
+				ConvertFloats<double>(plan, src_model, dst_model, in, out, n, begin, end, layout);
+			else
+				ConvertFloats<float>(plan, src_model, dst_model, in, out, n, begin, end, layout);
+		}
+	}
+
+	void ConvertBuffer(const ConversionPlan& plan,
+		ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout)
+	{
+		ConvertFloatRange(plan, src_model, dst_model, in, out, n, 0, n, layout);
+	}
+
+	namespace
+	{
+		// src_plan RGB -> dst_plan RGB in one matrix
+		Mtx3x3 GetSpaceMatrix(const ConversionPlan& src_plan, const ConversionPlan& dst_plan)
+		{
+			Mtx3x3 toXyz = src_plan.GetRGB2XYZ();
+			if (src_plan.GetIlluminant() != dst_plan.GetIlluminant() && dst_plan.GetAdaptation() != AdaptationEnum::amNone)
+			{
+				Mtx3x3 adapt;
+				GetAdaptationMatrix(src_plan.GetRefWhite(), dst_plan.GetRefWhite(), dst_plan.GetAdaptation(), adapt);
+				MtxMultiply3x3(src_plan.GetRGB2XYZ(), adapt, toXyz);
+			}
+			Mtx3x3 result;
+			MtxMultiply3x3(toXyz, dst_plan.GetXYZ2RGB(), result);
+			return result;
+		}
+
+		void Rgb2RgbChunk(Planes<double>& p, size_t count, const ConversionPlan& src_plan, const Mtx3x3& m,
+			const ConversionPlan& dst_plan)
+		{
+			const CompandApprox& from = src_plan.GetCompand();
+			const CompandApprox& to = dst_plan.GetCompand();
+			for (size_t i = 0; i < count; ++i)
+			{
+				const double r = from.InvCompand(p.c1[i]);
+				const double g = from.InvCompand(p.c2[i]);
+				const double b = from.InvCompand(p.c3[i]);
+				p.c1[i] = to.Compand(r * m.m[0][0] + g * m.m[1][0] + b * m.m[2][0]);
+				p.c2[i] = to.Compand(r * m.m[0][1] + g * m.m[1][1] + b * m.m[2][1]);
+				p.c3[i] = to.Compand(r * m.m[0][2] + g * m.m[1][2] + b * m.m[2][2]);
+			}
+		}
+
+		void Rgb2RgbChunk(Planes<float>& p, size_t count, const ConversionPlan& src_plan, const Mtx3x3& m,
+			const ConversionPlan& dst_plan)
+		{
+			const CompandApprox& from = src_plan.GetCompand();
+			for (size_t i = 0; i < count; ++i)
+			{
+				p.c1[i] = static_cast<float>(from.InvCompand(p.c1[i]));
+				p.c2[i] = static_cast<float>(from.InvCompand(p.c2[i]));
+				p.c3[i] = static_cast<float>(from.InvCompand(p.c3[i]));
+			}
+			GetSimdKernels().Mtx3x3(MtxConvert3x3<float>(m), p.c1, p.c2, p.c3, count);
+			const CompandApprox& to = dst_plan.GetCompand();
+			for (size_t i = 0; i < count; ++i)
+			{
+				p.c1[i] = static_cast<float>(to.Compand(p.c1[i]));
+				p.c2[i] = static_cast<float>(to.Compand(p.c2[i]));
+				p.c3[i] = static_cast<float>(to.Compand(p.c3[i]));
+			}
+		}
+
+		template <typename T>
+		void ConvertSpaces(const ConversionPlan& src_plan, const ConversionPlan& dst_plan,
+			const float* in, float* out, size_t n, size_t begin, size_t end,
+			LayoutEnum layout)
+		{
+			const Mtx3x3 m = GetSpaceMatrix(src_plan, dst_plan);
+			Planes<T> p;
+			for (size_t first = begin; first < end; first += kChunk)
+			{
+				size_t count = (end - first < kChunk) ? (end - first) : kChunk;
+				LoadChunk(in, n, first, count, layout, p);
+				Rgb2RgbChunk(p, count, src_plan, m, dst_plan);
+				StoreChunk(out, n, first, count, layout, p);
+			}
+		}
+
+		void ConvertSpaceRange(const ConversionPlan& src_plan, const ConversionPlan& dst_plan,
+			const float* in, float* out, size_t n, size_t begin, size_t end,
+			LayoutEnum layout)
+		{
+			if (src_plan.GetAccuracy() == AccuracyEnum::Exact && dst_plan.GetAccuracy() == AccuracyEnum::Exact)
+				ConvertSpaces<double>(src_plan, dst_plan, in, out, n, begin, end, layout);
+			else
+				ConvertSpaces<float>(src_plan, dst_plan, in, out, n, begin, end, layout);
+		}
+	}
+
+	void ConvertBuffer(const ConversionPlan& src_plan, const ConversionPlan& dst_plan,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout)
+	{
+		ConvertSpaceRange(src_plan, dst_plan, in, out, n, 0, n, layout);
+	}
+
+	namespace
+	{
+		// integer code -> linear light through table, or -> companded 0..1 when table is null
+		template <typename C>
+		double CodeValue(C code, unsigned max, const double* table)
+		{
+			unsigned c = (code > max) ? max : static_cast<unsigned>(code);
+			return table ? table[c] : static_cast<double>(c) / max;
+		}
+
+		template <typename C, typename T>
+		void LoadCodes(const C* in, size_t n, size_t first, size_t count, LayoutEnum layout,
+			unsigned max, const double* table, Planes<T>& p)
+		{
+			if (layout == LayoutEnum::Interleaved)
+			{
+				const C* src = in + first * 3;
+				for (size_t i = 0; i < count; ++i)
+				{
+					p.c1[i] = static_cast<T>(CodeValue(src[i * 3], max, table));
+					p.c2[i] = static_cast<T>(CodeValue(src[i * 3 + 1], max, table));
+					p.c3[i] = static_cast<T>(CodeValue(src[i * 3 + 2], max, table));
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					p.c1[i] = static_cast<T>(CodeValue(in[first + i], max, table));
+					p.c2[i] = static_cast<T>(CodeValue(in[n + first + i], max, table));
+					p.c3[i] = static_cast<T>(CodeValue(in[2 * n + first + i], max, table));
+				}
+			}
+		}
+
+		template <typename T, typename C>
+		void ConvertCodes(const ConversionPlan& plan, ModelEnum dst_model,
+			const C* in, int bits, float* out, size_t n, size_t begin, size_t end,
+			LayoutEnum layout)
+		{
+			const InvCompandTable& linear = GetInvCompandTable(plan.GetGamma(), bits);
+			const unsigned max = linear.GetMaxCode();
+			const int to = ChainPos(dst_model);
+			// HSV and RGB targets need the companded values only
+			const bool linearize = to > ChainPos(ModelEnum::Rgb);
+			const double* table = linearize ? linear.GetData() : nullptr;
+
+			Planes<T> p;
+			for (size_t first = begin; first < end; first += kChunk)
+			{
+				size_t count = (end - first < kChunk) ? (end - first) : kChunk;
+				LoadCodes(in, n, first, count, layout, max, table, p);
+				if (linearize)
+				{
+					Linear2XyzChunk(p, count, plan);
+					ConvertChunk(plan, p, count, ChainPos(ModelEnum::Xyz), to);
+				}
+				else
+				{
+					ConvertChunk(plan, p, count, ChainPos(ModelEnum::Rgb), to);
+				}
+				StoreChunk(out, n, first, count, layout, p);
+			}
+		}
+
+		template <typename C>
+		void ConvertCodeRange(const ConversionPlan& plan, ModelEnum dst_model,
+			const C* in, int bits, float* out, size_t n, size_t begin, size_t end,
+			LayoutEnum layout)
+		{
+			if (plan.GetAccuracy() == AccuracyEnum::Exact)
+				ConvertCodes<double>(plan, dst_model, in, bits, out, n, begin, end, layout);
+			else
+				ConvertCodes<float>(plan, dst_model, in, bits, out, n, begin, end, layout);
+		}
+	}
+
+	void ConvertBuffer(const ConversionPlan& plan, ModelEnum dst_model,
+		const uint8_t* in, float* out, size_t n,
+		LayoutEnum layout)
+	{
+		ConvertCodeRange(plan, dst_model, in, 8, out, n, 0, n, layout);
+	}
+
+	void ConvertBuffer(const ConversionPlan& plan, ModelEnum dst_model,
+		const uint16_t* in, int bits, float* out, size_t n,
+		LayoutEnum layout)
+	{
+		ConvertCodeRange(plan, dst_model, in, bits, out, n, 0, n, layout);
+	}
+
+	// tiles of the buffer run as pool tasks, each one in kChunk passes like above
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& plan,
+		ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			ConvertFloatRange(plan, src_model, dst_model, in, out, n, first, last, layout);
+		});
+	}
+
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& src_plan, const ConversionPlan& dst_plan,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			ConvertSpaceRange(src_plan, dst_plan, in, out, n, first, last, layout);
+		});
+	}
+
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& plan, ModelEnum dst_model,
+		const uint8_t* in, float* out, size_t n,
+		LayoutEnum layout, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			ConvertCodeRange(plan, dst_model, in, 8, out, n, first, last, layout);
+		});
+	}
+
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& plan, ModelEnum dst_model,
+		const uint16_t* in, int bits, float* out, size_t n,
+		LayoutEnum layout, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			ConvertCodeRange(plan, dst_model, in, bits, out, n, first, last, layout);
+		});
+	}
+};
@@ -0,0 +1,90 @@
+#ifndef _COLORBUFFER_H_
+#define _COLORBUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace COLORNS
+{
+	enum class ModelEnum
+	{
+		Rgb = 0,
+		Hsv = 1,
+		Xyz = 2,
+		Lab = 3
+	};
+
+	enum class LayoutEnum
+	{
+		Interleaved = 0,	// ch1 ch2 ch3 ch1 ch2 ch3 ...
+		Planar = 1			// n x ch1, then n x ch2, then n x ch3
+	};
+
+	// the range of valid inputs per channel:
+	// RGB [0, 1], HSV [0, 360] x [0, 1] x [0, 1], XYZ [0, 1.25] x [0, 1] x [0, 1.25]
+	// (room for the X and Z of every white), Lab [0, 100] x [-128, 128] x [-128, 128]
+	void GetModelRange(ModelEnum model, float lo[3], float hi[3]);
+
+	// Batch conversion of n colors, the same settings as Color uses (sRGB, D50, Bradford).
+	// HSV triples are (hue, saturation, value), as HsvColor stores them.
+	// in and out may point to the same buffer.
+	void ConvertBuffer(ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	class ConversionPlan;
+
+	// the same with the working space, white and adaptation taken from plan;
+	// plans with AccuracyEnum other than Exact run in float on the SIMD kernels;
+	// one thread of an optimized build on a current x86 core converts interleaved
+	// sRGB -> Lab at 6, 14.4 and 18 Mpix/s or more with Exact, High and Display8 plans
+	void ConvertBuffer(const ConversionPlan& plan,
+		ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	// RGB in the working space of src_plan to RGB in that of dst_plan: one matrix (src_plan
+	// RGB -> XYZ, adapted to the white of dst_plan when the whites differ, -> dst_plan RGB)
+	// between the two companding steps. Exact when both plans are, otherwise in float on
+	// the SIMD kernels. in and out may point to the same buffer.
+	void ConvertBuffer(const ConversionPlan& src_plan, const ConversionPlan& dst_plan,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	// Integer RGB codes in the plan's working space to dst_model. Linear light values
+	// come from GetInvCompandTable, no pow per channel.
+	void ConvertBuffer(const ConversionPlan& plan, ModelEnum dst_model,
+		const uint8_t* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	// bits is the depth of the codes: 10, 12 or 16; larger codes are clamped
+	void ConvertBuffer(const ConversionPlan& plan, ModelEnum dst_model,
+		const uint16_t* in, int bits, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	class ThreadPool;
+
+	// colors per pool task: the float input and output of a tile (192 KB) fit in L2
+	constexpr size_t kTilePixels = 8192;
+
+	// The overloads above split into tiles of tile colors and run across pool,
+	// the calling thread included. Results are the same as the serial ones.
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& plan,
+		ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels);
+
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& src_plan, const ConversionPlan& dst_plan,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels);
+
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& plan, ModelEnum dst_model,
+		const uint8_t* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels);
+
+	void ConvertBuffer(ThreadPool& pool, const ConversionPlan& plan, ModelEnum dst_model,
+		const uint16_t* in, int bits, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels);
+};
+
+#endif
@@ -0,0 +1,340 @@
+#include "ColorCache.h"
+#include "ColorPlan.h"
+#include "ColorPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace COLORNS
+{
+	namespace
+	{
+		// colors per lookup pass, the misses of a pass are converted in one call
+		constexpr size_t kCacheChunk = 256;
+		// settings word of an entry, never 0 for a filled one
+		constexpr uint32_t kCacheFilled = 1u << 31;
+		constexpr uint32_t kCacheCodes = 1u << 30;
+
+		size_t CacheRoundUp(size_t v)
+		{
+			size_t p = 1;
+			while (p < v)
+				p <<= 1;
+			return p;
+		}
+
+		// the conversion settings in one word: white 4 bits, adaptation 2, accuracy 2,
+		// source and destination model 2 each, working space 18, uint8 codes or floats
+		uint32_t CacheSettings(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model, bool codes)
+		{
+			return kCacheFilled | (codes ? kCacheCodes : 0u)
+				| static_cast<uint32_t>(plan.GetIlluminant())
+				| static_cast<uint32_t>(plan.GetAdaptation()) << 4
+				| static_cast<uint32_t>(plan.GetAccuracy()) << 6
+				| static_cast<uint32_t>(src_model) << 8
+				| static_cast<uint32_t>(dst_model) << 10
+				| static_cast<uint32_t>(plan.GetSpace()) << 12;
+		}
+
+		uint32_t CacheBits(float v)
+		{
+			uint32_t bits;
+			memcpy(&bits, &v, sizeof(bits));
+			return bits;
+		}
+
+		float CacheFloat(uint32_t bits)
+		{
+			float v;
+			memcpy(&v, &bits, sizeof(v));
+			return v;
+		}
+
+		// 64-bit mix of the key (the splitmix64 finalizer)
+		uint64_t CacheHash(const uint32_t key[4])
+		{
+			uint64_t h = (static_cast<uint64_t>(key[0]) << 32 | key[1]) * 0x9E3779B97F4A7C15ull;
+			h ^= (static_cast<uint64_t>(key[2]) << 32 | key[3]);
+			h ^= h >> 30;
+			h *= 0xBF58476D1CE4E5B9ull;
+			h ^= h >> 27;
+			h *= 0x94D049BB133111EBull;
+			h ^= h >> 31;
+			return h;
+		}
+	}
+
+	ConversionCache::ConversionCache(const CacheOptions& options) :
+		m_options(options)
+	{
+		m_options.Shards = static_cast<unsigned>(CacheRoundUp(std::max(options.Shards, 1u)));
+		const size_t perShard = (std::max<size_t>(options.Capacity, 1) + m_options.Shards - 1) / m_options.Shards;
+		m_sets = CacheRoundUp((perShard + kCacheWays - 1) / kCacheWays);
+		m_options.Capacity = m_options.Shards * m_sets * kCacheWays;
+		m_entries.reset(new Entry[m_options.Capacity]);
+		m_shards.reset(new Shard[m_options.Shards]);
+		for (unsigned s = 0; s < m_options.Shards; ++s)
+		{
+			m_shards[s].Hands.reset(new uint8_t[m_sets]);
+			std::fill(m_shards[s].Hands.get(), m_shards[s].Hands.get() + m_sets, static_cast<uint8_t>(0));
+		}
+	}
+
+	const CacheOptions& ConversionCache::GetOptions() const noexcept
+	{
+		return m_options;
+	}
+
+	CacheStats ConversionCache::GetStats() const
+	{
+		CacheStats stats;
+		stats.Hits = m_hits.load(std::memory_order_relaxed);
+		stats.Misses = m_misses.load(std::memory_order_relaxed);
+		for (unsigned s = 0; s < m_options.Shards; ++s)
+			stats.Evictions += m_shards[s].Evictions.load(std::memory_order_relaxed);
+		for (size_t i = 0; i < m_options.Capacity; ++i)
+		{
+			if (m_entries[i].Key[3].load(std::memory_order_relaxed) != 0)
+				++stats.Entries;
+		}
+		stats.Capacity = m_options.Capacity;
+		return stats;
+	}
+
+	void ConversionCache::Clear()
+	{
+		for (size_t i = 0; i < m_options.Capacity; ++i)
+		{
+			Entry& e = m_entries[i];
+			e.Key[3].store(0, std::memory_order_relaxed);
+			e.Referenced.store(0, std::memory_order_relaxed);
+		}
+		for (unsigned s = 0; s < m_options.Shards; ++s)
+			std::fill(m_shards[s].Hands.get(), m_shards[s].Hands.get() + m_sets, static_cast<uint8_t>(0));
+	}
+
+	void ConversionCache::ResetStats() noexcept
+	{
+		m_hits.store(0, std::memory_order_relaxed);
+		m_misses.store(0, std::memory_order_relaxed);
+		for (unsigned s = 0; s < m_options.Shards; ++s)
+			m_shards[s].Evictions.store(0, std::memory_order_relaxed);
+	}
+
+	// the high half of the hash picks the shard, the low half the set in it
+	ConversionCache::Entry* ConversionCache::GetSet(uint64_t hash, size_t& shard, size_t& set) const noexcept
+	{
+		shard = static_cast<size_t>(hash >> 32) & (m_options.Shards - 1);
+		set = static_cast<size_t>(hash) & (m_sets - 1);
+		return &m_entries[(shard * m_sets + set) * kCacheWays];
+	}
+
+	bool ConversionCache::Find(const uint32_t key[4], uint64_t hash, float value[3]) const
+	{
+		size_t shard, set;
+		Entry* ways = GetSet(hash, shard, set);
+		for (size_t w = 0; w < kCacheWays; ++w)
+		{
+			Entry& e = ways[w];
+			const uint32_t version = e.Version.load(std::memory_order_acquire);
+			if (version & 1)
+				continue;
+			if (e.Key[3].load(std::memory_order_relaxed) != key[3]
+				|| e.Key[0].load(std::memory_order_relaxed) != key[0]
+				|| e.Key[1].load(std::memory_order_relaxed) != key[1]
+				|| e.Key[2].load(std::memory_order_relaxed) != key[2])
+				continue;
+			uint32_t bits[3];
+			for (int c = 0; c < 3; ++c)
+				bits[c] = e.Value[c].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// rewritten meanwhile: take it as a miss
+			if (e.Version.load(std::memory_order_relaxed) != version)
+				return false;
+			for (int c = 0; c < 3; ++c)
+				value[c] = CacheFloat(bits[c]);
+			// a store only when the mark is clear, hits on hot entries stay reads
+			if (e.Referenced.load(std::memory_order_relaxed) == 0)
+				e.Referenced.store(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	void ConversionCache::Insert(const uint32_t key[4], uint64_t hash, const float value[3])
+	{
+		size_t shard, set;
+		Entry* ways = GetSet(hash, shard, set);
+		Shard& s = m_shards[shard];
+		std::lock_guard<std::mutex> guard(s.Lock);
+
+		Entry* target = nullptr;
+		for (size_t w = 0; w < kCacheWays && !target; ++w)
+		{
+			const uint32_t settings = ways[w].Key[3].load(std::memory_order_relaxed);
+			// another thread got there first
+			if (settings == key[3] && ways[w].Key[0].load(std::memory_order_relaxed) == key[0]
+				&& ways[w].Key[1].load(std::memory_order_relaxed) == key[1]
+				&& ways[w].Key[2].load(std::memory_order_relaxed) == key[2])
+				return;
+			if (settings == 0)
+				target = &ways[w];
+		}
+		if (!target)
+		{
+			// CLOCK: clear marks until the hand reaches an unmarked entry,
+			// at most one round
+			uint8_t& hand = s.Hands[set];
+			while (ways[hand].Referenced.load(std::memory_order_relaxed) != 0)
+			{
+				ways[hand].Referenced.store(0, std::memory_order_relaxed);
+				hand = static_cast<uint8_t>((hand + 1) % kCacheWays);
+			}
+			target = &ways[hand];
+			hand = static_cast<uint8_t>((hand + 1) % kCacheWays);
+			s.Evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// odd while the fields change, readers of this entry then miss
+		const uint32_t version = target->Version.load(std::memory_order_relaxed);
+		target->Version.store(version + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (int c = 0; c < 4; ++c)
+			target->Key[c].store(key[c], std::memory_order_relaxed);
+		for (int c = 0; c < 3; ++c)
+			target->Value[c].store(CacheBits(value[c]), std::memory_order_relaxed);
+		target->Referenced.store(1, std::memory_order_relaxed);
+		target->Version.store(version + 2, std::memory_order_release);
+	}
+
+	namespace
+	{
+		void CacheSource(const float* in, float* source, int bits)
+		{
+			for (int c = 0; c < 3; ++c)
+				source[c] = (bits > 0) ? std::ldexp(std::nearbyint(std::ldexp(in[c], bits)), -bits) : in[c];
+		}
+
+		void CacheSource(const uint8_t* in, uint8_t* source, int)
+		{
+			source[0] = in[0];
+			source[1] = in[1];
+			source[2] = in[2];
+		}
+
+		uint32_t CacheKey(float v)
+		{
+			return CacheBits(v + 0.0f);	// -0 keys as +0
+		}
+
+		uint32_t CacheKey(uint8_t v)
+		{
+			return v;
+		}
+
+		void CacheConvert(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+			const float* in, float* out, size_t n)
+		{
+			ConvertBuffer(plan, src_model, dst_model, in, out, n);
+		}
+
+		void CacheConvert(const ConversionPlan& plan, ModelEnum, ModelEnum dst_model,
+			const uint8_t* in, float* out, size_t n)
+		{
+			ConvertBuffer(plan, dst_model, in, out, n);
+		}
+	}
+
+	// chunk by chunk: the hits go straight to out, the misses are gathered,
+	// converted in one call, written and inserted
+	template <typename C>
+	void ConversionCache::ConvertRange(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+		const C* in, float* out, size_t n)
+	{
+		const bool codes = sizeof(C) == 1;
+		const uint32_t settings = CacheSettings(plan, src_model, dst_model, codes);
+		C source[kCacheChunk * 3];
+		float converted[kCacheChunk * 3];
+		size_t missed[kCacheChunk];
+		uint64_t hashes[kCacheChunk];
+		// the last hit: runs of one color (flat graphics) skip the table
+		uint32_t lastKey[3] = { 0, 0, 0 };
+		float lastValue[3];
+		bool last = false;
+		for (size_t start = 0; start < n; start += kCacheChunk)
+		{
+			const size_t chunk = std::min(kCacheChunk, n - start);
+			size_t misses = 0;
+			for (size_t i = 0; i < chunk; ++i)
+			{
+				// read before out is written, in may be out
+				C s[3];
+				CacheSource(in + (start + i) * 3, s, m_options.Bits);
+				const uint32_t key[4] = { CacheKey(s[0]), CacheKey(s[1]), CacheKey(s[2]), settings };
+				float* o = out + (start + i) * 3;
+				if (last && key[0] == lastKey[0] && key[1] == lastKey[1] && key[2] == lastKey[2])
+				{
+					std::copy(lastValue, lastValue + 3, o);
+					continue;
+				}
+				const uint64_t hash = CacheHash(key);
+				if (Find(key, hash, o))
+				{
+					std::copy(key, key + 3, lastKey);
+					std::copy(o, o + 3, lastValue);
+					last = true;
+				}
+				else
+				{
+					std::copy(s, s + 3, &source[misses * 3]);
+					hashes[misses] = hash;
+					missed[misses++] = i;
+				}
+			}
+			m_hits.fetch_add(chunk - misses, std::memory_order_relaxed);
+			if (misses == 0)
+				continue;
+			m_misses.fetch_add(misses, std::memory_order_relaxed);
+
+			CacheConvert(plan, src_model, dst_model, source, converted, misses);
+			for (size_t m = 0; m < misses; ++m)
+			{
+				const uint32_t key[4] = { CacheKey(source[m * 3]), CacheKey(source[m * 3 + 1]),
+					CacheKey(source[m * 3 + 2]), settings };
+				Insert(key, hashes[m], &converted[m * 3]);
+				std::copy(&converted[m * 3], &converted[m * 3] + 3, out + (start + missed[m]) * 3);
+			}
+		}
+	}
+
+	void ConversionCache::Convert(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+		const float* in, float* out, size_t n)
+	{
+		ConvertRange(plan, src_model, dst_model, in, out, n);
+	}
+
+	void ConversionCache::Convert(const ConversionPlan& plan, ModelEnum dst_model,
+		const uint8_t* in, float* out, size_t n)
+	{
+		ConvertRange(plan, ModelEnum::Rgb, dst_model, in, out, n);
+	}
+
+	void ConversionCache::Convert(ThreadPool& pool, const ConversionPlan& plan, ModelEnum src_model,
+		ModelEnum dst_model, const float* in, float* out, size_t n, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			ConvertRange(plan, src_model, dst_model, in + first * 3, out + first * 3, last - first);
+		});
+	}
+
+	void ConversionCache::Convert(ThreadPool& pool, const ConversionPlan& plan, ModelEnum dst_model,
+		const uint8_t* in, float* out, size_t n, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			ConvertRange(plan, ModelEnum::Rgb, dst_model, in + first * 3, out + first * 3, last - first);
+		});
+	}
+};
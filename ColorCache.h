@@ -0,0 +1,101 @@
+#ifndef _COLORCACHE_H_
+#define _COLORCACHE_H_
+
+#include "ColorBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace COLORNS
+{
+	// entries per cache set, CLOCK picks the victim among them
+	constexpr size_t kCacheWays = 8;
+
+	typedef struct _CacheOptions
+	{
+		size_t Capacity{ 1 << 16 };		// entries, rounded up to Shards x kCacheWays x a power of 2
+		unsigned Shards{ 16 };			// independent locks for inserts, a power of 2
+		int Bits{ 0 };					// float sources: 0 keys the exact value, else each channel
+										// is rounded to a multiple of 2^-Bits first
+	} CacheOptions;
+
+	typedef struct _CacheStats
+	{
+		uint64_t Hits{ 0 };
+		uint64_t Misses{ 0 };
+		uint64_t Evictions{ 0 };
+		size_t Entries{ 0 };			// filled slots
+		size_t Capacity{ 0 };
+	} CacheStats;
+
+	class ConversionPlan;
+	class ThreadPool;
+
+	// Memoized conversions for inputs with few distinct colors (palette images, flat
+	// graphics). Entries are keyed on the source triple and the conversion settings
+	// (working space, white, adaptation, accuracy, source and destination model), so
+	// one cache serves any number of plans.
+	// Lookups take no lock: each entry carries a version, odd while an insert rewrites
+	// it, and a reader that sees it change counts a miss. Inserts lock one shard.
+	// Each shard is set associative, a full set evicts with CLOCK: a hit marks its
+	// entry, the hand skips (and clears) marked entries.
+	// The results are those of ConvertBuffer on the (rounded) source. The misses of a
+	// batch are converted together, so with a plan other than Exact a color gets the
+	// result of the SIMD or the scalar path of that call, both within the plan's accuracy.
+	class ConversionCache
+	{
+		typedef struct _Entry
+		{
+			std::atomic<uint32_t> Version{ 0 };
+			std::atomic<uint32_t> Key[4]{};		// three channels, then the settings (0: empty)
+			std::atomic<uint32_t> Value[3]{};
+			std::atomic<uint32_t> Referenced{ 0 };
+		} Entry;
+
+		typedef struct _Shard
+		{
+			std::mutex Lock;
+			std::unique_ptr<uint8_t[]> Hands;	// CLOCK hand per set
+			std::atomic<uint64_t> Evictions{ 0 };
+		} Shard;
+
+		CacheOptions m_options;
+		size_t m_sets;						// per shard
+		std::unique_ptr<Entry[]> m_entries;	// shard by shard, set by set
+		std::unique_ptr<Shard[]> m_shards;
+		std::atomic<uint64_t> m_hits{ 0 };
+		std::atomic<uint64_t> m_misses{ 0 };
+
+		Entry* GetSet(uint64_t hash, size_t& shard, size_t& set) const noexcept;
+		bool Find(const uint32_t key[4], uint64_t hash, float value[3]) const;
+		void Insert(const uint32_t key[4], uint64_t hash, const float value[3]);
+		template <typename C>
+		void ConvertRange(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+			const C* in, float* out, size_t n);
+	public:
+		explicit ConversionCache(const CacheOptions& options = CacheOptions());
+		ConversionCache(const ConversionCache&) = delete;
+		ConversionCache& operator=(const ConversionCache&) = delete;
+
+		const CacheOptions& GetOptions() const noexcept;
+		CacheStats GetStats() const;
+		// drops every entry, the counters stay; not safe while other threads convert
+		void Clear();
+		void ResetStats() noexcept;
+
+		// ConvertBuffer through the cache; in and out may point to the same buffer
+		void Convert(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+			const float* in, float* out, size_t n);
+		void Convert(const ConversionPlan& plan, ModelEnum dst_model,
+			const uint8_t* in, float* out, size_t n);
+		void Convert(ThreadPool& pool, const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+			const float* in, float* out, size_t n, size_t tile = kTilePixels);
+		void Convert(ThreadPool& pool, const ConversionPlan& plan, ModelEnum dst_model,
+			const uint8_t* in, float* out, size_t n, size_t tile = kTilePixels);
+	};
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "Color.h"
+#include "ColorBatch.h"
 #include <limits>
 
 using namespace COLORNS;
@@ -22,8 +23,26 @@ T stdcin_inrange (std::string message, T low, T up)
 };
 
 
-int main()
+int main(int argc, char* argv[])
 {
+    // any argument switches to the batch mode, see GetBatchUsage()
+    if (argc > 1)
+    {
+        BatchOptions options;
+        std::string error;
+        if (!ParseBatchArgs(argc, argv, options, error))
+        {
+            cerr << error << endl << GetBatchUsage();
+            return 2;
+        }
+        if (options.Help)
+        {
+            cout << GetBatchUsage();
+            return 0;
+        }
+        return RunBatch(options);
+    }
+
     int i = 0;
     double ch1 = -1.0;
     double ch2 = -1.0;
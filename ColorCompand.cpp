@@ -0,0 +1,262 @@
+#include "ColorCompand.h"
+#include "ColorSpace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace COLORNS
+{
+	namespace
+	{
+		int ClampTableBits(int bits)
+		{
+			return bits < 1 ? 1 : (bits > 16 ? 16 : bits);
+		}
+	}
+
+	InvCompandTable::InvCompandTable(double gamma, int bits) :
+		m_gamma(gamma),
+		m_bits(ClampTableBits(bits))
+	{
+		const unsigned max = (1u << m_bits) - 1;
+		m_linear.resize(max + 1);
+		for (unsigned code = 0; code <= max; ++code)
+			m_linear[code] = InvCompand(static_cast<double>(code) / max, m_gamma);
+	}
+
+	double InvCompandTable::GetGamma() const noexcept
+	{
+		return m_gamma;
+	}
+
+	int InvCompandTable::GetBits() const noexcept
+	{
+		return m_bits;
+	}
+
+	unsigned InvCompandTable::GetMaxCode() const noexcept
+	{
+		return static_cast<unsigned>(m_linear.size() - 1);
+	}
+
+	const double* InvCompandTable::GetData() const noexcept
+	{
+		return m_linear.data();
+	}
+
+	const InvCompandTable& GetInvCompandTable(double gamma, int bits)
+	{
+		// a handful of entries at most: one per transfer function and depth
+		static std::mutex lock;
+		static std::vector<std::unique_ptr<InvCompandTable>> tables;
+
+		bits = ClampTableBits(bits);
+		std::lock_guard<std::mutex> guard(lock);
+		for (const auto& table : tables)
+		{
+			if (table->GetGamma() == gamma && table->GetBits() == bits)
+				return *table;
+		}
+		tables.emplace_back(new InvCompandTable(gamma, bits));
+		return *tables.back();
+	}
+
+	double GetAccuracyBound(AccuracyEnum accuracy) noexcept
+	{
+		switch (accuracy)
+		{
+		case AccuracyEnum::High:
+			return 1e-6;
+		case AccuracyEnum::Display8:
+			return 2e-4;
+		default:
+		case AccuracyEnum::Exact:
+			return 0.0;
+		}
+	}
+
+	constexpr double kPi = 3.14159265358979323846;
+
+	PowApprox::PowApprox(double p, double maxError) :
+		m_p(p), m_degree(0), m_coef(), m_scale()
+	{
+		if (maxError <= 0.0)
+			return;
+
+		for (int e = kMinExp; e <= kMaxExp; ++e)
+			m_scale[e - kMinExp] = pow(2.0, e * p);
+
+		// segment s covers m in [0.5 + s * w, 0.5 + (s + 1) * w), mapped to t in [-1, 1)
+		const double w = 0.5 / kSegments;
+		for (int degree = 1; degree <= kMaxDegree; ++degree)
+		{
+			const int n = degree + 1;
+			for (int s = 0; s < kSegments; ++s)
+			{
+				const double center = 0.5 + (s + 0.5) * w;
+				for (int k = 0; k < n; ++k)
+				{
+					double sum = 0.0;
+					for (int j = 0; j < n; ++j)
+					{
+						double theta = kPi * (j + 0.5) / n;
+						sum += pow(center + cos(theta) * w / 2.0, p) * cos(k * theta);
+					}
+					m_coef[s][k] = 2.0 * sum / n;
+				}
+				m_coef[s][0] /= 2.0;
+			}
+			m_degree = degree;
+
+			double error = 0.0;
+			for (int i = 0; i <= 8192; ++i)
+			{
+				double m = 0.5 + 0.5 * i / 8192.0;
+				double ref = pow(m, p);
+				error = std::max(error, fabs((*this)(m) - ref) / ref);
+			}
+			if (error <= maxError)
+				break;
+		}
+	}
+
+	double PowApprox::GetPower() const noexcept
+	{
+		return m_p;
+	}
+
+	int PowApprox::GetDegree() const noexcept
+	{
+		return m_degree;
+	}
+
+	double PowApprox::operator()(double x) const noexcept
+	{
+		uint64_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		// x = m * 2^e, m in [0.5, 1); zero, denormals, inf and NaN fall out of the range
+		int e = static_cast<int>((bits >> 52) & 0x7ff) - 1022;
+		if (m_degree == 0 || e < kMinExp || e > kMaxExp)
+			return pow(x, m_p);
+		// the top mantissa bits pick the segment, the rest is t
+		const int s = static_cast<int>((bits >> (52 - kSegmentBits)) & (kSegments - 1));
+		bits = (bits & 0x000fffffffffffffull) | (1023ull << 52);
+		double f;
+		memcpy(&f, &bits, sizeof(f));
+		const double t = (f - 1.0) * (2 * kSegments) - (2 * s + 1);
+
+		// Clenshaw recurrence
+		const double* c = m_coef[s];
+		double b1 = 0.0;
+		double b2 = 0.0;
+		for (int k = m_degree; k > 0; --k)
+		{
+			double b0 = c[k] + 2.0 * t * b1 - b2;
+			b2 = b1;
+			b1 = b0;
+		}
+		return (c[0] + t * b1 - b2) * m_scale[e - kMinExp];
+	}
+
+	namespace
+	{
+		double CompandPower(double gamma)
+		{
+			if (gamma > 0.0)
+				return 1.0 / gamma;
+			return (gamma < 0.0) ? 1.0 / 2.4 : 1.0 / 3.0;
+		}
+
+		double InvCompandPower(double gamma)
+		{
+			// L* is inverted with a cubic polynomial, no pow() involved
+			if (gamma > 0.0)
+				return gamma;
+			return (gamma < 0.0) ? 2.4 : 3.0;
+		}
+
+		// relative error budget: the sRGB and L* curves scale the power by up to 1.16
+		double PowErrorBound(double gamma, AccuracyEnum accuracy)
+		{
+			return (gamma == 0.0) ? GetAccuracyBound(accuracy) / 2.0 / 1.16 : GetAccuracyBound(accuracy) / 2.0 / 1.055;
+		}
+	}
+
+	CompandApprox::CompandApprox(double gamma, AccuracyEnum accuracy) :
+		m_gamma(gamma), m_accuracy(accuracy),
+		m_compand(CompandPower(gamma), PowErrorBound(gamma, accuracy)),
+		m_invCompand(InvCompandPower(gamma), (gamma == 0.0) ? 0.0 : PowErrorBound(gamma, accuracy))
+	{}
+
+	double CompandApprox::GetGamma() const noexcept
+	{
+		return m_gamma;
+	}
+
+	AccuracyEnum CompandApprox::GetAccuracy() const noexcept
+	{
+		return m_accuracy;
+	}
+
+	double CompandApprox::Compand(double linear) const noexcept
+	{
+		if (m_accuracy == AccuracyEnum::Exact)
+			return COLORNS::Compand(linear, m_gamma);
+
+		double sign = 1.0;
+		if (linear < 0.0)
+		{
+			sign = -1.0;
+			linear = -linear;
+		}
+		double companded;
+		if (m_gamma > 0.0)
+			companded = m_compand(linear);
+		else if (m_gamma < 0.0)
+			/* sRGB */
+			companded = (linear <= 0.0031308) ? (linear * 12.92) : (1.055 * m_compand(linear) - 0.055);
+		else
+			/* L* */
+			companded = (linear <= (216.0 / 24389.0)) ? (linear * 24389.0 / 2700.0) : (1.16 * m_compand(linear) - 0.16);
+		return sign * companded;
+	}
+
+	double CompandApprox::InvCompand(double companded) const noexcept
+	{
+		if (m_accuracy == AccuracyEnum::Exact || m_gamma == 0.0)
+			return COLORNS::InvCompand(companded, m_gamma);
+
+		double sign = 1.0;
+		if (companded < 0.0)
+		{
+			sign = -1.0;
+			companded = -companded;
+		}
+		double linear;
+		if (m_gamma > 0.0)
+			linear = m_invCompand(companded);
+		else
+			/* sRGB */
+			linear = (companded <= 0.04045) ? (companded / 12.92) : m_invCompand((companded + 0.055) / 1.055);
+		return sign * linear;
+	}
+
+	const CompandApprox& GetCompandApprox(double gamma, AccuracyEnum accuracy)
+	{
+		static std::mutex lock;
+		static std::vector<std::unique_ptr<CompandApprox>> approxs;
+
+		std::lock_guard<std::mutex> guard(lock);
+		for (const auto& approx : approxs)
+		{
+			if (approx->GetGamma() == gamma && approx->GetAccuracy() == accuracy)
+				return *approx;
+		}
+		approxs.emplace_back(new CompandApprox(gamma, accuracy));
+		return *approxs.back();
+	}
+};
@@ -0,0 +1,87 @@
+#ifndef _COLORCOMPAND_H_
+#define _COLORCOMPAND_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace COLORNS
+{
+	// Linear light value of every code of a bits-deep integer channel:
+	// table[code] == InvCompand(code / (2^bits - 1), gamma), bit for bit
+	class InvCompandTable
+	{
+		double m_gamma;
+		int m_bits;
+		std::vector<double> m_linear;
+	public:
+		InvCompandTable(double gamma, int bits);
+		double GetGamma() const noexcept;
+		int GetBits() const noexcept;
+		unsigned GetMaxCode() const noexcept;
+		const double* GetData() const noexcept;
+		// codes above GetMaxCode() are clamped
+		double operator[](unsigned code) const noexcept
+		{
+			return m_linear[code < m_linear.size() ? code : m_linear.size() - 1];
+		}
+	};
+
+	// Shared table for the gamma (as in RgbModel::GammaRGB) and depth (8, 10, 12 or 16),
+	// built on first request; safe to call from several threads
+	const InvCompandTable& GetInvCompandTable(double gamma, int bits);
+
+	// Compand/InvCompand accuracy tiers, from exact pow() to fast approximations
+	enum class AccuracyEnum
+	{
+		Exact = 0,		// the reference functions
+		High = 1,		// max abs error 1e-6
+		Display8 = 2	// max abs error 2e-4, well under half an 8-bit code
+	};
+
+	// max absolute error of the tier for inputs in [-1, 1]; 0 for Exact
+	double GetAccuracyBound(AccuracyEnum accuracy) noexcept;
+
+	// x^p for x > 0: x = m * 2^e, 2^(e * p) comes from a table and m^p from
+	// one of kSegments Chebyshev polynomials splitting [0.5, 1), near-minimax for their degree
+	class PowApprox
+	{
+		static constexpr int kMinExp = -60;
+		static constexpr int kMaxExp = 64;
+		static constexpr int kSegmentBits = 4;
+		static constexpr int kSegments = 1 << kSegmentBits;
+		static constexpr int kMaxDegree = 8;
+
+		double m_p;
+		int m_degree;
+		double m_coef[kSegments][kMaxDegree + 1];
+		double m_scale[kMaxExp - kMinExp + 1];
+	public:
+		// picks the lowest degree keeping the relative error under maxError,
+		// maxError 0 means pow() itself
+		PowApprox(double p, double maxError);
+		double GetPower() const noexcept;
+		int GetDegree() const noexcept;
+		double operator()(double x) const noexcept;
+	};
+
+	// Compand/InvCompand for one transfer function (gamma as in RgbModel::GammaRGB)
+	// at the given accuracy tier
+	class CompandApprox
+	{
+		double m_gamma;
+		AccuracyEnum m_accuracy;
+		PowApprox m_compand;
+		PowApprox m_invCompand;
+	public:
+		CompandApprox(double gamma, AccuracyEnum accuracy);
+		double GetGamma() const noexcept;
+		AccuracyEnum GetAccuracy() const noexcept;
+		double Compand(double linear) const noexcept;
+		double InvCompand(double companded) const noexcept;
+	};
+
+	// Shared approximation for the gamma and tier, built on first request
+	const CompandApprox& GetCompandApprox(double gamma, AccuracyEnum accuracy);
+};
+
+#endif
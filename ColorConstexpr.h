@@ -0,0 +1,572 @@
+#ifndef _COLORCONSTEXPR_H_
+#define _COLORCONSTEXPR_H_
+
+#include "Color.h"
+#include "ColorSpace.h"
+
+#include <limits>
+
+namespace COLORNS
+{
+	// Compile-time conversions for color constants:
+	//     constexpr LabColor c = ToLab(RgbColor(1.0, 0.5, 0.0));
+	// The formulas of Color.cpp in double, with std::pow and std::cbrt replaced by
+	// series a constant expression can evaluate; those agree with the library to
+	// ~1e-14 relative. They work at run time too, but slower than the runtime path.
+
+	constexpr double kConstLn2Hi = 6.93147180369123816490e-01;	// ln 2, the upper bits exact
+	constexpr double kConstLn2Lo = 1.90821492927058770002e-10;
+	constexpr double kConstSqrt2 = 1.41421356237309504880;
+	// terms of the log and exp series, enough for double over the reduced ranges
+	constexpr int kConstLogTerms = 12;
+	constexpr int kConstExpTerms = 18;
+
+	// natural log, x > 0 and finite: x = m 2^k with m in [sqrt(1/2), sqrt(2)),
+	// log m = 2 atanh(s), s = (m - 1) / (m + 1)
+	constexpr double ConstLog(double x)
+	{
+		int k = 0;
+		while (x >= kConstSqrt2)
+		{
+			x *= 0.5;
+			++k;
+		}
+		while (x < 0.5 * kConstSqrt2)
+		{
+			x *= 2.0;
+			--k;
+		}
+		const double s = (x - 1.0) / (x + 1.0);
+		const double s2 = s * s;
+		double sum = 0.0;
+		for (int n = kConstLogTerms; n > 0; --n)
+			sum = 1.0 / (2 * n - 1) + s2 * sum;
+		return k * kConstLn2Hi + (k * kConstLn2Lo + 2.0 * s * sum);
+	}
+
+	// e^y: y = k ln 2 + r with |r| <= ln 2 / 2, Taylor series of e^r times 2^k
+	constexpr double ConstExp(double y)
+	{
+		const double t = y / (kConstLn2Hi + kConstLn2Lo);
+		const int k = static_cast<int>(t < 0.0 ? t - 0.5 : t + 0.5);
+		const double r = (y - k * kConstLn2Hi) - k * kConstLn2Lo;
+		double sum = 1.0;
+		for (int n = kConstExpTerms; n > 0; --n)
+			sum = 1.0 + sum * r / n;
+		for (int i = 0; i < k; ++i)
+			sum *= 2.0;
+		for (int i = 0; i > k; --i)
+			sum *= 0.5;
+		return sum;
+	}
+
+	// x^p for x >= 0, the only bases the conversions need
+	constexpr double ConstPow(double x, double p)
+	{
+		if (p == 0.0)
+			return 1.0;
+		if (!(x > 0.0))
+			return 0.0;
+		if (x > std::numeric_limits<double>::max())
+			return x;
+		return ConstExp(p * ConstLog(x));
+	}
+
+	// cube root: scaled by 8^k into [1, 8), then Halley steps from 1.5
+	constexpr double ConstCbrt(double x)
+	{
+		if (x < 0.0)
+			return -ConstCbrt(-x);
+		if (!(x > 0.0) || x > std::numeric_limits<double>::max())
+			return x;
+		double scale = 1.0;
+		while (x >= 8.0)
+		{
+			x *= 0.125;
+			scale *= 2.0;
+		}
+		while (x < 1.0)
+		{
+			x *= 8.0;
+			scale *= 0.5;
+		}
+		double y = 1.5;
+		for (int i = 0; i < 5; ++i)
+		{
+			const double y3 = y * y * y;
+			y *= (y3 + 2.0 * x) / (2.0 * y3 + x);
+		}
+		return y * scale;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////
+	// a working space from the chromaticities of its primaries, its white (Y = 1) and
+	// transfer function (gamma as in RgbModel::GammaRGB)
+	constexpr RgbModel MakeRGBModel(double xr, double yr, double xg, double yg, double xb, double yb,
+		const XYZ& white, double gamma)
+	{
+		RgbModel result{};
+		result.RefWhiteRGB = white;
+		result.GammaRGB = gamma;
+
+		Mtx3x3 m = { { {xr / yr, xg / yg, xb / yb}, {1.0, 1.0, 1.0}, {(1.0 - xr - yr) / yr, (1.0 - xg - yg) / yg, (1.0 - xb - yb) / yb} } };
+		Mtx3x3 mi = { { {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0} } };
+		MtxInvert3x3(m, mi);
+
+		double sr = result.RefWhiteRGB.X * mi.m[0][0] + result.RefWhiteRGB.Y * mi.m[0][1] + result.RefWhiteRGB.Z * mi.m[0][2];
+		double sg = result.RefWhiteRGB.X * mi.m[1][0] + result.RefWhiteRGB.Y * mi.m[1][1] + result.RefWhiteRGB.Z * mi.m[1][2];
+		double sb = result.RefWhiteRGB.X * mi.m[2][0] + result.RefWhiteRGB.Y * mi.m[2][1] + result.RefWhiteRGB.Z * mi.m[2][2];
+
+		result.MtxRGB2XYZ.m[0][0] = sr * m.m[0][0];
+		result.MtxRGB2XYZ.m[0][1] = sg * m.m[0][1];
+		result.MtxRGB2XYZ.m[0][2] = sb * m.m[0][2];
+		result.MtxRGB2XYZ.m[1][0] = sr * m.m[1][0];
+		result.MtxRGB2XYZ.m[1][1] = sg * m.m[1][1];
+		result.MtxRGB2XYZ.m[1][2] = sb * m.m[1][2];
+		result.MtxRGB2XYZ.m[2][0] = sr * m.m[2][0];
+		result.MtxRGB2XYZ.m[2][1] = sg * m.m[2][1];
+		result.MtxRGB2XYZ.m[2][2] = sb * m.m[2][2];
+
+		MtxTranspose3x3(result.MtxRGB2XYZ);
+
+		MtxInvert3x3(result.MtxRGB2XYZ, result.MtxXYZ2RGB);
+
+		return result;
+	}
+
+	// the working spaces of GetRGBModel, Color.cpp bakes them into its table
+	constexpr RgbModel MakeRGBModel(RgbEnum Model)
+	{
+		RgbModel result{};
+		result.RefWhiteRGB.Y = 1.00000;
+		double xr = 0.0, yr = 0.0, xg = 0.0, yg = 0.0, xb = 0.0, yb = 0.0;
+
+		switch (Model)
+		{
+		case RgbEnum::AdobeRgb:	/* Adobe RGB (1998) */
+			xr = 0.64;
+			yr = 0.33;
+			xg = 0.21;
+			yg = 0.71;
+			xb = 0.15;
+			yb = 0.06;
+
+			result.RefWhiteRGB.X = 0.95047;
+			result.RefWhiteRGB.Z = 1.08883;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::AppleRgb:	/* AppleRGB */
+			xr = 0.625;
+			yr = 0.340;
+			xg = 0.280;
+			yg = 0.595;
+			xb = 0.155;
+			yb = 0.070;
+
+			result.RefWhiteRGB.X = 0.95047;
+			result.RefWhiteRGB.Z = 1.08883;
+
+			result.GammaRGB = 1.8;
+			break;
+		case RgbEnum::BestRgb:	/* Best RGB */
+			xr = 0.7347;
+			yr = 0.2653;
+			xg = 0.2150;
+			yg = 0.7750;
+			xb = 0.1300;
+			yb = 0.0350;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::BetaRgb:	/* Beta RGB */
+			xr = 0.6888;
+			yr = 0.3112;
+			xg = 0.1986;
+			yg = 0.7551;
+			xb = 0.1265;
+			yb = 0.0352;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::BruceRgb:	/* Bruce RGB */
+			xr = 0.64;
+			yr = 0.33;
+			xg = 0.28;
+			yg = 0.65;
+			xb = 0.15;
+			yb = 0.06;
+
+			result.RefWhiteRGB.X = 0.95047;
+			result.RefWhiteRGB.Z = 1.08883;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::CieRgb:	/* CIE RGB */
+			xr = 0.735;
+			yr = 0.265;
+			xg = 0.274;
+			yg = 0.717;
+			xb = 0.167;
+			yb = 0.009;
+
+			result.RefWhiteRGB.X = 1.00000;
+			result.RefWhiteRGB.Z = 1.00000;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::ColorMatchRgb:	/* ColorMatch RGB */
+			xr = 0.630;
+			yr = 0.340;
+			xg = 0.295;
+			yg = 0.605;
+			xb = 0.150;
+			yb = 0.075;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 1.8;
+			break;
+		case RgbEnum::DonRgb4:	/* Don RGB 4 */
+			xr = 0.696;
+			yr = 0.300;
+			xg = 0.215;
+			yg = 0.765;
+			xb = 0.130;
+			yb = 0.035;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::EciRgb2:	/* ECI RGB v2 */
+			xr = 0.67;
+			yr = 0.33;
+			xg = 0.21;
+			yg = 0.71;
+			xb = 0.14;
+			yb = 0.08;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 0.0;
+			break;
+		case RgbEnum::EktaSpacePS5:	/* Ekta Space PS5 */
+			xr = 0.695;
+			yr = 0.305;
+			xg = 0.260;
+			yg = 0.700;
+			xb = 0.110;
+			yb = 0.005;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::NtscRgb:	/* NTSC RGB */
+			xr = 0.67;
+			yr = 0.33;
+			xg = 0.21;
+			yg = 0.71;
+			xb = 0.14;
+			yb = 0.08;
+
+			result.RefWhiteRGB.X = 0.98074;
+			result.RefWhiteRGB.Z = 1.18232;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::PalSecamRgb:	/* PAL/SECAM RGB */
+			xr = 0.64;
+			yr = 0.33;
+			xg = 0.29;
+			yg = 0.60;
+			xb = 0.15;
+			yb = 0.06;
+
+			result.RefWhiteRGB.X = 0.95047;
+			result.RefWhiteRGB.Z = 1.08883;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::ProPhotoRgb:	/* ProPhoto RGB */
+			xr = 0.7347;
+			yr = 0.2653;
+			xg = 0.1596;
+			yg = 0.8404;
+			xb = 0.0366;
+			yb = 0.0001;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 1.8;
+			break;
+		case RgbEnum::SmpteCRgb:	/* SMPTE-C RGB */
+			xr = 0.630;
+			yr = 0.340;
+			xg = 0.310;
+			yg = 0.595;
+			xb = 0.155;
+			yb = 0.070;
+
+			result.RefWhiteRGB.X = 0.95047;
+			result.RefWhiteRGB.Z = 1.08883;
+
+			result.GammaRGB = 2.2;
+			break;
+		case RgbEnum::sRGB:	/* sRGB */
+			xr = 0.64;
+			yr = 0.33;
+			xg = 0.30;
+			yg = 0.60;
+			xb = 0.15;
+			yb = 0.06;
+
+			result.RefWhiteRGB.X = 0.95047;
+			result.RefWhiteRGB.Z = 1.08883;
+
+			result.GammaRGB = -2.2;
+			break;
+		case RgbEnum::WideGamutRgb:	/* Wide Gamut RGB */
+			xr = 0.735;
+			yr = 0.265;
+			xg = 0.115;
+			yg = 0.826;
+			xb = 0.157;
+			yb = 0.018;
+
+			result.RefWhiteRGB.X = 0.96422;
+			result.RefWhiteRGB.Z = 0.82521;
+
+			result.GammaRGB = 2.2;
+			break;
+		}
+
+		return MakeRGBModel(xr, yr, xg, yg, xb, yb, result.RefWhiteRGB, result.GammaRGB);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////
+	// Compand, InvCompand: linear <-> companded by the gamma of RgbModel, sign preserving
+	template <typename T>
+	constexpr T CompandConst(T linear, const double gamma)
+	{
+		const double sign = (linear < 0) ? -1.0 : 1.0;
+		const double v = sign * linear;
+		double companded = 0.0;
+		if (gamma > 0.0)
+			companded = ConstPow(v, 1.0 / gamma);
+		else if (gamma < 0.0)	/* sRGB */
+			companded = (v <= 0.0031308) ? (v * 12.92) : (1.055 * ConstPow(v, 1.0 / 2.4) - 0.055);
+		else	/* L* */
+			companded = (v <= 216.0 / 24389.0) ? (v * 24389.0 / 2700.0) : (1.16 * ConstCbrt(v) - 0.16);
+		return static_cast<T>(sign * companded);
+	}
+
+	template <typename T>
+	constexpr T InvCompandConst(T companded, const double gamma)
+	{
+		const double sign = (companded < 0) ? -1.0 : 1.0;
+		const double v = sign * companded;
+		double linear = 0.0;
+		if (gamma > 0.0)
+			linear = ConstPow(v, gamma);
+		else if (gamma < 0.0)	/* sRGB */
+			linear = (v <= 0.04045) ? (v / 12.92) : ConstPow((v + 0.055) / 1.055, 2.4);
+		else	/* L* */
+			linear = (v <= 0.08) ? (2700.0 * v / 24389.0) : ((((1000000.0 * v + 480000.0) * v + 76800.0) * v + 4096.0) / 1560896.0);
+		return static_cast<T>(sign * linear);
+	}
+
+	// RGB2XYZ, XYZ2RGB, XYZ2Lab and Lab2XYZ, the arithmetic in double
+	template <typename T>
+	constexpr void RGB2XYZConst(const T& r, const T& g, const T& b,
+		const double gamma, const RgbModel& model,
+		T& x, T& y, T& z, const XYZ& RefWhite,
+		const AdaptationEnum Method = AdaptationEnum::amBradford)
+	{
+		const Mtx3x3& MtxRGB2XYZ = model.MtxRGB2XYZ;
+
+		// Inverse Gamma Companding
+		const double R = InvCompandConst(static_cast<double>(r), gamma);
+		const double G = InvCompandConst(static_cast<double>(g), gamma);
+		const double B = InvCompandConst(static_cast<double>(b), gamma);
+
+		// Linear RGB to XYZ
+		double X = R * MtxRGB2XYZ.m[0][0] + G * MtxRGB2XYZ.m[1][0] + B * MtxRGB2XYZ.m[2][0];
+		double Y = R * MtxRGB2XYZ.m[0][1] + G * MtxRGB2XYZ.m[1][1] + B * MtxRGB2XYZ.m[2][1];
+		double Z = R * MtxRGB2XYZ.m[0][2] + G * MtxRGB2XYZ.m[1][2] + B * MtxRGB2XYZ.m[2][2];
+
+		// Chromatic Adaptation
+		if (Method != AdaptationEnum::amNone)
+		{
+			const Mtx3x3& Ma = Adaptations[static_cast<size_t>(Method)][0];
+			const Mtx3x3& MaI = Adaptations[static_cast<size_t>(Method)][1];
+
+			const double Ad = RefWhite.X * Ma.m[0][0] + RefWhite.Y * Ma.m[1][0] + RefWhite.Z * Ma.m[2][0];
+			const double Bd = RefWhite.X * Ma.m[0][1] + RefWhite.Y * Ma.m[1][1] + RefWhite.Z * Ma.m[2][1];
+			const double Cd = RefWhite.X * Ma.m[0][2] + RefWhite.Y * Ma.m[1][2] + RefWhite.Z * Ma.m[2][2];
+
+			const double As = model.RefWhiteRGB.X * Ma.m[0][0] + model.RefWhiteRGB.Y * Ma.m[1][0] + model.RefWhiteRGB.Z * Ma.m[2][0];
+			const double Bs = model.RefWhiteRGB.X * Ma.m[0][1] + model.RefWhiteRGB.Y * Ma.m[1][1] + model.RefWhiteRGB.Z * Ma.m[2][1];
+			const double Cs = model.RefWhiteRGB.X * Ma.m[0][2] + model.RefWhiteRGB.Y * Ma.m[1][2] + model.RefWhiteRGB.Z * Ma.m[2][2];
+
+			const double X1 = (X * Ma.m[0][0] + Y * Ma.m[1][0] + Z * Ma.m[2][0]) * (Ad / As);
+			const double Y1 = (X * Ma.m[0][1] + Y * Ma.m[1][1] + Z * Ma.m[2][1]) * (Bd / Bs);
+			const double Z1 = (X * Ma.m[0][2] + Y * Ma.m[1][2] + Z * Ma.m[2][2]) * (Cd / Cs);
+
+			X = X1 * MaI.m[0][0] + Y1 * MaI.m[1][0] + Z1 * MaI.m[2][0];
+			Y = X1 * MaI.m[0][1] + Y1 * MaI.m[1][1] + Z1 * MaI.m[2][1];
+			Z = X1 * MaI.m[0][2] + Y1 * MaI.m[1][2] + Z1 * MaI.m[2][2];
+		}
+		x = static_cast<T>(X);
+		y = static_cast<T>(Y);
+		z = static_cast<T>(Z);
+	}
+
+	template <typename T>
+	constexpr void XYZ2RGBConst(const T& x, const T& y, const T& z,
+		const XYZ& RefWhite,
+		T& r, T& g, T& b,
+		const double gamma, const RgbModel& model,
+		const AdaptationEnum Method = AdaptationEnum::amBradford)
+	{
+		const Mtx3x3& MtxXYZ2RGB = model.MtxXYZ2RGB;
+
+		double X2 = x;
+		double Y2 = y;
+		double Z2 = z;
+
+		if (Method != AdaptationEnum::amNone)
+		{
+			const Mtx3x3& Ma = Adaptations[static_cast<size_t>(Method)][0];
+			const Mtx3x3& MaI = Adaptations[static_cast<size_t>(Method)][1];
+
+			const double As = RefWhite.X * Ma.m[0][0] + RefWhite.Y * Ma.m[1][0] + RefWhite.Z * Ma.m[2][0];
+			const double Bs = RefWhite.X * Ma.m[0][1] + RefWhite.Y * Ma.m[1][1] + RefWhite.Z * Ma.m[2][1];
+			const double Cs = RefWhite.X * Ma.m[0][2] + RefWhite.Y * Ma.m[1][2] + RefWhite.Z * Ma.m[2][2];
+
+			const double Ad = model.RefWhiteRGB.X * Ma.m[0][0] + model.RefWhiteRGB.Y * Ma.m[1][0] + model.RefWhiteRGB.Z * Ma.m[2][0];
+			const double Bd = model.RefWhiteRGB.X * Ma.m[0][1] + model.RefWhiteRGB.Y * Ma.m[1][1] + model.RefWhiteRGB.Z * Ma.m[2][1];
+			const double Cd = model.RefWhiteRGB.X * Ma.m[0][2] + model.RefWhiteRGB.Y * Ma.m[1][2] + model.RefWhiteRGB.Z * Ma.m[2][2];
+
+			const double X1 = (X2 * Ma.m[0][0] + Y2 * Ma.m[1][0] + Z2 * Ma.m[2][0]) * (Ad / As);
+			const double Y1 = (X2 * Ma.m[0][1] + Y2 * Ma.m[1][1] + Z2 * Ma.m[2][1]) * (Bd / Bs);
+			const double Z1 = (X2 * Ma.m[0][2] + Y2 * Ma.m[1][2] + Z2 * Ma.m[2][2]) * (Cd / Cs);
+
+			X2 = X1 * MaI.m[0][0] + Y1 * MaI.m[1][0] + Z1 * MaI.m[2][0];
+			Y2 = X1 * MaI.m[0][1] + Y1 * MaI.m[1][1] + Z1 * MaI.m[2][1];
+			Z2 = X1 * MaI.m[0][2] + Y1 * MaI.m[1][2] + Z1 * MaI.m[2][2];
+		}
+
+		r = static_cast<T>(CompandConst(X2 * MtxXYZ2RGB.m[0][0] + Y2 * MtxXYZ2RGB.m[1][0] + Z2 * MtxXYZ2RGB.m[2][0], gamma));
+		g = static_cast<T>(CompandConst(X2 * MtxXYZ2RGB.m[0][1] + Y2 * MtxXYZ2RGB.m[1][1] + Z2 * MtxXYZ2RGB.m[2][1], gamma));
+		b = static_cast<T>(CompandConst(X2 * MtxXYZ2RGB.m[0][2] + Y2 * MtxXYZ2RGB.m[1][2] + Z2 * MtxXYZ2RGB.m[2][2], gamma));
+	}
+
+	template <typename T>
+	constexpr void XYZ2LabConst(const T& x, const T& y, const T& z,
+		const XYZ& RefWhite,
+		T& l, T& a, T& b)
+	{
+		const double xr = x / RefWhite.X;
+		const double yr = y / RefWhite.Y;
+		const double zr = z / RefWhite.Z;
+
+		const double fx = (xr > kE) ? ConstCbrt(xr) : ((kK * xr + 16.0) / 116.0);
+		const double fy = (yr > kE) ? ConstCbrt(yr) : ((kK * yr + 16.0) / 116.0);
+		const double fz = (zr > kE) ? ConstCbrt(zr) : ((kK * zr + 16.0) / 116.0);
+
+		l = static_cast<T>(116.0 * fy - 16.0);
+		a = static_cast<T>(500.0 * (fx - fy));
+		b = static_cast<T>(200.0 * (fy - fz));
+	}
+
+	template <typename T>
+	constexpr void Lab2XYZConst(const T& l, const T& a, const T& b,
+		const XYZ& RefWhite,
+		T& x, T& y, T& z)
+	{
+		const double fy = (l + 16.0) / 116.0;
+		const double fx = 0.002 * a + fy;
+		const double fz = fy - 0.005 * b;
+
+		const double fx3 = fx * fx * fx;
+		const double fz3 = fz * fz * fz;
+
+		const double xr = (fx3 > kE) ? fx3 : ((116.0 * fx - 16.0) / kK);
+		const double yr = (l > kKE) ? fy * fy * fy : (l / kK);
+		const double zr = (fz3 > kE) ? fz3 : ((116.0 * fz - 16.0) / kK);
+
+		x = static_cast<T>(xr * RefWhite.X);
+		y = static_cast<T>(yr * RefWhite.Y);
+		z = static_cast<T>(zr * RefWhite.Z);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////
+	// the color classes: RGB of the working space Model, XYZ and Lab relative to White;
+	// the defaults are those of Color (sRGB, D50, Bradford)
+	template <typename T>
+	constexpr BasicXyzColor<T> ToXYZ(const BasicRgbColor<T>& rgb, RgbEnum Model = RgbEnum::sRGB,
+		IlluminantEnum White = IlluminantEnum::D50, AdaptationEnum Method = AdaptationEnum::amBradford)
+	{
+		const RgbModel model = MakeRGBModel(Model);
+		T x = 0, y = 0, z = 0;
+		RGB2XYZConst(rgb.GetRed(), rgb.GetGreen(), rgb.GetBlue(), model.GammaRGB, model,
+			x, y, z, GetRefWhite(White), Method);
+		return BasicXyzColor<T>(x, y, z);
+	}
+
+	template <typename T>
+	constexpr BasicXyzColor<T> ToXYZ(const BasicLabColor<T>& lab, IlluminantEnum White = IlluminantEnum::D50)
+	{
+		T x = 0, y = 0, z = 0;
+		Lab2XYZConst(lab.GetL(), lab.GetA(), lab.GetB(), GetRefWhite(White), x, y, z);
+		return BasicXyzColor<T>(x, y, z);
+	}
+
+	template <typename T>
+	constexpr BasicLabColor<T> ToLab(const BasicXyzColor<T>& xyz, IlluminantEnum White = IlluminantEnum::D50)
+	{
+		T l = 0, a = 0, b = 0;
+		XYZ2LabConst(xyz.GetX(), xyz.GetY(), xyz.GetZ(), GetRefWhite(White), l, a, b);
+		return BasicLabColor<T>(l, a, b);
+	}
+
+	template <typename T>
+	constexpr BasicLabColor<T> ToLab(const BasicRgbColor<T>& rgb, RgbEnum Model = RgbEnum::sRGB,
+		IlluminantEnum White = IlluminantEnum::D50, AdaptationEnum Method = AdaptationEnum::amBradford)
+	{
+		return ToLab(ToXYZ(rgb, Model, White, Method), White);
+	}
+
+	template <typename T>
+	constexpr BasicRgbColor<T> ToRGB(const BasicXyzColor<T>& xyz, RgbEnum Model = RgbEnum::sRGB,
+		IlluminantEnum White = IlluminantEnum::D50, AdaptationEnum Method = AdaptationEnum::amBradford)
+	{
+		const RgbModel model = MakeRGBModel(Model);
+		T r = 0, g = 0, b = 0;
+		XYZ2RGBConst(xyz.GetX(), xyz.GetY(), xyz.GetZ(), GetRefWhite(White), r, g, b,
+			model.GammaRGB, model, Method);
+		return BasicRgbColor<T>(r, g, b);
+	}
+
+	template <typename T>
+	constexpr BasicRgbColor<T> ToRGB(const BasicLabColor<T>& lab, RgbEnum Model = RgbEnum::sRGB,
+		IlluminantEnum White = IlluminantEnum::D50, AdaptationEnum Method = AdaptationEnum::amBradford)
+	{
+		return ToRGB(ToXYZ(lab, White), Model, White, Method);
+	}
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "ColorDelta.h"
+#include "ColorPlan.h"
+#include "ColorPool.h"
+#include "ColorSimd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+namespace COLORNS
+{
+	// color pairs per pass, the six scratch planes stay in L1
+	constexpr size_t kDeltaChunk = 256;
+	// P95 histogram: bins of 1/64 up to 64, larger differences in the last one
+	constexpr int kDiffBinsPerUnit = 64;
+	constexpr int kDiffBins = 64 * kDiffBinsPerUnit;
+
+	namespace
+	{
+		// count pairs starting at pair first; out gets count values
+		void DeltaEChunk(DeltaEEnum formula, const float* lab1, const float* lab2, float* out,
+			size_t n, size_t first, size_t count, LayoutEnum layout)
+		{
+			float p[6][kDeltaChunk];
+			for (size_t i = 0; i < count; ++i)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					const size_t at = (layout == LayoutEnum::Planar) ? c * n + first + i : (first + i) * 3 + c;
+					p[c][i] = lab1[at];
+					p[c + 3][i] = lab2[at];
+				}
+			}
+
+			switch (formula)
+			{
+			case DeltaEEnum::CIE76:
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float dl = p[3][i] - p[0][i];
+					const float da = p[4][i] - p[1][i];
+					const float db = p[5][i] - p[2][i];
+					out[i] = std::sqrt(dl * dl + da * da + db * db);
+				}
+				break;
+			case DeltaEEnum::CIE94:
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float c1 = std::sqrt(p[1][i] * p[1][i] + p[2][i] * p[2][i]);
+					const float c2 = std::sqrt(p[4][i] * p[4][i] + p[5][i] * p[5][i]);
+					const float dl = p[3][i] - p[0][i];
+					const float dc = c2 - c1;
+					const float da = p[4][i] - p[1][i];
+					const float db = p[5][i] - p[2][i];
+					const float dh2 = std::max(0.0f, da * da + db * db - dc * dc);
+					const float sc = 1.0f + 0.045f * c1;
+					const float sh = 1.0f + 0.015f * c1;
+					out[i] = std::sqrt(dl * dl + (dc / sc) * (dc / sc) + dh2 / (sh * sh));
+				}
+				break;
+			default:
+			case DeltaEEnum::CIEDE2000:
+				GetSimdKernels().DeltaE2000(p[0], p[1], p[2], p[3], p[4], p[5], out, count);
+				break;
+			}
+		}
+
+		void DeltaERange(DeltaEEnum formula, const float* lab1, const float* lab2, float* out,
+			size_t n, size_t first, size_t last, LayoutEnum layout)
+		{
+			for (size_t start = first; start < last; start += kDeltaChunk)
+			{
+				const size_t count = (last - start < kDeltaChunk) ? last - start : kDeltaChunk;
+				DeltaEChunk(formula, lab1, lab2, out + start, n, start, count, layout);
+			}
+		}
+	}
+
+	void DeltaEBuffer(DeltaEEnum formula, const float* lab1, const float* lab2, float* out, size_t n,
+		LayoutEnum layout)
+	{
+		DeltaERange(formula, lab1, lab2, out, n, 0, n, layout);
+	}
+
+	void DeltaEBuffer(ThreadPool& pool, DeltaEEnum formula, const float* lab1, const float* lab2,
+		float* out, size_t n, LayoutEnum layout, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			DeltaERange(formula, lab1, lab2, out, n, first, last, layout);
+		});
+	}
+
+	namespace
+	{
+		// totals of one kTilePixels tile, summed in tile order so the pool can't change the mean
+		typedef struct _DiffTile
+		{
+			double Sum{ 0.0 };
+			double SumSq{ 0.0 };
+			float Max{ -1.0f };
+			size_t MaxIndex{ 0 };
+			size_t Over{ 0 };
+		} DiffTile;
+
+		void DiffToLab(const ConversionPlan& plan, const float* rgb, float* lab, size_t n)
+		{
+			ConvertBuffer(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb, lab, n);
+		}
+
+		void DiffToLab(const ConversionPlan& plan, const uint8_t* rgb, float* lab, size_t n)
+		{
+			ConvertBuffer(plan, ModelEnum::Lab, rgb, lab, n);
+		}
+
+		template <typename C>
+		void DiffRange(const ConversionPlan& plan, DeltaEEnum formula, const C* rgb1, const C* rgb2,
+			float* map, size_t first, size_t last, float threshold, DiffTile& tile, size_t* bins)
+		{
+			float lab1[kDeltaChunk * 3];
+			float lab2[kDeltaChunk * 3];
+			float de[kDeltaChunk];
+			for (size_t start = first; start < last; start += kDeltaChunk)
+			{
+				const size_t count = (last - start < kDeltaChunk) ? last - start : kDeltaChunk;
+				DiffToLab(plan, rgb1 + start * 3, lab1, count);
+				DiffToLab(plan, rgb2 + start * 3, lab2, count);
+				DeltaEChunk(formula, lab1, lab2, de, count, 0, count, LayoutEnum::Interleaved);
+				for (size_t i = 0; i < count; ++i)
+				{
+					const float v = de[i];
+					if (map)
+						map[start + i] = v;
+					tile.Sum += v;
+					tile.SumSq += static_cast<double>(v) * v;
+					if (v > tile.Max)
+					{
+						tile.Max = v;
+						tile.MaxIndex = start + i;
+					}
+					if (v > threshold)
+						++tile.Over;
+					++bins[(v < 64.0f) ? static_cast<int>(v * kDiffBinsPerUnit) : kDiffBins - 1];
+				}
+			}
+		}
+
+		template <typename C>
+		DiffStats DiffBuffers(ThreadPool* pool, const ConversionPlan& plan, DeltaEEnum formula,
+			const C* rgb1, const C* rgb2, float* map, size_t n, float threshold)
+		{
+			DiffStats stats;
+			if (n == 0)
+				return stats;
+			std::vector<DiffTile> tiles((n + kTilePixels - 1) / kTilePixels);
+			std::vector<size_t> bins(kDiffBins, 0);
+			std::mutex lock;
+			auto body = [&](size_t first, size_t last)
+			{
+				std::vector<size_t> local(kDiffBins, 0);
+				for (size_t t = first / kTilePixels; t * kTilePixels < last; ++t)
+				{
+					const size_t end = ((t + 1) * kTilePixels < last) ? (t + 1) * kTilePixels : last;
+					DiffRange(plan, formula, rgb1, rgb2, map, t * kTilePixels, end, threshold, tiles[t], local.data());
+				}
+				std::lock_guard<std::mutex> guard(lock);
+				for (int b = 0; b < kDiffBins; ++b)
+					bins[b] += local[b];
+			};
+			if (pool)
+				pool->ParallelFor(n, kTilePixels, body);
+			else
+				body(0, n);
+
+			double sum = 0.0;
+			double sumSq = 0.0;
+			stats.Pixels = n;
+			for (const DiffTile& tile : tiles)
+			{
+				sum += tile.Sum;
+				sumSq += tile.SumSq;
+				stats.Over += tile.Over;
+				if (tile.Max > stats.Max)
+				{
+					stats.Max = tile.Max;
+					stats.MaxIndex = tile.MaxIndex;
+				}
+			}
+			stats.Mean = sum / n;
+			stats.Rms = std::sqrt(sumSq / n);
+
+			const size_t rank = static_cast<size_t>(std::ceil(0.95 * n));
+			size_t seen = 0;
+			for (int b = 0; b < kDiffBins; ++b)
+			{
+				seen += bins[b];
+				if (seen >= rank)
+				{
+					stats.P95 = (b == kDiffBins - 1) ? stats.Max
+						: std::min(stats.Max, static_cast<double>(b + 1) / kDiffBinsPerUnit);
+					break;
+				}
+			}
+			return stats;
+		}
+	}
+
+	DiffStats DiffImages(const ConversionPlan& plan, DeltaEEnum formula,
+		const float* rgb1, const float* rgb2, float* map, size_t n, float threshold)
+	{
+		return DiffBuffers(nullptr, plan, formula, rgb1, rgb2, map, n, threshold);
+	}
+
+	DiffStats DiffImages(const ConversionPlan& plan, DeltaEEnum formula,
+		const uint8_t* rgb1, const uint8_t* rgb2, float* map, size_t n, float threshold)
+	{
+		return DiffBuffers(nullptr, plan, formula, rgb1, rgb2, map, n, threshold);
+	}
+
+	DiffStats DiffImages(ThreadPool& pool, const ConversionPlan& plan, DeltaEEnum formula,
+		const float* rgb1, const float* rgb2, float* map, size_t n, float threshold)
+	{
+		return DiffBuffers(&pool, plan, formula, rgb1, rgb2, map, n, threshold);
+	}
+
+	DiffStats DiffImages(ThreadPool& pool, const ConversionPlan& plan, DeltaEEnum formula,
+		const uint8_t* rgb1, const uint8_t* rgb2, float* map, size_t n, float threshold)
+	{
+		return DiffBuffers(&pool, plan, formula, rgb1, rgb2, map, n, threshold);
+	}
+};
@@ -0,0 +1,51 @@
+#ifndef _COLORDELTA_H_
+#define _COLORDELTA_H_
+
+#include "ColorBuffer.h"
+
+namespace COLORNS
+{
+	enum class DeltaEEnum
+	{
+		CIE76 = 0,		// Euclidean distance in Lab
+		CIE94 = 1,		// graphic arts weights, the first color is the reference
+		CIEDE2000 = 2	// the SIMD kernel, within kSimdDeltaETolerance of DeltaE2000
+	};
+
+	// out[i] = difference of the Lab colors i of lab1 and lab2, out holds n values
+	void DeltaEBuffer(DeltaEEnum formula, const float* lab1, const float* lab2, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	class ThreadPool;
+
+	void DeltaEBuffer(ThreadPool& pool, DeltaEEnum formula, const float* lab1, const float* lab2,
+		float* out, size_t n, LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels);
+
+	// summary of a difference map
+	typedef struct _DiffStats
+	{
+		size_t Pixels{ 0 };
+		double Mean{ 0.0 };
+		double Rms{ 0.0 };
+		double Max{ 0.0 };
+		size_t MaxIndex{ 0 };		// first pixel with the max difference
+		double P95{ 0.0 };			// 95th percentile, rounded up to 1/64 (exact above 64: Max)
+		size_t Over{ 0 };			// pixels above the threshold
+	} DiffStats;
+
+	class ConversionPlan;
+
+	// Image diff in one fused pass: chunk by chunk both interleaved RGB images go
+	// through plan to Lab, the differences go to map (n values, may be nullptr)
+	// and into the statistics. The pool overloads give the same results.
+	DiffStats DiffImages(const ConversionPlan& plan, DeltaEEnum formula,
+		const float* rgb1, const float* rgb2, float* map, size_t n, float threshold = 1.0f);
+	DiffStats DiffImages(const ConversionPlan& plan, DeltaEEnum formula,
+		const uint8_t* rgb1, const uint8_t* rgb2, float* map, size_t n, float threshold = 1.0f);
+	DiffStats DiffImages(ThreadPool& pool, const ConversionPlan& plan, DeltaEEnum formula,
+		const float* rgb1, const float* rgb2, float* map, size_t n, float threshold = 1.0f);
+	DiffStats DiffImages(ThreadPool& pool, const ConversionPlan& plan, DeltaEEnum formula,
+		const uint8_t* rgb1, const uint8_t* rgb2, float* map, size_t n, float threshold = 1.0f);
+};
+
+#endif
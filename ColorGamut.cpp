@@ -0,0 +1,238 @@
+#include "ColorGamut.h"
+#include "ColorPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace COLORNS
+{
+	constexpr int kGamutMinNodes = 2;
+	// colors per Map pass, the scratch stays on the stack
+	constexpr size_t kGamutChunk = 256;
+	// upper end of the boundary search: above the chroma of every RGB space primary
+	constexpr float kGamutMaxChroma = 400.0f;
+	// bisection steps of the boundary search, 400 / 2^20 chroma
+	constexpr int kGamutSearchSteps = 20;
+	constexpr double kGamutPi = 3.14159265358979323846;
+
+	namespace
+	{
+		bool InGamut(const float* rgb, float epsilon = kGamutEpsilon)
+		{
+			return rgb[0] >= -epsilon && rgb[0] <= 1.0f + epsilon
+				&& rgb[1] >= -epsilon && rgb[1] <= 1.0f + epsilon
+				&& rgb[2] >= -epsilon && rgb[2] <= 1.0f + epsilon;
+		}
+	}
+
+	GamutMap::GamutMap(const ConversionPlan& plan, int levels, int hues) :
+		m_plan(plan),
+		m_levels(std::max(levels, kGamutMinNodes)),
+		m_hues(std::max(hues, kGamutMinNodes))
+	{
+		// every node searched at once: lo stays in gamut, hi out of it. The test has
+		// no epsilon, so the boundary between the nodes keeps kGamutEpsilon to spare
+		const size_t nodes = static_cast<size_t>(m_levels) * m_hues;
+		std::vector<float> lo(nodes, 0.0f), hi(nodes, kGamutMaxChroma);
+		std::vector<float> lab(nodes * 3), rgb(nodes * 3);
+		for (int step = 0; step <= kGamutSearchSteps; ++step)
+		{
+			for (size_t i = 0; i < nodes; ++i)
+			{
+				const double L = 100.0 * (i / m_hues) / (m_levels - 1);
+				const double h = 2.0 * kGamutPi * (i % m_hues) / m_hues;
+				// the first step tries the upper end itself
+				const double c = (step == 0) ? hi[i] : 0.5 * (lo[i] + hi[i]);
+				lab[i * 3] = static_cast<float>(L);
+				lab[i * 3 + 1] = static_cast<float>(c * std::cos(h));
+				lab[i * 3 + 2] = static_cast<float>(c * std::sin(h));
+			}
+			ConvertBuffer(m_plan, ModelEnum::Lab, ModelEnum::Rgb, lab.data(), rgb.data(), nodes);
+			for (size_t i = 0; i < nodes; ++i)
+			{
+				const float c = (step == 0) ? hi[i] : 0.5f * (lo[i] + hi[i]);
+				if (InGamut(&rgb[i * 3], 0.0f))
+					lo[i] = c;
+				else
+					hi[i] = c;
+			}
+		}
+		m_chroma = lo;
+	}
+
+	const ConversionPlan& GamutMap::GetPlan() const noexcept
+	{
+		return m_plan;
+	}
+
+	int GamutMap::GetLevels() const noexcept
+	{
+		return m_levels;
+	}
+
+	int GamutMap::GetHues() const noexcept
+	{
+		return m_hues;
+	}
+
+	float GamutMap::GetMaxChroma(float L, float hue) const noexcept
+	{
+		float t = L * (m_levels - 1) / 100.0f;
+		if (!(t > 0.0f))	// NaN too
+			t = 0.0f;
+		int i = static_cast<int>(t);
+		if (i > m_levels - 2)
+			i = m_levels - 2;
+		const float fl = std::min(t - static_cast<float>(i), 1.0f);
+
+		float u = std::fmod(hue, 360.0f) * m_hues / 360.0f;
+		if (u < 0.0f)
+			u += static_cast<float>(m_hues);
+		if (!(u >= 0.0f && u < static_cast<float>(m_hues)))
+			u = 0.0f;
+		const int j = static_cast<int>(u);
+		const int j1 = (j + 1 == m_hues) ? 0 : j + 1;
+		const float fh = u - static_cast<float>(j);
+
+		const float* row = &m_chroma[static_cast<size_t>(i) * m_hues];
+		const float* next = row + m_hues;
+		const float c0 = row[j] + fh * (row[j1] - row[j]);
+		const float c1 = next[j] + fh * (next[j1] - next[j]);
+		return c0 + fl * (c1 - c0);
+	}
+
+	// n (up to kGamutChunk) out of gamut Lab colors to the boundary at their L and hue:
+	// the table chroma, then bisection towards the neutral axis for the colors the
+	// interpolated boundary leaves outside; rgb gets the mapped colors
+	void GamutMap::Reduce(float* lab, float* rgb, size_t n) const
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			float* c = lab + i * 3;
+			c[0] = std::min(std::max(c[0], 0.0f), 100.0f);
+			const float chroma = std::sqrt(c[1] * c[1] + c[2] * c[2]);
+			const float hue = static_cast<float>(std::atan2(c[2], c[1]) * (180.0 / kGamutPi));
+			const float limit = GetMaxChroma(c[0], hue);
+			if (chroma > limit)
+			{
+				const float s = limit / chroma;
+				c[1] *= s;
+				c[2] *= s;
+			}
+		}
+		ConvertBuffer(m_plan, ModelEnum::Lab, ModelEnum::Rgb, lab, rgb, n);
+
+		// the misses searched together, one conversion per step; the scale of their
+		// a and b lies in [lo, hi], the neutral axis (0) is in gamut
+		size_t at[kGamutChunk];
+		size_t count = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			if (!InGamut(rgb + i * 3))
+				at[count++] = i;
+		}
+		if (count == 0)
+			return;
+		float lo[kGamutChunk], hi[kGamutChunk];
+		float probe[kGamutChunk * 3], probeRgb[kGamutChunk * 3];
+		for (size_t i = 0; i < count; ++i)
+		{
+			lo[i] = 0.0f;
+			hi[i] = 1.0f;
+			probe[i * 3] = lab[at[i] * 3];
+			probe[i * 3 + 1] = 0.0f;
+			probe[i * 3 + 2] = 0.0f;
+		}
+		ConvertBuffer(m_plan, ModelEnum::Lab, ModelEnum::Rgb, probe, probeRgb, count);
+		for (size_t i = 0; i < count; ++i)
+			std::copy(&probeRgb[i * 3], &probeRgb[i * 3] + 3, rgb + at[i] * 3);
+		for (int step = 0; step < kGamutSteps; ++step)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float mid = 0.5f * (lo[i] + hi[i]);
+				probe[i * 3 + 1] = lab[at[i] * 3 + 1] * mid;
+				probe[i * 3 + 2] = lab[at[i] * 3 + 2] * mid;
+			}
+			ConvertBuffer(m_plan, ModelEnum::Lab, ModelEnum::Rgb, probe, probeRgb, count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float mid = 0.5f * (lo[i] + hi[i]);
+				if (InGamut(&probeRgb[i * 3]))
+				{
+					lo[i] = mid;
+					std::copy(&probeRgb[i * 3], &probeRgb[i * 3] + 3, rgb + at[i] * 3);
+				}
+				else
+				{
+					hi[i] = mid;
+				}
+			}
+		}
+	}
+
+	size_t GamutMap::Map(ModelEnum src_model, const float* in, float* rgb, uint8_t* mask, size_t n,
+		GamutEnum mode) const
+	{
+		size_t outside = 0;
+		float converted[kGamutChunk * 3];
+		float lab[kGamutChunk * 3];
+		float mapped[kGamutChunk * 3];
+		size_t at[kGamutChunk];
+		for (size_t start = 0; start < n; start += kGamutChunk)
+		{
+			const size_t chunk = std::min(kGamutChunk, n - start);
+			const float* src = in + start * 3;
+			ConvertBuffer(m_plan, src_model, ModelEnum::Rgb, src, converted, chunk);
+
+			size_t count = 0;
+			for (size_t i = 0; i < chunk; ++i)
+			{
+				const bool inside = InGamut(&converted[i * 3]);
+				if (mask)
+					mask[start + i] = inside ? 0 : 1;
+				if (!inside)
+					at[count++] = i;
+			}
+
+			if (mode == GamutEnum::Chroma && count > 0)
+			{
+				for (size_t i = 0; i < count; ++i)
+					std::copy(src + at[i] * 3, src + at[i] * 3 + 3, &lab[i * 3]);
+				if (src_model != ModelEnum::Lab)
+					ConvertBuffer(m_plan, src_model, ModelEnum::Lab, lab, lab, count);
+				Reduce(lab, mapped, count);
+				for (size_t i = 0; i < count; ++i)
+					std::copy(&mapped[i * 3], &mapped[i * 3] + 3, &converted[at[i] * 3]);
+			}
+			// the in gamut colors within kGamutEpsilon too
+			if (mode != GamutEnum::None)
+			{
+				for (size_t i = 0; i < chunk * 3; ++i)
+					converted[i] = std::min(std::max(converted[i], 0.0f), 1.0f);
+			}
+
+			std::copy(converted, converted + chunk * 3, rgb + start * 3);
+			outside += count;
+		}
+		return outside;
+	}
+
+	size_t GamutMap::Map(ThreadPool& pool, ModelEnum src_model, const float* in, float* rgb, uint8_t* mask,
+		size_t n, GamutEnum mode, size_t tile) const
+	{
+		// a count per tile, added up once every tile is done
+		if (tile == 0)
+			tile = 1;
+		std::vector<size_t> counts((n + tile - 1) / tile, 0);
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			counts[first / tile] = Map(src_model, in + first * 3, rgb + first * 3,
+				mask ? mask + first : nullptr, last - first, mode);
+		});
+		size_t outside = 0;
+		for (size_t c : counts)
+			outside += c;
+		return outside;
+	}
+};
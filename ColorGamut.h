@@ -0,0 +1,58 @@
+#ifndef _COLORGAMUT_H_
+#define _COLORGAMUT_H_
+
+#include "ColorBuffer.h"
+#include "ColorPlan.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace COLORNS
+{
+	enum class GamutEnum
+	{
+		None = 0,		// test only, out of gamut values are left as converted
+		Clip = 1,		// each channel clamped to [0, 1]
+		Chroma = 2		// chroma reduced at constant L and hue, then clamped
+	};
+
+	// RGB channels this far outside [0, 1] still count as in gamut: float and
+	// approximate companding error on colors right at the boundary
+	constexpr float kGamutEpsilon = 1e-4f;
+	// bisection steps for the colors the interpolated boundary doesn't bring into gamut,
+	// the chroma they keep is within 1 / 2^kGamutSteps of the boundary
+	constexpr int kGamutSteps = 12;
+
+	// The gamut of the plan's RGB space in Lab (plan's white): the largest in gamut
+	// chroma per L and hue, sampled on a levels x hues grid once, so mapping a color
+	// costs a table lookup instead of a search per pixel.
+	class GamutMap
+	{
+		ConversionPlan m_plan;
+		int m_levels;
+		int m_hues;
+		// L varies slowest, L from 0 to 100, hue from 0 up to 360 degrees
+		std::vector<float> m_chroma;
+
+		void Reduce(float* lab, float* rgb, size_t n) const;
+	public:
+		explicit GamutMap(const ConversionPlan& plan, int levels = 101, int hues = 360);
+
+		const ConversionPlan& GetPlan() const noexcept;
+		int GetLevels() const noexcept;
+		int GetHues() const noexcept;
+
+		// the boundary, bilinear between the grid nodes; hue in degrees
+		float GetMaxChroma(float L, float hue) const noexcept;
+
+		// n colors of src_model to companded RGB of the plan's space; mask (may be nullptr)
+		// gets 1 for each color that was out of gamut, else 0. Returns how many were out.
+		// in and rgb may point to the same buffer.
+		size_t Map(ModelEnum src_model, const float* in, float* rgb, uint8_t* mask, size_t n,
+			GamutEnum mode = GamutEnum::Chroma) const;
+		size_t Map(ThreadPool& pool, ModelEnum src_model, const float* in, float* rgb, uint8_t* mask,
+			size_t n, GamutEnum mode = GamutEnum::Chroma, size_t tile = kTilePixels) const;
+	};
+};
+
+#endif
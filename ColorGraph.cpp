@@ -0,0 +1,201 @@
+#include "ColorGraph.h"
+#include "ColorPlan.h"
+
+namespace COLORNS
+{
+	namespace
+	{
+		// the chain: one model to its neighbour
+		void GraphHsv2Rgb(const ConversionPlan&, const double in[3], double out[3])
+		{
+			double r = 0.0, g = 0.0, b = 0.0;
+			GetRGBfromHSV(in[0], in[1], in[2], r, g, b);
+			out[0] = r;
+			out[1] = g;
+			out[2] = b;
+		}
+
+		void GraphRgb2Hsv(const ConversionPlan&, const double in[3], double out[3])
+		{
+			double h = 0.0, s = 0.0, p = 0.0, v = 0.0, l = 0.0;
+			GetHSPVL(in[0], in[1], in[2], h, s, p, v, l);
+			out[0] = h;
+			out[1] = s;
+			out[2] = v;
+		}
+
+		void GraphRgb2Xyz(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double x = 0.0, y = 0.0, z = 0.0;
+			plan.RGB2XYZ(in[0], in[1], in[2], x, y, z);
+			out[0] = x;
+			out[1] = y;
+			out[2] = z;
+		}
+
+		void GraphXyz2Rgb(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double r = 0.0, g = 0.0, b = 0.0;
+			plan.XYZ2RGB(in[0], in[1], in[2], r, g, b);
+			out[0] = r;
+			out[1] = g;
+			out[2] = b;
+		}
+
+		void GraphXyz2Lab(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double l = 0.0, a = 0.0, b = 0.0;
+			XYZ2LabFast(in[0], in[1], in[2], plan.GetRefWhite(), l, a, b);
+			out[0] = l;
+			out[1] = a;
+			out[2] = b;
+		}
+
+		void GraphLab2Xyz(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double x = 0.0, y = 0.0, z = 0.0;
+			Lab2XYZFast(in[0], in[1], in[2], plan.GetRefWhite(), x, y, z);
+			out[0] = x;
+			out[1] = y;
+			out[2] = z;
+		}
+
+		// fused: the intermediate models stay in registers
+		void GraphHsv2Xyz(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double r = 0.0, g = 0.0, b = 0.0;
+			GetRGBfromHSV(in[0], in[1], in[2], r, g, b);
+			plan.RGB2XYZ(r, g, b, out[0], out[1], out[2]);
+		}
+
+		void GraphXyz2Hsv(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double r = 0.0, g = 0.0, b = 0.0, p = 0.0, l = 0.0;
+			plan.XYZ2RGB(in[0], in[1], in[2], r, g, b);
+			GetHSPVL(r, g, b, out[0], out[1], p, out[2], l);
+		}
+
+		void GraphRgb2Lab(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double x = 0.0, y = 0.0, z = 0.0;
+			plan.RGB2XYZ(in[0], in[1], in[2], x, y, z);
+			XYZ2LabFast(x, y, z, plan.GetRefWhite(), out[0], out[1], out[2]);
+		}
+
+		void GraphLab2Rgb(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double x = 0.0, y = 0.0, z = 0.0;
+			Lab2XYZFast(in[0], in[1], in[2], plan.GetRefWhite(), x, y, z);
+			plan.XYZ2RGB(x, y, z, out[0], out[1], out[2]);
+		}
+
+		void GraphHsv2Lab(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double r = 0.0, g = 0.0, b = 0.0, x = 0.0, y = 0.0, z = 0.0;
+			GetRGBfromHSV(in[0], in[1], in[2], r, g, b);
+			plan.RGB2XYZ(r, g, b, x, y, z);
+			XYZ2LabFast(x, y, z, plan.GetRefWhite(), out[0], out[1], out[2]);
+		}
+
+		void GraphLab2Hsv(const ConversionPlan& plan, const double in[3], double out[3])
+		{
+			double r = 0.0, g = 0.0, b = 0.0, x = 0.0, y = 0.0, z = 0.0, p = 0.0, l = 0.0;
+			Lab2XYZFast(in[0], in[1], in[2], plan.GetRefWhite(), x, y, z);
+			plan.XYZ2RGB(x, y, z, r, g, b);
+			GetHSPVL(r, g, b, out[0], out[1], p, out[2], l);
+		}
+
+		// costs: each kernel timed inside a loop over in gamut colors, rounded
+		const ConversionEdge kGraphEdges[] = {
+			{ ModelEnum::Hsv, ModelEnum::Rgb, 12.0, GraphHsv2Rgb },
+			{ ModelEnum::Rgb, ModelEnum::Hsv, 10.0, GraphRgb2Hsv },
+			{ ModelEnum::Rgb, ModelEnum::Xyz, 84.0, GraphRgb2Xyz },
+			{ ModelEnum::Xyz, ModelEnum::Rgb, 80.0, GraphXyz2Rgb },
+			{ ModelEnum::Xyz, ModelEnum::Lab, 14.0, GraphXyz2Lab },
+			{ ModelEnum::Lab, ModelEnum::Xyz, 11.0, GraphLab2Xyz },
+			{ ModelEnum::Hsv, ModelEnum::Xyz, 92.0, GraphHsv2Xyz },
+			{ ModelEnum::Xyz, ModelEnum::Hsv, 85.0, GraphXyz2Hsv },
+			{ ModelEnum::Rgb, ModelEnum::Lab, 92.0, GraphRgb2Lab },
+			{ ModelEnum::Lab, ModelEnum::Rgb, 63.0, GraphLab2Rgb },
+			{ ModelEnum::Hsv, ModelEnum::Lab, 104.0, GraphHsv2Lab },
+			{ ModelEnum::Lab, ModelEnum::Hsv, 72.0, GraphLab2Hsv }
+		};
+	}
+
+	const ConversionEdge* GetConversionEdges(size_t& count)
+	{
+		count = sizeof(kGraphEdges) / sizeof(kGraphEdges[0]);
+		return kGraphEdges;
+	}
+
+	namespace
+	{
+		// Floyd-Warshall over the models, then each route read off the first-edge table
+		typedef struct _RouteTable
+		{
+			ConversionRoute routes[kModelCount][kModelCount];
+			_RouteTable()
+			{
+				const double kNoRoute = 1e30;
+				double cost[kModelCount][kModelCount];
+				const ConversionEdge* first[kModelCount][kModelCount];
+				for (size_t i = 0; i < kModelCount; ++i)
+					for (size_t j = 0; j < kModelCount; ++j)
+					{
+						cost[i][j] = (i == j) ? 0.0 : kNoRoute;
+						first[i][j] = nullptr;
+					}
+				for (const ConversionEdge& edge : kGraphEdges)
+				{
+					const size_t i = static_cast<size_t>(edge.From);
+					const size_t j = static_cast<size_t>(edge.To);
+					if (edge.Cost < cost[i][j])
+					{
+						cost[i][j] = edge.Cost;
+						first[i][j] = &edge;
+					}
+				}
+				for (size_t k = 0; k < kModelCount; ++k)
+					for (size_t i = 0; i < kModelCount; ++i)
+						for (size_t j = 0; j < kModelCount; ++j)
+							if (cost[i][k] + cost[k][j] < cost[i][j])
+							{
+								cost[i][j] = cost[i][k] + cost[k][j];
+								first[i][j] = first[i][k];
+							}
+
+				for (size_t i = 0; i < kModelCount; ++i)
+					for (size_t j = 0; j < kModelCount; ++j)
+					{
+						ConversionRoute& route = routes[i][j];
+						route.Count = 0;
+						route.Cost = cost[i][j];
+						for (size_t at = i; at != j && route.Count < kModelCount - 1; )
+						{
+							const ConversionEdge* edge = first[at][j];
+							route.Edges[route.Count++] = edge;
+							at = static_cast<size_t>(edge->To);
+						}
+					}
+			}
+		} RouteTable;
+	}
+
+	const ConversionRoute& GetConversionRoute(ModelEnum src_model, ModelEnum dst_model)
+	{
+		static const RouteTable table;
+		return table.routes[static_cast<size_t>(src_model)][static_cast<size_t>(dst_model)];
+	}
+
+	void ConvertColor(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+		const double in[3], double out[3])
+	{
+		const ConversionRoute& route = GetConversionRoute(src_model, dst_model);
+		double c[3] = { in[0], in[1], in[2] };
+		for (size_t i = 0; i < route.Count; ++i)
+			route.Edges[i]->Kernel(plan, c, c);
+		out[0] = c[0];
+		out[1] = c[1];
+		out[2] = c[2];
+	}
+};
@@ -0,0 +1,45 @@
+#ifndef _COLORGRAPH_H_
+#define _COLORGRAPH_H_
+
+#include "ColorBuffer.h"
+
+namespace COLORNS
+{
+	constexpr size_t kModelCount = 4;
+
+	class ConversionPlan;
+
+	// one color of From to To with the settings of plan, in double; in and out may alias.
+	// Triples are in the order of the color classes, HSV is (hue, saturation, value).
+	typedef void (*ConvertKernel)(const ConversionPlan& plan, const double in[3], double out[3]);
+
+	typedef struct _ConversionEdge
+	{
+		ModelEnum From;
+		ModelEnum To;
+		double Cost;			// ns per color, measured on the Exact plan
+		ConvertKernel Kernel;
+	} ConversionEdge;
+
+	// the cheapest way from one model to another, Count edges (none from a model to itself)
+	typedef struct _ConversionRoute
+	{
+		const ConversionEdge* Edges[kModelCount - 1];
+		size_t Count;
+		double Cost;
+	} ConversionRoute;
+
+	// The conversion graph: the HSV - RGB - XYZ - Lab chain plus fused kernels that go
+	// across it without leaving the intermediate models anywhere. count gets the edges.
+	const ConversionEdge* GetConversionEdges(size_t& count);
+
+	// shortest routes between every two models, found once over the edge costs
+	const ConversionRoute& GetConversionRoute(ModelEnum src_model, ModelEnum dst_model);
+
+	// one color along GetConversionRoute; the Lab kernels are the pow-free ones,
+	// as in ConvertBuffer with an Exact plan
+	void ConvertColor(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model,
+		const double in[3], double out[3]);
+};
+
+#endif
@@ -0,0 +1,447 @@
+#include "ColorImage.h"
+#include "ColorPlan.h"
+#include "ColorPool.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace COLORNS
+{
+	// pixels per kernel call, the stack scratch of a row chunk stays in L1
+	constexpr size_t kImageChunk = 1024;
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::OpenRead(const std::string& path)
+	{
+		Close();
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		m_file = file;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+		m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping)
+			m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_data)
+		{
+			Close();
+			return false;
+		}
+		m_size = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	bool MappedFile::Create(const std::string& path, size_t size)
+	{
+		Close();
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		m_file = file;
+		const unsigned long long bytes = size;
+		m_mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(bytes >> 32), static_cast<DWORD>(bytes & 0xffffffffu), nullptr);
+		if (m_mapping)
+			m_data = static_cast<unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+		if (!m_data)
+		{
+			Close();
+			return false;
+		}
+		m_size = size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		if (m_file)
+			CloseHandle(m_file);
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_size = 0;
+	}
+#else
+	bool MappedFile::OpenRead(const std::string& path)
+	{
+		Close();
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+		struct stat st;
+		if (fstat(m_file, &st) != 0 || st.st_size <= 0)
+		{
+			Close();
+			return false;
+		}
+		void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+		if (data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<unsigned char*>(data);
+		m_size = static_cast<size_t>(st.st_size);
+		return true;
+	}
+
+	bool MappedFile::Create(const std::string& path, size_t size)
+	{
+		Close();
+		m_file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (m_file < 0)
+			return false;
+		if (size == 0 || ftruncate(m_file, static_cast<off_t>(size)) != 0)
+		{
+			Close();
+			return false;
+		}
+		void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+		if (data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<unsigned char*>(data);
+		m_size = size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_data)
+			munmap(m_data, m_size);
+		if (m_file >= 0)
+			close(m_file);
+		m_data = nullptr;
+		m_file = -1;
+		m_size = 0;
+	}
+#endif
+
+	const unsigned char* MappedFile::GetData() const noexcept
+	{
+		return m_data;
+	}
+
+	unsigned char* MappedFile::GetData() noexcept
+	{
+		return m_data;
+	}
+
+	size_t MappedFile::GetSize() const noexcept
+	{
+		return m_size;
+	}
+
+	bool IsBigEndianHost()
+	{
+		const uint16_t one = 1;
+		unsigned char first;
+		memcpy(&first, &one, 1);
+		return first == 0;
+	}
+
+	namespace
+	{
+		// next header field, blanks and # comments before it skipped
+		bool ReadImageToken(const unsigned char*& p, const unsigned char* end, std::string& token)
+		{
+			while (p < end && (isspace(*p) || *p == '#'))
+			{
+				if (*p == '#')
+					while (p < end && *p != '\n')
+						++p;
+				else
+					++p;
+			}
+			token.clear();
+			while (p < end && !isspace(*p) && token.size() < 32)
+				token += static_cast<char>(*p++);
+			return !token.empty();
+		}
+	}
+
+	bool ReadImageHeader(const unsigned char* data, size_t size, ImageInfo& info, std::string& error)
+	{
+		const unsigned char* p = data;
+		const unsigned char* end = data + size;
+		std::string magic, width, height, last;
+		if (!ReadImageToken(p, end, magic) || (magic != "P6" && magic != "PF"))
+		{
+			error = "not a P6 (binary PPM) or PF (color PFM) image";
+			return false;
+		}
+		if (!ReadImageToken(p, end, width) || !ReadImageToken(p, end, height) || !ReadImageToken(p, end, last)
+			|| p >= end || !isspace(*p))
+		{
+			error = "truncated image header";
+			return false;
+		}
+		info.DataOffset = static_cast<size_t>(p + 1 - data);
+
+		char* stop = nullptr;
+		info.Width = strtoul(width.c_str(), &stop, 10);
+		bool ok = *stop == '\0';
+		info.Height = strtoul(height.c_str(), &stop, 10);
+		ok = ok && *stop == '\0' && info.Width > 0 && info.Height > 0
+			&& info.Width < (1u << 20) && info.Height < (1u << 20);
+
+		size_t sample = 4;
+		if (magic == "P6")
+		{
+			const unsigned long maxval = strtoul(last.c_str(), &stop, 10);
+			ok = ok && *stop == '\0' && maxval > 0 && maxval <= 65535;
+			info.MaxValue = static_cast<unsigned>(maxval);
+			info.Format = (maxval < 256) ? ImageFormatEnum::Ppm8 : ImageFormatEnum::Ppm16;
+			info.BigEndian = true;
+			sample = (maxval < 256) ? 1 : 2;
+		}
+		else
+		{
+			const double scale = strtod(last.c_str(), &stop);
+			ok = ok && *stop == '\0' && scale != 0.0;
+			info.Format = ImageFormatEnum::Pfm;
+			info.BigEndian = scale > 0.0;
+		}
+		if (!ok)
+		{
+			error = "bad image header";
+			return false;
+		}
+		if ((size - info.DataOffset) / (info.Width * 3 * sample) < info.Height)
+		{
+			error = "image data is shorter than the header says";
+			return false;
+		}
+		return true;
+	}
+
+	std::string MakeImageHeader(ImageFormatEnum format, size_t width, size_t height)
+	{
+		std::string header = (format == ImageFormatEnum::Pfm) ? "PF\n" : "P6\n";
+		header += std::to_string(width) + " " + std::to_string(height) + "\n";
+		if (format == ImageFormatEnum::Pfm)
+		{
+			// negative scale: little-endian; "-1.0", "-1.00" ... up to the next multiple of 4
+			std::string scale = IsBigEndianHost() ? "1.0" : "-1.0";
+			while ((header.size() + scale.size() + 1) % 4)
+				scale += "0";
+			header += scale + "\n";
+		}
+		else
+		{
+			header += (format == ImageFormatEnum::Ppm8) ? "255\n" : "65535\n";
+		}
+		return header;
+	}
+
+	size_t ImageSampleSize(ImageFormatEnum format)
+	{
+		return (format == ImageFormatEnum::Ppm8) ? 1 : ((format == ImageFormatEnum::Ppm16) ? 2 : 4);
+	}
+
+	namespace
+	{
+		// bits of a P6 depth whose maxval is 2^bits - 1, otherwise 0
+		int ImageCodeBits(unsigned maxval)
+		{
+			for (int bits = 1; bits <= 16; ++bits)
+				if (maxval == (1u << bits) - 1)
+					return bits;
+			return 0;
+		}
+
+		// n pixels of one row: mapped input at src, mapped output at dst
+		void ConvertImageChunk(const ConversionPlan& plan, const ImageInfo& info,
+			ModelEnum src_model, ModelEnum dst_model, ImageFormatEnum out_format,
+			const unsigned char* src, unsigned char* dst, size_t n)
+		{
+			float colors[kImageChunk * 3];
+			uint16_t codes[kImageChunk * 3];
+			const bool direct = (out_format == ImageFormatEnum::Pfm);
+			// PF output rows are 4-byte aligned, see MakeImageHeader
+			float* out = direct ? reinterpret_cast<float*>(dst) : colors;
+
+			if (info.Format == ImageFormatEnum::Pfm)
+			{
+				const float* in = reinterpret_cast<const float*>(src);
+				if (info.BigEndian != IsBigEndianHost() || reinterpret_cast<uintptr_t>(src) % alignof(float))
+				{
+					const bool swap = info.BigEndian != IsBigEndianHost();
+					for (size_t i = 0; i < n * 3; ++i)
+					{
+						unsigned char b[4];
+						memcpy(b, src + i * 4, 4);
+						if (swap)
+						{
+							unsigned char t = b[0]; b[0] = b[3]; b[3] = t;
+							t = b[1]; b[1] = b[2]; b[2] = t;
+						}
+						memcpy(&colors[i], b, 4);
+					}
+					in = colors;
+				}
+				ConvertBuffer(plan, src_model, dst_model, in, out, n);
+			}
+			else
+			{
+				const bool wide = (info.Format == ImageFormatEnum::Ppm16);
+				const int bits = ImageCodeBits(info.MaxValue);
+				if (!wide && bits == 8)
+				{
+					ConvertBuffer(plan, dst_model, reinterpret_cast<const uint8_t*>(src), out, n);
+				}
+				else if (wide && bits)
+				{
+					for (size_t i = 0; i < n * 3; ++i)
+						codes[i] = static_cast<uint16_t>((src[i * 2] << 8) | src[i * 2 + 1]);
+					ConvertBuffer(plan, dst_model, codes, bits, out, n);
+				}
+				else
+				{
+					// odd maxval: normalize to companded RGB floats
+					const float scale = 1.0f / info.MaxValue;
+					for (size_t i = 0; i < n * 3; ++i)
+					{
+						const unsigned code = wide ? ((src[i * 2] << 8) | src[i * 2 + 1]) : src[i];
+						colors[i] = static_cast<float>(code > info.MaxValue ? info.MaxValue : code) * scale;
+					}
+					ConvertBuffer(plan, ModelEnum::Rgb, dst_model, colors, out, n);
+				}
+			}
+
+			if (!direct)
+			{
+				const bool wide = (out_format == ImageFormatEnum::Ppm16);
+				const float max = wide ? 65535.0f : 255.0f;
+				for (size_t i = 0; i < n * 3; ++i)
+				{
+					const float v = colors[i];
+					const unsigned code = !(v > 0.0f) ? 0u : (v >= 1.0f ? static_cast<unsigned>(max)
+						: static_cast<unsigned>(v * max + 0.5f));
+					if (wide)
+					{
+						dst[i * 2] = static_cast<unsigned char>(code >> 8);
+						dst[i * 2 + 1] = static_cast<unsigned char>(code & 0xff);
+					}
+					else
+					{
+						dst[i] = static_cast<unsigned char>(code);
+					}
+				}
+			}
+		}
+
+		bool ConvertImageFile(ThreadPool* pool, const ConversionPlan& plan,
+			const std::string& in, ModelEnum src_model,
+			const std::string& out, ModelEnum dst_model, ImageFormatEnum out_format,
+			std::string& error)
+		{
+			MappedFile source;
+			if (!source.OpenRead(in))
+			{
+				error = "can't open " + in;
+				return false;
+			}
+			ImageInfo info;
+			if (!ReadImageHeader(source.GetData(), source.GetSize(), info, error))
+			{
+				error = in + ": " + error;
+				return false;
+			}
+			if (info.Format != ImageFormatEnum::Pfm && src_model != ModelEnum::Rgb)
+			{
+				error = in + ": P6 images hold RGB only";
+				return false;
+			}
+			if (out_format != ImageFormatEnum::Pfm && dst_model != ModelEnum::Rgb)
+			{
+				error = out + ": P6 images hold RGB only";
+				return false;
+			}
+
+			const std::string header = MakeImageHeader(out_format, info.Width, info.Height);
+			const size_t inRow = info.Width * 3 * ImageSampleSize(info.Format);
+			const size_t outRow = info.Width * 3 * ImageSampleSize(out_format);
+			MappedFile target;
+			if (!target.Create(out, header.size() + outRow * info.Height))
+			{
+				error = "can't create " + out;
+				return false;
+			}
+			memcpy(target.GetData(), header.data(), header.size());
+
+			// PF stores rows bottom to top, P6 top to bottom
+			const bool flip = (info.Format == ImageFormatEnum::Pfm) != (out_format == ImageFormatEnum::Pfm);
+			const unsigned char* src = source.GetData() + info.DataOffset;
+			unsigned char* dst = target.GetData() + header.size();
+			auto rows = [&](size_t first, size_t last)
+			{
+				for (size_t y = first; y < last; ++y)
+				{
+					const unsigned char* srcRow = src + y * inRow;
+					unsigned char* dstRow = dst + (flip ? info.Height - 1 - y : y) * outRow;
+					for (size_t x = 0; x < info.Width; x += kImageChunk)
+					{
+						const size_t n = (info.Width - x < kImageChunk) ? info.Width - x : kImageChunk;
+						ConvertImageChunk(plan, info, src_model, dst_model, out_format,
+							srcRow + x * 3 * ImageSampleSize(info.Format),
+							dstRow + x * 3 * ImageSampleSize(out_format), n);
+					}
+				}
+			};
+			if (pool)
+				pool->ParallelFor(info.Height, (info.Width < kTilePixels) ? kTilePixels / info.Width : 1, rows);
+			else
+				rows(0, info.Height);
+			return true;
+		}
+	}
+
+	bool ConvertImage(const ConversionPlan& plan,
+		const std::string& in, ModelEnum src_model,
+		const std::string& out, ModelEnum dst_model, ImageFormatEnum out_format,
+		std::string& error)
+	{
+		return ConvertImageFile(nullptr, plan, in, src_model, out, dst_model, out_format, error);
+	}
+
+	bool ConvertImage(ThreadPool& pool, const ConversionPlan& plan,
+		const std::string& in, ModelEnum src_model,
+		const std::string& out, ModelEnum dst_model, ImageFormatEnum out_format,
+		std::string& error)
+	{
+		return ConvertImageFile(&pool, plan, in, src_model, out, dst_model, out_format, error);
+	}
+};
@@ -0,0 +1,87 @@
+#ifndef _COLORIMAGE_H_
+#define _COLORIMAGE_H_
+
+#include "ColorBuffer.h"
+
+#include <cstddef>
+#include <string>
+
+namespace COLORNS
+{
+	enum class ImageFormatEnum
+	{
+		Ppm8 = 0,		// P6, maxval up to 255
+		Ppm16 = 1,		// P6, maxval 256..65535, big-endian samples
+		Pfm = 2			// PF, float RGB triples, rows bottom to top
+	};
+
+	typedef struct _ImageInfo
+	{
+		ImageFormatEnum Format{ ImageFormatEnum::Ppm8 };
+		size_t Width{ 0 };
+		size_t Height{ 0 };
+		unsigned MaxValue{ 255 };	// P6 only
+		bool BigEndian{ true };		// PF: positive scale
+		size_t DataOffset{ 0 };		// header size
+	} ImageInfo;
+
+	// A whole file mapped into memory, read-only or created read-write with a fixed size
+	class MappedFile
+	{
+		unsigned char* m_data{ nullptr };
+		size_t m_size{ 0 };
+#ifdef _WIN32
+		void* m_file{ nullptr };
+		void* m_mapping{ nullptr };
+#else
+		int m_file{ -1 };
+#endif
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator= (const MappedFile&) = delete;
+
+		bool OpenRead(const std::string& path);
+		// creates (or truncates) path with size bytes
+		bool Create(const std::string& path, size_t size);
+		void Close();
+
+		const unsigned char* GetData() const noexcept;
+		unsigned char* GetData() noexcept;
+		size_t GetSize() const noexcept;
+	};
+
+	// parses the P6 / PF header at data and checks that the pixels fit in size
+	bool ReadImageHeader(const unsigned char* data, size_t size, ImageInfo& info, std::string& error);
+
+	// header text for the image, PF headers are padded so the floats start 4-byte aligned
+	std::string MakeImageHeader(ImageFormatEnum format, size_t width, size_t height);
+
+	bool IsBigEndianHost();
+
+	// bytes per sample: 1, 2 or 4
+	size_t ImageSampleSize(ImageFormatEnum format);
+
+	class ConversionPlan;
+	class ThreadPool;
+
+	// Converts the image file in to the image file out, both memory-mapped; the kernels
+	// read the mapped input rows and write the mapped output rows, a chunk of a row at a time.
+	// P6 input holds RGB codes of the plan's working space (src_model must be Rgb),
+	// PF input holds src_model floats. PF output gets dst_model floats,
+	// P6 output needs dst_model Rgb and gets the values clamped to [0, 1] and rounded.
+	// false with a message in error when a file can't be read or written.
+	bool ConvertImage(const ConversionPlan& plan,
+		const std::string& in, ModelEnum src_model,
+		const std::string& out, ModelEnum dst_model, ImageFormatEnum out_format,
+		std::string& error);
+
+	// the same with the rows split across pool
+	bool ConvertImage(ThreadPool& pool, const ConversionPlan& plan,
+		const std::string& in, ModelEnum src_model,
+		const std::string& out, ModelEnum dst_model, ImageFormatEnum out_format,
+		std::string& error);
+};
+
+#endif
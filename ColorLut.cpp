@@ -0,0 +1,264 @@
+#include "ColorLut.h"
+#include "ColorPool.h"
+
+#include <cmath>
+
+namespace COLORNS
+{
+	constexpr int kLutMinSize = 2;
+	constexpr int kLutMaxSize = 129;
+
+	namespace
+	{
+		bool SameWhite(const XYZ& a, const XYZ& b)
+		{
+			return a.X == b.X && a.Y == b.Y && a.Z == b.Z;
+		}
+	}
+
+	Lut3D::Lut3D(const ConversionPlan& src_plan, ModelEnum src_model,
+		const ConversionPlan& dst_plan, ModelEnum dst_model, int size) :
+		m_src(src_plan), m_dst(dst_plan), m_srcModel(src_model), m_dstModel(dst_model),
+		m_size(size < kLutMinSize ? kLutMinSize : (size > kLutMaxSize ? kLutMaxSize : size)),
+		m_adapt(!SameWhite(src_plan.GetRefWhite(), dst_plan.GetRefWhite()))
+	{
+		if (m_adapt)
+			GetAdaptationMatrix(src_plan.GetRefWhite(), dst_plan.GetRefWhite(), dst_plan.GetAdaptation(), m_pcs);
+
+		GetModelRange(src_model, m_lo, m_hi);
+		for (int i = 0; i < 3; ++i)
+			m_scale[i] = (m_size - 1) / (m_hi[i] - m_lo[i]);
+
+		// node coordinates, then the analytic path over all of them in one pass
+		const size_t nodes = static_cast<size_t>(m_size) * m_size * m_size;
+		m_grid.resize(nodes * 3);
+		float* node = m_grid.data();
+		for (int i = 0; i < m_size; ++i)
+			for (int j = 0; j < m_size; ++j)
+				for (int k = 0; k < m_size; ++k)
+				{
+					*node++ = m_lo[0] + (m_hi[0] - m_lo[0]) * i / (m_size - 1);
+					*node++ = m_lo[1] + (m_hi[1] - m_lo[1]) * j / (m_size - 1);
+					*node++ = m_lo[2] + (m_hi[2] - m_lo[2]) * k / (m_size - 1);
+				}
+		Reference(m_grid.data(), m_grid.data(), nodes);
+	}
+
+	Lut3D::Lut3D(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model, int size) :
+		Lut3D(plan, src_model, plan, dst_model, size)
+	{}
+
+	ModelEnum Lut3D::GetSourceModel() const noexcept
+	{
+		return m_srcModel;
+	}
+
+	ModelEnum Lut3D::GetDestinationModel() const noexcept
+	{
+		return m_dstModel;
+	}
+
+	int Lut3D::GetSize() const noexcept
+	{
+		return m_size;
+	}
+
+	float Lut3D::GetDomainMin(int channel) const noexcept
+	{
+		return m_lo[channel];
+	}
+
+	float Lut3D::GetDomainMax(int channel) const noexcept
+	{
+		return m_hi[channel];
+	}
+
+	const float* Lut3D::GetData() const noexcept
+	{
+		return m_grid.data();
+	}
+
+	void Lut3D::Reference(const float* in, float* out, size_t n) const
+	{
+		ConvertBuffer(m_src, m_srcModel, ModelEnum::Xyz, in, out, n);
+		if (m_adapt)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				float* c = out + i * 3;
+				const double x = c[0];
+				const double y = c[1];
+				const double z = c[2];
+				c[0] = static_cast<float>(x * m_pcs.m[0][0] + y * m_pcs.m[1][0] + z * m_pcs.m[2][0]);
+				c[1] = static_cast<float>(x * m_pcs.m[0][1] + y * m_pcs.m[1][1] + z * m_pcs.m[2][1]);
+				c[2] = static_cast<float>(x * m_pcs.m[0][2] + y * m_pcs.m[1][2] + z * m_pcs.m[2][2]);
+			}
+		}
+		ConvertBuffer(m_dst, ModelEnum::Xyz, m_dstModel, out, out, n);
+	}
+
+	// cell index and the fraction inside it, clamped to the domain
+	void Lut3D::Locate(float v, int axis, int& i, float& f) const noexcept
+	{
+		float t = (v - m_lo[axis]) * m_scale[axis];
+		if (!(t > 0.0f))	// NaN too
+			t = 0.0f;
+		if (t >= static_cast<float>(m_size - 1))
+		{
+			i = m_size - 2;
+			f = 1.0f;
+			return;
+		}
+		i = static_cast<int>(t);
+		f = t - static_cast<float>(i);
+	}
+
+	void Lut3D::Lookup(float c1, float c2, float c3, float& o1, float& o2, float& o3,
+		LutInterpEnum interp) const noexcept
+	{
+		int i, j, k;
+		float fx, fy, fz;
+		Locate(c1, 0, i, fx);
+		Locate(c2, 1, j, fy);
+		Locate(c3, 2, k, fz);
+
+		const size_t s3 = 3;
+		const size_t s2 = s3 * m_size;
+		const size_t s1 = s2 * m_size;
+		const float* c000 = m_grid.data() + i * s1 + j * s2 + k * s3;
+		const float* c111 = c000 + s1 + s2 + s3;
+		float o[3];
+
+		if (interp == LutInterpEnum::Trilinear)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const float c00 = c000[c] + fz * (c000[s3 + c] - c000[c]);
+				const float c01 = c000[s2 + c] + fz * (c000[s2 + s3 + c] - c000[s2 + c]);
+				const float c10 = c000[s1 + c] + fz * (c000[s1 + s3 + c] - c000[s1 + c]);
+				const float c11 = c000[s1 + s2 + c] + fz * (c111[c] - c000[s1 + s2 + c]);
+				const float c0 = c00 + fy * (c01 - c00);
+				const float c1 = c10 + fy * (c11 - c10);
+				o[c] = c0 + fx * (c1 - c0);
+			}
+		}
+		else
+		{
+			// the tetrahedron of the cube holding the point, by the order of fx, fy, fz:
+			// c000 -> a -> b -> c111, one axis step at a time
+			const float* a;
+			const float* b;
+			float wa, wb, wc;	// weights of the c000 -> a, a -> b and b -> c111 steps
+			if (fx >= fy)
+			{
+				if (fy >= fz)		// x y z
+				{
+					a = c000 + s1; b = a + s2; wa = fx; wb = fy; wc = fz;
+				}
+				else if (fx >= fz)	// x z y
+				{
+					a = c000 + s1; b = a + s3; wa = fx; wb = fz; wc = fy;
+				}
+				else				// z x y
+				{
+					a = c000 + s3; b = a + s1; wa = fz; wb = fx; wc = fy;
+				}
+			}
+			else
+			{
+				if (fz >= fy)		// z y x
+				{
+					a = c000 + s3; b = a + s2; wa = fz; wb = fy; wc = fx;
+				}
+				else if (fz >= fx)	// y z x
+				{
+					a = c000 + s2; b = a + s3; wa = fy; wb = fz; wc = fx;
+				}
+				else				// y x z
+				{
+					a = c000 + s2; b = a + s1; wa = fy; wb = fx; wc = fz;
+				}
+			}
+			for (int c = 0; c < 3; ++c)
+				o[c] = c000[c] + wa * (a[c] - c000[c]) + wb * (b[c] - a[c]) + wc * (c111[c] - b[c]);
+		}
+		o1 = o[0];
+		o2 = o[1];
+		o3 = o[2];
+	}
+
+	void Lut3D::Apply(const float* in, float* out, size_t n,
+		LutInterpEnum interp, LayoutEnum layout) const
+	{
+		if (layout == LayoutEnum::Interleaved)
+		{
+			for (size_t i = 0; i < n * 3; i += 3)
+				Lookup(in[i], in[i + 1], in[i + 2], out[i], out[i + 1], out[i + 2], interp);
+		}
+		else
+		{
+			for (size_t i = 0; i < n; ++i)
+				Lookup(in[i], in[n + i], in[2 * n + i], out[i], out[n + i], out[2 * n + i], interp);
+		}
+	}
+
+	void Lut3D::Apply(ThreadPool& pool, const float* in, float* out, size_t n,
+		LutInterpEnum interp, LayoutEnum layout, size_t tile) const
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			if (layout == LayoutEnum::Interleaved)
+			{
+				Apply(in + first * 3, out + first * 3, last - first, interp, layout);
+			}
+			else
+			{
+				for (size_t i = first; i < last; ++i)
+					Lookup(in[i], in[n + i], in[2 * n + i], out[i], out[n + i], out[2 * n + i], interp);
+			}
+		});
+	}
+
+	LutReport Lut3D::Measure(LutInterpEnum interp, int steps) const
+	{
+		if (steps < 2)
+			steps = 2;
+		const size_t count = static_cast<size_t>(steps) * steps * steps;
+		std::vector<float> in(count * 3);
+		float* c = in.data();
+		for (int i = 0; i < steps; ++i)
+			for (int j = 0; j < steps; ++j)
+				for (int k = 0; k < steps; ++k)
+				{
+					*c++ = m_lo[0] + (m_hi[0] - m_lo[0]) * i / (steps - 1);
+					*c++ = m_lo[1] + (m_hi[1] - m_lo[1]) * j / (steps - 1);
+					*c++ = m_lo[2] + (m_hi[2] - m_lo[2]) * k / (steps - 1);
+				}
+
+		std::vector<float> expected(count * 3);
+		std::vector<float> actual(count * 3);
+		Reference(in.data(), expected.data(), count);
+		Apply(in.data(), actual.data(), count, interp);
+		if (m_dstModel != ModelEnum::Lab)
+		{
+			ConvertBuffer(m_dst, m_dstModel, ModelEnum::Lab, expected.data(), expected.data(), count);
+			ConvertBuffer(m_dst, m_dstModel, ModelEnum::Lab, actual.data(), actual.data(), count);
+		}
+
+		LutReport report;
+		double sum = 0.0;
+		for (size_t i = 0; i < count * 3; i += 3)
+		{
+			const double dl = static_cast<double>(expected[i]) - actual[i];
+			const double da = static_cast<double>(expected[i + 1]) - actual[i + 1];
+			const double db = static_cast<double>(expected[i + 2]) - actual[i + 2];
+			const double de = std::sqrt(dl * dl + da * da + db * db);
+			sum += de;
+			if (de > report.MaxDeltaE)
+				report.MaxDeltaE = de;
+		}
+		report.Samples = count;
+		report.MeanDeltaE = sum / count;
+		return report;
+	}
+};
@@ -0,0 +1,79 @@
+#ifndef _COLORLUT_H_
+#define _COLORLUT_H_
+
+#include "ColorBuffer.h"
+#include "ColorPlan.h"
+
+#include <vector>
+
+namespace COLORNS
+{
+	enum class LutInterpEnum
+	{
+		Trilinear = 0,		// 8 nodes per color
+		Tetrahedral = 1		// 4 nodes per color, keeps the neutral axis exact
+	};
+
+	// max / mean CIE76 delta E of the LUT against the analytic path
+	typedef struct _LutReport
+	{
+		double MaxDeltaE{ 0.0 };
+		double MeanDeltaE{ 0.0 };
+		size_t Samples{ 0 };
+	} LutReport;
+
+	// A src_model -> dst_model conversion baked into an N x N x N grid (17, 33, 65 ...).
+	// The analytic path is src_plan: src_model -> XYZ, then dst_plan: XYZ -> dst_model,
+	// with the dst_plan adaptation in between when the two whites differ.
+	// The grid spans GetModelRange(src_model), inputs outside it are clamped.
+	class Lut3D
+	{
+		ConversionPlan m_src;
+		ConversionPlan m_dst;
+		ModelEnum m_srcModel;
+		ModelEnum m_dstModel;
+		int m_size;
+		bool m_adapt;
+		Mtx3x3 m_pcs;
+		float m_lo[3];
+		float m_hi[3];
+		float m_scale[3];
+		// c1 varies slowest, 3 floats per node
+		std::vector<float> m_grid;
+
+		void Locate(float v, int axis, int& i, float& f) const noexcept;
+	public:
+		Lut3D(const ConversionPlan& src_plan, ModelEnum src_model,
+			const ConversionPlan& dst_plan, ModelEnum dst_model, int size = 33);
+		// both ends in the same plan, e.g. RGB -> Lab
+		Lut3D(const ConversionPlan& plan, ModelEnum src_model, ModelEnum dst_model, int size = 33);
+
+		ModelEnum GetSourceModel() const noexcept;
+		ModelEnum GetDestinationModel() const noexcept;
+		int GetSize() const noexcept;
+		float GetDomainMin(int channel) const noexcept;
+		float GetDomainMax(int channel) const noexcept;
+		const float* GetData() const noexcept;
+
+		// one color
+		void Lookup(float c1, float c2, float c3, float& o1, float& o2, float& o3,
+			LutInterpEnum interp = LutInterpEnum::Tetrahedral) const noexcept;
+
+		// n colors, in and out may point to the same buffer
+		void Apply(const float* in, float* out, size_t n,
+			LutInterpEnum interp = LutInterpEnum::Tetrahedral,
+			LayoutEnum layout = LayoutEnum::Interleaved) const;
+		void Apply(ThreadPool& pool, const float* in, float* out, size_t n,
+			LutInterpEnum interp = LutInterpEnum::Tetrahedral,
+			LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels) const;
+
+		// the analytic path the grid was baked from
+		void Reference(const float* in, float* out, size_t n) const;
+
+		// steps^3 colors spread over the source domain, off the grid nodes
+		// for the usual sizes; outputs compared in Lab under dst_plan
+		LutReport Measure(LutInterpEnum interp = LutInterpEnum::Tetrahedral, int steps = 50) const;
+	};
+};
+
+#endif
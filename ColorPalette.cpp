@@ -0,0 +1,515 @@
+#include "ColorPalette.h"
+#include "ColorPlan.h"
+#include "ColorPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace COLORNS
+{
+	// queries re-ranked per DeltaEBuffer call
+	constexpr size_t kPaletteChunk = 64;
+	// deeper than any tree of up to 2^32 colors
+	constexpr int kPaletteStack = 64;
+	// chroma weight of CIE94 / CIEDE2000: SC = 1 + 0.045 C
+	constexpr float kPaletteChroma = 0.045f;
+	// pixels per conversion in the ExtractPalette pass, the Lab scratch stays in L1
+	constexpr size_t kExtractChunk = 256;
+
+	namespace
+	{
+		// median split on the widest axis of ids[first, last), the planes in palette order
+		uint32_t BuildPaletteTree(PaletteTree& tree, uint32_t first, uint32_t last)
+		{
+			const uint32_t node = static_cast<uint32_t>(tree.Nodes.size());
+			tree.Nodes.push_back(PaletteNode());
+			if (last - first <= kPaletteLeafSize)
+			{
+				tree.Nodes[node].Next = first;
+				tree.Nodes[node].Count = last - first;
+				return node;
+			}
+
+			const float* planes[3] = { tree.P1.data(), tree.P2.data(), tree.P3.data() };
+			uint32_t axis = 0;
+			float widest = -1.0f;
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				float lo = planes[c][tree.Ids[first]];
+				float hi = lo;
+				for (uint32_t i = first + 1; i < last; ++i)
+				{
+					lo = std::min(lo, planes[c][tree.Ids[i]]);
+					hi = std::max(hi, planes[c][tree.Ids[i]]);
+				}
+				if (hi - lo > widest)
+				{
+					widest = hi - lo;
+					axis = c;
+				}
+			}
+			const float* plane = planes[axis];
+			const uint32_t mid = first + (last - first) / 2;
+			std::nth_element(tree.Ids.begin() + first, tree.Ids.begin() + mid, tree.Ids.begin() + last,
+				[plane](uint32_t x, uint32_t y) { return plane[x] < plane[y]; });
+
+			tree.Nodes[node].Axis = axis;
+			tree.Nodes[node].Split = plane[tree.Ids[mid]];
+			BuildPaletteTree(tree, first, mid);
+			const uint32_t right = BuildPaletteTree(tree, mid, last);
+			tree.Nodes[node].Next = right;
+			return node;
+		}
+
+		// tree over the points already in P1..P3, then the planes in leaf order
+		void BuildPaletteTree(PaletteTree& tree)
+		{
+			const size_t n = tree.P1.size();
+			if (n == 0)
+				return;
+			tree.Ids.resize(n);
+			for (size_t i = 0; i < n; ++i)
+				tree.Ids[i] = static_cast<uint32_t>(i);
+			tree.Nodes.reserve(2 * (n / kPaletteLeafSize + 1));
+			BuildPaletteTree(tree, 0, static_cast<uint32_t>(n));
+
+			std::vector<float> p1(n), p2(n), p3(n);
+			for (size_t i = 0; i < n; ++i)
+			{
+				p1[i] = tree.P1[tree.Ids[i]];
+				p2[i] = tree.P2[tree.Ids[i]];
+				p3[i] = tree.P3[tree.Ids[i]];
+			}
+			tree.P1.swap(p1);
+			tree.P2.swap(p2);
+			tree.P3.swap(p3);
+		}
+
+		// Depth first, the child on the query's side of the split first; the other
+		// child waits on the stack with its distance to the split plane and is
+		// skipped once that is no closer than the k-th best.
+		// d2 gets the squared distances of the found points, closest first.
+		size_t SearchPaletteTree(const PaletteTree& tree, const float q[3], size_t k, uint32_t* index, float* d2)
+		{
+			if (tree.Nodes.empty() || k == 0)
+				return 0;
+			size_t found = 0;
+			float bound = INFINITY;
+
+			uint32_t stack[kPaletteStack];
+			float plane[kPaletteStack];
+			int top = 0;
+			uint32_t node = 0;
+			for (;;)
+			{
+				const PaletteNode& n = tree.Nodes[node];
+				if (n.Count == 0)
+				{
+					const float d = q[n.Axis] - n.Split;
+					stack[top] = (d < 0.0f) ? n.Next : node + 1;
+					plane[top++] = d * d;
+					node = (d < 0.0f) ? node + 1 : n.Next;
+					continue;
+				}
+
+				for (uint32_t i = n.Next; i < n.Next + n.Count; ++i)
+				{
+					const float dx = tree.P1[i] - q[0];
+					const float dy = tree.P2[i] - q[1];
+					const float dz = tree.P3[i] - q[2];
+					const float dist = dx * dx + dy * dy + dz * dz;
+					if (!(dist < bound))
+						continue;
+					// insert into the sorted list, dropping the last one when full
+					size_t j = (found < k) ? found++ : k - 1;
+					for (; j > 0 && d2[j - 1] > dist; --j)
+					{
+						d2[j] = d2[j - 1];
+						index[j] = index[j - 1];
+					}
+					d2[j] = dist;
+					index[j] = tree.Ids[i];
+					if (found == k)
+						bound = d2[k - 1];
+				}
+
+				while (top > 0 && !(plane[top - 1] < bound))
+					--top;
+				if (top == 0)
+					break;
+				node = stack[--top];
+			}
+			return found;
+		}
+
+		// chroma C -> ln(1 + 0.045 C) / 0.045, hue and L kept
+		void CompressPaletteLab(float L, float a, float b, float out[3])
+		{
+			const float c = std::sqrt(a * a + b * b);
+			const float scale = (c > 0.0f) ? std::log1p(kPaletteChroma * c) / (kPaletteChroma * c) : 1.0f;
+			out[0] = L;
+			out[1] = a * scale;
+			out[2] = b * scale;
+		}
+	}
+
+	PaletteIndex::PaletteIndex(const std::vector<LabColor>& palette) :
+		m_palette(palette)
+	{
+		for (const LabColor& c : palette)
+		{
+			const float L = static_cast<float>(c.GetL());
+			const float a = static_cast<float>(c.GetA());
+			const float b = static_cast<float>(c.GetB());
+			float q[3];
+			CompressPaletteLab(L, a, b, q);
+			m_lab.P1.push_back(L);
+			m_lab.P2.push_back(a);
+			m_lab.P3.push_back(b);
+			m_compressed.P1.push_back(q[0]);
+			m_compressed.P2.push_back(q[1]);
+			m_compressed.P3.push_back(q[2]);
+		}
+		BuildPaletteTree(m_lab);
+		BuildPaletteTree(m_compressed);
+	}
+
+	size_t PaletteIndex::GetSize() const noexcept
+	{
+		return m_palette.size();
+	}
+
+	const LabColor& PaletteIndex::GetColor(size_t index) const
+	{
+		return m_palette[index];
+	}
+
+	uint32_t PaletteIndex::Nearest(float L, float a, float b, float* distance) const
+	{
+		const float q[3] = { L, a, b };
+		uint32_t found = kPaletteNone;
+		float d2 = INFINITY;
+		SearchPaletteTree(m_lab, q, 1, &found, &d2);
+		if (distance)
+			*distance = std::sqrt(d2);
+		return found;
+	}
+
+	size_t PaletteIndex::KNearest(float L, float a, float b, size_t k, uint32_t* index, float* distance) const
+	{
+		const float q[3] = { L, a, b };
+		std::vector<float> d2(k);
+		const size_t found = SearchPaletteTree(m_lab, q, k, index, d2.data());
+		if (distance)
+			for (size_t j = 0; j < found; ++j)
+				distance[j] = std::sqrt(d2[j]);
+		return found;
+	}
+
+	void PaletteIndex::Match(const float* lab, uint32_t* index, float* distance, size_t n,
+		DeltaEEnum formula, size_t candidates) const
+	{
+		if (formula == DeltaEEnum::CIE76 || m_palette.empty())
+		{
+			for (size_t i = 0; i < n; ++i)
+				index[i] = Nearest(lab[i * 3], lab[i * 3 + 1], lab[i * 3 + 2], distance ? distance + i : nullptr);
+			return;
+		}
+
+		// the candidates of a chunk of colors, then one DeltaEBuffer call over all
+		// pairs; the palette color is the reference (first) color of each pair
+		const size_t k = std::min(std::max<size_t>(candidates, 1), m_palette.size());
+		std::vector<uint32_t> ids(kPaletteChunk * k);
+		std::vector<float> d2(k);
+		std::vector<float> refs(kPaletteChunk * k * 3);
+		std::vector<float> samples(kPaletteChunk * k * 3);
+		std::vector<float> de(kPaletteChunk * k);
+		for (size_t start = 0; start < n; start += kPaletteChunk)
+		{
+			const size_t count = std::min(kPaletteChunk, n - start);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float* q = lab + (start + i) * 3;
+				float c[3];
+				CompressPaletteLab(q[0], q[1], q[2], c);
+				SearchPaletteTree(m_compressed, c, k, ids.data() + i * k, d2.data());
+				for (size_t j = 0; j < k; ++j)
+				{
+					const size_t at = (i * k + j) * 3;
+					const uint32_t id = ids[i * k + j];
+					refs[at] = static_cast<float>(m_palette[id].GetL());
+					refs[at + 1] = static_cast<float>(m_palette[id].GetA());
+					refs[at + 2] = static_cast<float>(m_palette[id].GetB());
+					samples[at] = q[0];
+					samples[at + 1] = q[1];
+					samples[at + 2] = q[2];
+				}
+			}
+			DeltaEBuffer(formula, refs.data(), samples.data(), de.data(), count * k);
+			for (size_t i = 0; i < count; ++i)
+			{
+				// the first of equal differences: the nearer candidate
+				size_t pick = i * k;
+				for (size_t j = i * k + 1; j < (i + 1) * k; ++j)
+					if (de[j] < de[pick])
+						pick = j;
+				index[start + i] = ids[pick];
+				if (distance)
+					distance[start + i] = de[pick];
+			}
+		}
+	}
+
+	void PaletteIndex::Match(ThreadPool& pool, const float* lab, uint32_t* index, float* distance, size_t n,
+		DeltaEEnum formula, size_t candidates, size_t tile) const
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			Match(lab + first * 3, index + first, distance ? distance + first : nullptr, last - first,
+				formula, candidates);
+		});
+	}
+
+	namespace
+	{
+		void PaletteToLab(const ConversionPlan& plan, const float* rgb, float* lab, size_t n)
+		{
+			ConvertBuffer(plan, ModelEnum::Rgb, ModelEnum::Lab, rgb, lab, n);
+		}
+
+		void PaletteToLab(const ConversionPlan& plan, const uint8_t* rgb, float* lab, size_t n)
+		{
+			ConvertBuffer(plan, ModelEnum::Lab, rgb, lab, n);
+		}
+
+		// the nearest of k interleaved Lab centers, dE76
+		size_t NearestCenter(const float* centers, size_t k, const float* q)
+		{
+			size_t best = 0;
+			float bestD2 = INFINITY;
+			for (size_t c = 0; c < k; ++c)
+			{
+				const float dl = centers[c * 3] - q[0];
+				const float da = centers[c * 3 + 1] - q[1];
+				const float db = centers[c * 3 + 2] - q[2];
+				const float d2 = dl * dl + da * da + db * db;
+				if (d2 < bestD2)
+				{
+					bestD2 = d2;
+					best = c;
+				}
+			}
+			return best;
+		}
+
+		// [0, 1) from the generator, the same on every standard library
+		double PaletteRandom(std::mt19937& rng)
+		{
+			return rng() * (1.0 / 4294967296.0);
+		}
+
+		// k-means++: the first center at random, every next one drawn with a probability
+		// proportional to the squared distance to the nearest center so far
+		void SeedCenters(const std::vector<float>& samples, size_t k, std::mt19937& rng, float* centers)
+		{
+			const size_t m = samples.size() / 3;
+			std::vector<float> d2(m, INFINITY);
+			size_t pick = rng() % m;
+			for (size_t c = 0; c < k; ++c)
+			{
+				std::copy(&samples[pick * 3], &samples[pick * 3] + 3, centers + c * 3);
+				double total = 0.0;
+				for (size_t i = 0; i < m; ++i)
+				{
+					const float dl = samples[i * 3] - centers[c * 3];
+					const float da = samples[i * 3 + 1] - centers[c * 3 + 1];
+					const float db = samples[i * 3 + 2] - centers[c * 3 + 2];
+					d2[i] = std::min(d2[i], dl * dl + da * da + db * db);
+					total += d2[i];
+				}
+				if (!(total > 0.0))
+				{
+					pick = rng() % m;
+					continue;
+				}
+				double r = PaletteRandom(rng) * total;
+				for (pick = 0; pick + 1 < m; ++pick)
+				{
+					r -= d2[pick];
+					if (r < 0.0)
+						break;
+				}
+			}
+		}
+
+		template <typename C>
+		std::vector<PaletteEntry> ExtractColors(ThreadPool* pool, const ConversionPlan& plan, const C* rgb,
+			size_t n, const PaletteOptions& options)
+		{
+			std::vector<PaletteEntry> palette;
+			if (n == 0 || options.Colors == 0)
+				return palette;
+			std::mt19937 rng(options.Seed);
+
+			// one sample from each of m equal stretches of the image
+			const size_t m = std::min(std::max<size_t>(options.Samples, 1), n);
+			std::vector<C> picked(m * 3);
+			for (size_t i = 0; i < m; ++i)
+			{
+				const size_t lo = i * n / m;
+				const size_t hi = (i + 1) * n / m;
+				const size_t at = lo + rng() % (hi - lo);
+				std::copy(rgb + at * 3, rgb + at * 3 + 3, &picked[i * 3]);
+			}
+			std::vector<float> samples(m * 3);
+			PaletteToLab(plan, picked.data(), samples.data(), m);
+
+			const size_t k = std::min(options.Colors, m);
+			std::vector<float> centers(k * 3);
+			SeedCenters(samples, k, rng, centers.data());
+
+			// mini-batches: assign the batch, then move each center towards its samples
+			// with the step 1 / (samples it has seen)
+			const size_t batch = std::max<size_t>(options.BatchSize, 1);
+			std::vector<size_t> seen(k, 0);
+			std::vector<size_t> drawn(batch);
+			std::vector<size_t> nearest(batch);
+			for (int it = 0; it < options.Iterations; ++it)
+			{
+				for (size_t b = 0; b < batch; ++b)
+				{
+					drawn[b] = rng() % m;
+					nearest[b] = NearestCenter(centers.data(), k, &samples[drawn[b] * 3]);
+				}
+				for (size_t b = 0; b < batch; ++b)
+				{
+					const size_t c = nearest[b];
+					const float eta = 1.0f / static_cast<float>(++seen[c]);
+					for (int j = 0; j < 3; ++j)
+						centers[c * 3 + j] += eta * (samples[drawn[b] * 3 + j] - centers[c * 3 + j]);
+				}
+			}
+
+			// every pixel to its nearest center, sums per tile
+			const size_t tiles = (n + kTilePixels - 1) / kTilePixels;
+			std::vector<double> sums(tiles * k * 3, 0.0);
+			std::vector<size_t> counts(tiles * k, 0);
+			auto body = [&](size_t first, size_t last)
+			{
+				float lab[kExtractChunk * 3];
+				float l[kExtractChunk], a[kExtractChunk], b[kExtractChunk];
+				float best[kExtractChunk];
+				uint32_t label[kExtractChunk];
+				for (size_t t = first / kTilePixels; t * kTilePixels < last; ++t)
+				{
+					const size_t end = std::min((t + 1) * kTilePixels, last);
+					double* sum = &sums[t * k * 3];
+					size_t* count = &counts[t * k];
+					for (size_t start = t * kTilePixels; start < end; start += kExtractChunk)
+					{
+						const size_t chunk = std::min(kExtractChunk, end - start);
+						PaletteToLab(plan, rgb + start * 3, lab, chunk);
+						for (size_t i = 0; i < chunk; ++i)
+						{
+							l[i] = lab[i * 3];
+							a[i] = lab[i * 3 + 1];
+							b[i] = lab[i * 3 + 2];
+							best[i] = INFINITY;
+							label[i] = 0;
+						}
+						// center by center over the chunk, the select as a mask so it vectorizes
+						for (size_t c = 0; c < k; ++c)
+						{
+							const float cl = centers[c * 3], ca = centers[c * 3 + 1], cb = centers[c * 3 + 2];
+							const uint32_t id = static_cast<uint32_t>(c);
+							for (size_t i = 0; i < chunk; ++i)
+							{
+								const float dl = l[i] - cl, da = a[i] - ca, db = b[i] - cb;
+								const float d2 = dl * dl + da * da + db * db;
+								const float was = best[i];
+								const uint32_t closer = d2 < was ? UINT32_MAX : 0u;
+								best[i] = d2 < was ? d2 : was;
+								label[i] = (id & closer) | (label[i] & ~closer);
+							}
+						}
+						for (size_t i = 0; i < chunk; ++i)
+						{
+							sum[label[i] * 3] += l[i];
+							sum[label[i] * 3 + 1] += a[i];
+							sum[label[i] * 3 + 2] += b[i];
+							++count[label[i]];
+						}
+					}
+				}
+			};
+			if (pool)
+				pool->ParallelFor(n, kTilePixels, body);
+			else
+				body(0, n);
+
+			std::vector<double> total(k * 3, 0.0);
+			std::vector<size_t> pixels(k, 0);
+			for (size_t t = 0; t < tiles; ++t)
+			{
+				for (size_t c = 0; c < k; ++c)
+				{
+					for (int j = 0; j < 3; ++j)
+						total[c * 3 + j] += sums[(t * k + c) * 3 + j];
+					pixels[c] += counts[t * k + c];
+				}
+			}
+
+			std::vector<float> lab, out;
+			for (size_t c = 0; c < k; ++c)
+			{
+				if (!pixels[c])
+					continue;
+				const double count = static_cast<double>(pixels[c]);
+				PaletteEntry entry;
+				entry.Lab = LabColor(total[c * 3] / count, total[c * 3 + 1] / count, total[c * 3 + 2] / count);
+				entry.Pixels = pixels[c];
+				entry.Weight = count / static_cast<double>(n);
+				palette.push_back(entry);
+				lab.push_back(static_cast<float>(entry.Lab.GetL()));
+				lab.push_back(static_cast<float>(entry.Lab.GetA()));
+				lab.push_back(static_cast<float>(entry.Lab.GetB()));
+			}
+			out.resize(lab.size());
+			ConvertBuffer(plan, ModelEnum::Lab, ModelEnum::Rgb, lab.data(), out.data(), palette.size());
+			for (size_t i = 0; i < palette.size(); ++i)
+			{
+				for (int j = 0; j < 3; ++j)
+					out[i * 3 + j] = std::min(std::max(out[i * 3 + j], 0.0f), 1.0f);
+				palette[i].Rgb = RgbColor(out[i * 3], out[i * 3 + 1], out[i * 3 + 2]);
+			}
+			std::stable_sort(palette.begin(), palette.end(),
+				[](const PaletteEntry& x, const PaletteEntry& y) { return x.Pixels > y.Pixels; });
+			return palette;
+		}
+	}
+
+	std::vector<PaletteEntry> ExtractPalette(const ConversionPlan& plan, const float* rgb, size_t n,
+		const PaletteOptions& options)
+	{
+		return ExtractColors(nullptr, plan, rgb, n, options);
+	}
+
+	std::vector<PaletteEntry> ExtractPalette(const ConversionPlan& plan, const uint8_t* rgb, size_t n,
+		const PaletteOptions& options)
+	{
+		return ExtractColors(nullptr, plan, rgb, n, options);
+	}
+
+	std::vector<PaletteEntry> ExtractPalette(ThreadPool& pool, const ConversionPlan& plan, const float* rgb,
+		size_t n, const PaletteOptions& options)
+	{
+		return ExtractColors(&pool, plan, rgb, n, options);
+	}
+
+	std::vector<PaletteEntry> ExtractPalette(ThreadPool& pool, const ConversionPlan& plan, const uint8_t* rgb,
+		size_t n, const PaletteOptions& options)
+	{
+		return ExtractColors(&pool, plan, rgb, n, options);
+	}
+};
@@ -0,0 +1,112 @@
+#ifndef _COLORPALETTE_H_
+#define _COLORPALETTE_H_
+
+#include "Color.h"
+#include "ColorDelta.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace COLORNS
+{
+	// palette colors per k-d tree leaf
+	constexpr size_t kPaletteLeafSize = 8;
+	// candidates re-ranked by CIE94 / CIEDE2000, see PaletteIndex::Match
+	constexpr size_t kPaletteCandidates = 16;
+	// no palette color: the palette is empty
+	constexpr uint32_t kPaletteNone = UINT32_MAX;
+
+	// node of a flat k-d tree, the left child of an inner node follows it
+	typedef struct _PaletteNode
+	{
+		float Split{ 0.0f };	// inner: the axis value that separates the children
+		uint32_t Axis{ 0 };		// inner: 0 L, 1 a, 2 b
+		uint32_t Next{ 0 };		// inner: the right child; leaf: its first point
+		uint32_t Count{ 0 };	// leaf: points, 0 for inner nodes
+	} PaletteNode;
+
+	// k-d tree over points in three float planes, reordered leaf by leaf
+	typedef struct _PaletteTree
+	{
+		std::vector<PaletteNode> Nodes;
+		std::vector<float> P1;
+		std::vector<float> P2;
+		std::vector<float> P3;
+		std::vector<uint32_t> Ids;		// palette index of each point
+	} PaletteTree;
+
+	class ThreadPool;
+
+	// Nearest palette colors in Lab. The palette goes into a k-d tree in one flat
+	// node array, its colors reordered leaf by leaf into float planes, so a query
+	// touches a few contiguous leaves instead of the whole palette.
+	// The searches are exact under dE76; ties go to either color.
+	class PaletteIndex
+	{
+		std::vector<LabColor> m_palette;
+		PaletteTree m_lab;
+		// the same colors with compressed chroma, candidates for CIE94 / CIEDE2000
+		PaletteTree m_compressed;
+	public:
+		explicit PaletteIndex(const std::vector<LabColor>& palette);
+
+		size_t GetSize() const noexcept;
+		const LabColor& GetColor(size_t index) const;
+
+		// the palette index of the nearest color (kPaletteNone for an empty palette),
+		// its dE76 in distance if not nullptr
+		uint32_t Nearest(float L, float a, float b, float* distance = nullptr) const;
+
+		// up to k nearest colors, closest first: their palette indexes and dE76 (distance
+		// may be nullptr); returns how many were found, min(k, GetSize())
+		size_t KNearest(float L, float a, float b, size_t k, uint32_t* index, float* distance) const;
+
+		// n interleaved Lab colors: the nearest palette index of each, distance (may be nullptr)
+		// gets the difference. CIE76 is exact. CIE94 and CIEDE2000 re-rank the candidates
+		// nearest in Lab with the chroma compressed like their SC weight,
+		// C -> ln(1 + 0.045 C) / 0.045, so a color outside them is not considered.
+		void Match(const float* lab, uint32_t* index, float* distance, size_t n,
+			DeltaEEnum formula = DeltaEEnum::CIE76, size_t candidates = kPaletteCandidates) const;
+		void Match(ThreadPool& pool, const float* lab, uint32_t* index, float* distance, size_t n,
+			DeltaEEnum formula = DeltaEEnum::CIE76, size_t candidates = kPaletteCandidates,
+			size_t tile = kTilePixels) const;
+	};
+
+	typedef struct _PaletteOptions
+	{
+		size_t Colors{ 8 };				// clusters (k)
+		size_t Samples{ 1 << 16 };		// pixels drawn for the seeding and the mini-batches
+		size_t BatchSize{ 1024 };		// samples per mini-batch
+		int Iterations{ 100 };			// mini-batches
+		uint32_t Seed{ 1 };
+	} PaletteOptions;
+
+	// a dominant color
+	typedef struct _PaletteEntry
+	{
+		LabColor Lab;
+		RgbColor Rgb;			// in the plan's working space, clamped to [0, 1]
+		double Weight{ 0.0 };	// share of the pixels
+		size_t Pixels{ 0 };
+	} PaletteEntry;
+
+	class ConversionPlan;
+
+	// Dominant colors of n interleaved RGB pixels, clustered in Lab: k-means++ seeds
+	// and mini-batch k-means (Sculley) on options.Samples pixels spread over the image,
+	// then one pass over every pixel (converted through plan chunk by chunk) assigns
+	// it to the nearest center; the centers become the means of their pixels.
+	// With a pool each tile of that pass keeps its own partial sums, added up in tile
+	// order afterwards, so the result doesn't depend on the thread count.
+	// Sorted by weight, clusters that got no pixel are left out.
+	std::vector<PaletteEntry> ExtractPalette(const ConversionPlan& plan, const float* rgb, size_t n,
+		const PaletteOptions& options = PaletteOptions());
+	std::vector<PaletteEntry> ExtractPalette(const ConversionPlan& plan, const uint8_t* rgb, size_t n,
+		const PaletteOptions& options = PaletteOptions());
+	std::vector<PaletteEntry> ExtractPalette(ThreadPool& pool, const ConversionPlan& plan, const float* rgb,
+		size_t n, const PaletteOptions& options = PaletteOptions());
+	std::vector<PaletteEntry> ExtractPalette(ThreadPool& pool, const ConversionPlan& plan, const uint8_t* rgb,
+		size_t n, const PaletteOptions& options = PaletteOptions());
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "ColorPlan.h"
+
+namespace COLORNS
+{
+	// Ma * diag(dst / src cone response) * MaI, row-vector convention
+	void GetAdaptationMatrix(const XYZ& src, const XYZ& dst, AdaptationEnum Method, Mtx3x3& result)
+	{
+		const Mtx3x3& Ma = Adaptations[static_cast<size_t>(Method)][0];
+		const Mtx3x3& MaI = Adaptations[static_cast<size_t>(Method)][1];
+
+		double s[3];
+		double d[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			s[i] = src.X * Ma.m[0][i] + src.Y * Ma.m[1][i] + src.Z * Ma.m[2][i];
+			d[i] = dst.X * Ma.m[0][i] + dst.Y * Ma.m[1][i] + dst.Z * Ma.m[2][i];
+		}
+
+		Mtx3x3 scaled = Ma;
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				scaled.m[i][j] *= d[j] / s[j];
+
+		MtxMultiply3x3(scaled, MaI, result);
+	}
+
+	ConversionPlan::ConversionPlan(RgbEnum Model, IlluminantEnum Illuminant, AdaptationEnum Method,
+		AccuracyEnum Accuracy) :
+		ConversionPlan(static_cast<ColorSpaceHandle>(Model), GetRGBModel(Model), Illuminant, Method, Accuracy)
+	{
+	}
+
+	ConversionPlan::ConversionPlan(ColorSpaceHandle Space, const RgbModel& model, IlluminantEnum Illuminant,
+		AdaptationEnum Method, AccuracyEnum Accuracy) :
+		m_space(Space), m_illuminant(Illuminant), m_method(Method), m_accuracy(Accuracy),
+		m_white(COLORNS::GetRefWhite(Illuminant))
+	{
+		m_gamma = model.GammaRGB;
+		m_compand = &GetCompandApprox(m_gamma, Accuracy);
+		if (Method == AdaptationEnum::amNone)
+		{
+			m_rgb2xyz = model.MtxRGB2XYZ;
+			m_xyz2rgb = model.MtxXYZ2RGB;
+		}
+		else
+		{
+			Mtx3x3 toWhite;
+			Mtx3x3 fromWhite;
+			GetAdaptationMatrix(model.RefWhiteRGB, m_white, Method, toWhite);
+			GetAdaptationMatrix(m_white, model.RefWhiteRGB, Method, fromWhite);
+			MtxMultiply3x3(model.MtxRGB2XYZ, toWhite, m_rgb2xyz);
+			MtxMultiply3x3(fromWhite, model.MtxXYZ2RGB, m_xyz2rgb);
+		}
+	}
+
+	ColorSpaceHandle ConversionPlan::GetSpace() const noexcept
+	{
+		return m_space;
+	}
+
+	RgbEnum ConversionPlan::GetModel() const noexcept
+	{
+		return static_cast<RgbEnum>(m_space);
+	}
+
+	IlluminantEnum ConversionPlan::GetIlluminant() const noexcept
+	{
+		return m_illuminant;
+	}
+
+	AdaptationEnum ConversionPlan::GetAdaptation() const noexcept
+	{
+		return m_method;
+	}
+
+	AccuracyEnum ConversionPlan::GetAccuracy() const noexcept
+	{
+		return m_accuracy;
+	}
+
+	const XYZ& ConversionPlan::GetRefWhite() const noexcept
+	{
+		return m_white;
+	}
+
+	double ConversionPlan::GetGamma() const noexcept
+	{
+		return m_gamma;
+	}
+
+	const CompandApprox& ConversionPlan::GetCompand() const noexcept
+	{
+		return *m_compand;
+	}
+
+	const Mtx3x3& ConversionPlan::GetRGB2XYZ() const noexcept
+	{
+		return m_rgb2xyz;
+	}
+
+	const Mtx3x3& ConversionPlan::GetXYZ2RGB() const noexcept
+	{
+		return m_xyz2rgb;
+	}
+
+	void ConversionPlan::LinearRGB2XYZ(const double r, const double g, const double b,
+		double& x, double& y, double& z) const noexcept
+	{
+		x = r * m_rgb2xyz.m[0][0] + g * m_rgb2xyz.m[1][0] + b * m_rgb2xyz.m[2][0];
+		y = r * m_rgb2xyz.m[0][1] + g * m_rgb2xyz.m[1][1] + b * m_rgb2xyz.m[2][1];
+		z = r * m_rgb2xyz.m[0][2] + g * m_rgb2xyz.m[1][2] + b * m_rgb2xyz.m[2][2];
+	}
+
+	void ConversionPlan::XYZ2LinearRGB(const double x, const double y, const double z,
+		double& r, double& g, double& b) const noexcept
+	{
+		r = x * m_xyz2rgb.m[0][0] + y * m_xyz2rgb.m[1][0] + z * m_xyz2rgb.m[2][0];
+		g = x * m_xyz2rgb.m[0][1] + y * m_xyz2rgb.m[1][1] + z * m_xyz2rgb.m[2][1];
+		b = x * m_xyz2rgb.m[0][2] + y * m_xyz2rgb.m[1][2] + z * m_xyz2rgb.m[2][2];
+	}
+
+	void ConversionPlan::RGB2XYZ(const double r, const double g, const double b,
+		double& x, double& y, double& z) const
+	{
+		LinearRGB2XYZ(m_compand->InvCompand(r), m_compand->InvCompand(g), m_compand->InvCompand(b), x, y, z);
+	}
+
+	void ConversionPlan::XYZ2RGB(const double x, const double y, const double z,
+		double& r, double& g, double& b) const
+	{
+		XYZ2LinearRGB(x, y, z, r, g, b);
+		r = m_compand->Compand(r);
+		g = m_compand->Compand(g);
+		b = m_compand->Compand(b);
+	}
+
+	const ConversionPlan& GetDefaultPlan()
+	{
+		static const ConversionPlan plan;
+		return plan;
+	}
+};
@@ -0,0 +1,72 @@
+#ifndef _COLORPLAN_H_
+#define _COLORPLAN_H_
+
+#include "ColorSpace.h"
+#include "ColorCompand.h"
+
+#include <cstdint>
+
+namespace COLORNS
+{
+	// a working space: the RgbEnum value of a built-in one, or what RegisterColorSpace returned
+	typedef uint32_t ColorSpaceHandle;
+
+	// RGB <-> XYZ settings resolved once: the working space matrix and the
+	// chromatic adaptation into RefWhite are folded into one 3x3 per direction,
+	// so a conversion costs one matrix-vector product plus companding.
+	// Matrices use the same row-vector convention as RgbModel: xyz = rgb * M
+	// Accuracy other than Exact swaps pow() companding for GetCompandApprox.
+	class ConversionPlan
+	{
+		ColorSpaceHandle m_space;
+		IlluminantEnum m_illuminant;
+		AdaptationEnum m_method;
+		AccuracyEnum m_accuracy;
+		XYZ m_white;
+		double m_gamma;
+		const CompandApprox* m_compand;
+		Mtx3x3 m_rgb2xyz;
+		Mtx3x3 m_xyz2rgb;
+	public:
+		ConversionPlan(RgbEnum Model = RgbEnum::sRGB,
+			IlluminantEnum Illuminant = IlluminantEnum::D50,
+			AdaptationEnum Method = AdaptationEnum::amBradford,
+			AccuracyEnum Accuracy = AccuracyEnum::Exact);
+		// any working space; space identifies it to GetSpace() and ConversionCache
+		ConversionPlan(ColorSpaceHandle Space, const RgbModel& Model, IlluminantEnum Illuminant,
+			AdaptationEnum Method, AccuracyEnum Accuracy);
+
+		ColorSpaceHandle GetSpace() const noexcept;
+		// the built-in space, meaningful while GetSpace() < kRgbModelCount
+		RgbEnum GetModel() const noexcept;
+		IlluminantEnum GetIlluminant() const noexcept;
+		AdaptationEnum GetAdaptation() const noexcept;
+		AccuracyEnum GetAccuracy() const noexcept;
+		const XYZ& GetRefWhite() const noexcept;
+		double GetGamma() const noexcept;
+		const CompandApprox& GetCompand() const noexcept;
+		const Mtx3x3& GetRGB2XYZ() const noexcept;
+		const Mtx3x3& GetXYZ2RGB() const noexcept;
+
+		// companded RGB -> adapted XYZ
+		void RGB2XYZ(const double r, const double g, const double b,
+			double& x, double& y, double& z) const;
+		// adapted XYZ -> companded RGB
+		void XYZ2RGB(const double x, const double y, const double z,
+			double& r, double& g, double& b) const;
+
+		// linear light only, no companding
+		void LinearRGB2XYZ(const double r, const double g, const double b,
+			double& x, double& y, double& z) const noexcept;
+		void XYZ2LinearRGB(const double x, const double y, const double z,
+			double& r, double& g, double& b) const noexcept;
+	};
+
+	// the plan Color and the default ConvertBuffer use: sRGB, D50, Bradford
+	const ConversionPlan& GetDefaultPlan();
+
+	// XYZ under src white -> XYZ under dst white: Ma * diag(dst / src cone response) * MaI
+	void GetAdaptationMatrix(const XYZ& src, const XYZ& dst, AdaptationEnum Method, Mtx3x3& result);
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include "ColorPool.h"
+
+#include <exception>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace COLORNS
+{
+	namespace
+	{
+		void PinThread(std::thread& thread, unsigned cpu)
+		{
+#if defined(_WIN32)
+			SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << (cpu % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu % CPU_SETSIZE, &set);
+			pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+			(void)thread;
+			(void)cpu;
+#endif
+		}
+	}
+
+	ThreadPool::ThreadPool(unsigned threads, AffinityEnum affinity) :
+		m_threads(threads), m_affinity(affinity)
+	{
+		const unsigned cpus = std::thread::hardware_concurrency();
+		if (m_threads == 0)
+			m_threads = (cpus == 0) ? 1 : cpus;
+
+		for (unsigned i = 0; i < m_threads; ++i)
+			m_queues.emplace_back(new Queue);
+		for (unsigned i = 1; i < m_threads; ++i)
+		{
+			m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+			if (affinity == AffinityEnum::Pinned)
+				PinThread(m_workers.back(), (cpus == 0) ? i : i % cpus);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+
+	unsigned ThreadPool::GetThreadCount() const noexcept
+	{
+		return m_threads;
+	}
+
+	AffinityEnum ThreadPool::GetAffinity() const noexcept
+	{
+		return m_affinity;
+	}
+
+	void ThreadPool::Push(size_t queue, Task task)
+	{
+		Queue& q = *m_queues[queue];
+		std::lock_guard<std::mutex> guard(q.lock);
+		q.tasks.push_back(std::move(task));
+	}
+
+	// own queue from the back (the most recent, still in cache), the others from the front
+	bool ThreadPool::Pop(size_t self, Task& task)
+	{
+		const size_t count = m_queues.size();
+		for (size_t k = 0; k < count; ++k)
+		{
+			Queue& q = *m_queues[(self + k) % count];
+			std::lock_guard<std::mutex> guard(q.lock);
+			if (q.tasks.empty())
+				continue;
+			if (k == 0)
+			{
+				task = std::move(q.tasks.back());
+				q.tasks.pop_back();
+			}
+			else
+			{
+				task = std::move(q.tasks.front());
+				q.tasks.pop_front();
+			}
+			--m_queued;
+			return true;
+		}
+		return false;
+	}
+
+	void ThreadPool::WorkerLoop(size_t self)
+	{
+		Task task;
+		for (;;)
+		{
+			if (Pop(self, task))
+			{
+				task();
+				task = nullptr;
+				continue;
+			}
+			std::unique_lock<std::mutex> guard(m_lock);
+			m_wake.wait(guard, [this] { return m_stop || m_queued > 0; });
+			if (m_stop && m_queued == 0)
+				return;
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)>& body)
+	{
+		if (n == 0)
+			return;
+		if (grain == 0)
+			grain = 1;
+		const size_t pieces = (n + grain - 1) / grain;
+		if (m_threads == 1 || pieces == 1)
+		{
+			body(0, n);
+			return;
+		}
+
+		typedef struct _Job
+		{
+			std::atomic<size_t> remaining;
+			std::mutex lock;
+			std::condition_variable done;
+			std::exception_ptr error;
+		} Job;
+		// the last task still signals after ParallelFor may have returned
+		std::shared_ptr<Job> job = std::make_shared<Job>();
+		job->remaining = pieces;
+
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_queued += pieces;
+		}
+		for (size_t i = 0; i < pieces; ++i)
+		{
+			const size_t first = i * grain;
+			const size_t last = (n - first < grain) ? n : first + grain;
+			Push(i % m_queues.size(), [job, first, last, &body]
+			{
+				try
+				{
+					body(first, last);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> guard(job->lock);
+					if (!job->error)
+						job->error = std::current_exception();
+				}
+				if (--job->remaining == 0)
+				{
+					std::lock_guard<std::mutex> guard(job->lock);
+					job->done.notify_all();
+				}
+			});
+		}
+		m_wake.notify_all();
+
+		// help until the queues are empty, then wait for the tasks still running
+		Task task;
+		while (job->remaining > 0 && Pop(0, task))
+		{
+			task();
+			task = nullptr;
+		}
+		std::unique_lock<std::mutex> guard(job->lock);
+		job->done.wait(guard, [&job] { return job->remaining == 0; });
+		if (job->error)
+			std::rethrow_exception(job->error);
+	}
+
+	ThreadPool& GetDefaultPool()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+};
@@ -0,0 +1,68 @@
+#ifndef _COLORPOOL_H_
+#define _COLORPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace COLORNS
+{
+	enum class AffinityEnum
+	{
+		None = 0,		// the OS schedules the workers
+		Pinned = 1		// worker i stays on logical CPU i (Linux and Windows)
+	};
+
+	// Work-stealing pool: every worker owns a deque, takes its own tasks from
+	// the back and steals from the front of the others when it runs dry.
+	// The thread calling ParallelFor works on the tasks too, so a pool of
+	// n threads starts n - 1 workers and a pool of 1 runs everything inline.
+	class ThreadPool
+	{
+		typedef std::function<void()> Task;
+
+		typedef struct _Queue
+		{
+			std::mutex lock;
+			std::deque<Task> tasks;
+		} Queue;
+
+		unsigned m_threads;
+		AffinityEnum m_affinity;
+		// m_queues[0] is shared by the callers, m_queues[i] belongs to worker i
+		std::vector<std::unique_ptr<Queue>> m_queues;
+		std::vector<std::thread> m_workers;
+		std::mutex m_lock;
+		std::condition_variable m_wake;
+		std::atomic<size_t> m_queued{ 0 };
+		bool m_stop{ false };
+
+		void Push(size_t queue, Task task);
+		bool Pop(size_t self, Task& task);
+		void WorkerLoop(size_t self);
+	public:
+		// threads 0 means std::thread::hardware_concurrency()
+		explicit ThreadPool(unsigned threads = 0, AffinityEnum affinity = AffinityEnum::None);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator= (const ThreadPool&) = delete;
+
+		unsigned GetThreadCount() const noexcept;
+		AffinityEnum GetAffinity() const noexcept;
+
+		// body(first, last) over [0, n) in pieces of grain items, returns once all
+		// of them ran; the first exception thrown by body is rethrown here
+		void ParallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)>& body);
+	};
+
+	// pool with one thread per logical CPU, started on first use
+	ThreadPool& GetDefaultPool();
+};
+
+#endif
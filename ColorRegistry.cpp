@@ -0,0 +1,221 @@
+#include "ColorRegistry.h"
+#include "ColorConstexpr.h"
+#include "ColorPool.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace COLORNS
+{
+	namespace
+	{
+		constexpr size_t kRegistryIlluminants = static_cast<size_t>(IlluminantEnum::F11) + 1;
+		constexpr size_t kRegistryAdaptations = static_cast<size_t>(AdaptationEnum::amNone) + 1;
+		constexpr size_t kRegistryAccuracies = static_cast<size_t>(AccuracyEnum::Display8) + 1;
+		// descriptions this close are one space; the built-in ones are read back from
+		// their matrices, a few ulps off the published figures
+		constexpr double kRegistryTolerance = 1e-9;
+		// primaries closer to a line than this span no space
+		constexpr double kRegistryMinArea = 1e-9;
+
+		typedef struct _RegistrySpace
+		{
+			ColorSpaceHandle Handle;
+			ColorSpaceDesc Desc;
+			RgbModel Model;
+			// built on first request, never replaced
+			std::atomic<const ConversionPlan*> Plans[kRegistryIlluminants][kRegistryAdaptations][kRegistryAccuracies];
+
+			_RegistrySpace(ColorSpaceHandle handle, const ColorSpaceDesc& desc, const RgbModel& model) :
+				Handle(handle), Desc(desc), Model(model)
+			{
+				for (auto& byMethod : Plans)
+					for (auto& byAccuracy : byMethod)
+						for (auto& plan : byAccuracy)
+							plan.store(nullptr, std::memory_order_relaxed);
+			}
+		} RegistrySpace;
+	}
+
+	XYZ GetWhiteFromXY(double x, double y)
+	{
+		XYZ white;
+		white.X = x / y;
+		white.Y = 1.0;
+		white.Z = (1.0 - x - y) / y;
+		return white;
+	}
+
+	namespace
+	{
+		// a built-in space described from its model: row i of MtxRGB2XYZ is the XYZ of primary i
+		ColorSpaceDesc RegistryDescribe(const RgbModel& model)
+		{
+			double xy[3][2];
+			for (int i = 0; i < 3; ++i)
+			{
+				const double sum = model.MtxRGB2XYZ.m[i][0] + model.MtxRGB2XYZ.m[i][1] + model.MtxRGB2XYZ.m[i][2];
+				xy[i][0] = model.MtxRGB2XYZ.m[i][0] / sum;
+				xy[i][1] = model.MtxRGB2XYZ.m[i][1] / sum;
+			}
+			ColorSpaceDesc desc;
+			desc.xr = xy[0][0];
+			desc.yr = xy[0][1];
+			desc.xg = xy[1][0];
+			desc.yg = xy[1][1];
+			desc.xb = xy[2][0];
+			desc.yb = xy[2][1];
+			desc.White = model.RefWhiteRGB;
+			desc.Gamma = model.GammaRGB;
+			return desc;
+		}
+
+		bool RegistryMatch(const ColorSpaceDesc& a, const ColorSpaceDesc& b)
+		{
+			const double da[] = { a.xr, a.yr, a.xg, a.yg, a.xb, a.yb, a.White.X, a.White.Y, a.White.Z };
+			const double db[] = { b.xr, b.yr, b.xg, b.yg, b.xb, b.yb, b.White.X, b.White.Y, b.White.Z };
+			for (size_t i = 0; i < sizeof(da) / sizeof(da[0]); ++i)
+				if (!(std::fabs(da[i] - db[i]) <= kRegistryTolerance))
+					return false;
+			return a.Gamma == b.Gamma;
+		}
+
+		// Spaces are published in handle order and never removed, so a lookup reads the
+		// table without the lock; registering and building plans take it.
+		typedef struct _Registry
+		{
+			std::mutex Lock;
+			std::atomic<size_t> Count;
+			std::atomic<RegistrySpace*> Spaces[kMaxColorSpaces];
+			std::vector<std::unique_ptr<RegistrySpace>> OwnedSpaces;
+			std::vector<std::unique_ptr<ConversionPlan>> OwnedPlans;
+
+			_Registry() :
+				Count(0)
+			{
+				for (auto& space : Spaces)
+					space.store(nullptr, std::memory_order_relaxed);
+				for (size_t s = 0; s < kRgbModelCount; ++s)
+				{
+					const RgbModel& model = GetRGBModel(static_cast<RgbEnum>(s));
+					Add(RegistryDescribe(model), model);
+				}
+			}
+
+			// under Lock
+			ColorSpaceHandle Add(const ColorSpaceDesc& desc, const RgbModel& model)
+			{
+				const size_t count = Count.load(std::memory_order_relaxed);
+				if (count >= kMaxColorSpaces)
+					return kColorSpaceNone;
+				const ColorSpaceHandle handle = static_cast<ColorSpaceHandle>(count);
+				OwnedSpaces.emplace_back(new RegistrySpace(handle, desc, model));
+				Spaces[count].store(OwnedSpaces.back().get(), std::memory_order_release);
+				Count.store(count + 1, std::memory_order_release);
+				return handle;
+			}
+
+			RegistrySpace& Find(ColorSpaceHandle space)
+			{
+				RegistrySpace* found = (space < kMaxColorSpaces)
+					? Spaces[space].load(std::memory_order_acquire) : nullptr;
+				return found ? *found : *Spaces[static_cast<size_t>(RgbEnum::sRGB)].load(std::memory_order_acquire);
+			}
+		} Registry;
+
+		Registry& GetRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+	}
+
+	ColorSpaceHandle RegisterColorSpace(const ColorSpaceDesc& desc)
+	{
+		const double values[] = { desc.xr, desc.yr, desc.xg, desc.yg, desc.xb, desc.yb,
+			desc.White.X, desc.White.Y, desc.White.Z, desc.Gamma };
+		for (double value : values)
+			if (!std::isfinite(value))
+				return kColorSpaceNone;
+		if (!(desc.yr > 0.0 && desc.yg > 0.0 && desc.yb > 0.0 && desc.White.Y > 0.0))
+			return kColorSpaceNone;
+		const double area = (desc.xg - desc.xr) * (desc.yb - desc.yr) - (desc.xb - desc.xr) * (desc.yg - desc.yr);
+		if (!(std::fabs(area) >= kRegistryMinArea))
+			return kColorSpaceNone;
+
+		ColorSpaceDesc scaled = desc;
+		scaled.White.X = desc.White.X / desc.White.Y;
+		scaled.White.Y = 1.0;
+		scaled.White.Z = desc.White.Z / desc.White.Y;
+
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> guard(registry.Lock);
+		for (const auto& space : registry.OwnedSpaces)
+		{
+			if (RegistryMatch(space->Desc, scaled))
+				return space->Handle;
+		}
+		const RgbModel model = MakeRGBModel(scaled.xr, scaled.yr, scaled.xg, scaled.yg, scaled.xb, scaled.yb,
+			scaled.White, scaled.Gamma);
+		return registry.Add(scaled, model);
+	}
+
+	size_t GetColorSpaceCount()
+	{
+		return GetRegistry().Count.load(std::memory_order_acquire);
+	}
+
+	const RgbModel& GetColorSpaceModel(ColorSpaceHandle space)
+	{
+		return GetRegistry().Find(space).Model;
+	}
+
+	const ConversionPlan& GetColorSpacePlan(ColorSpaceHandle space, IlluminantEnum Illuminant,
+		AdaptationEnum Method, AccuracyEnum Accuracy)
+	{
+		// unknown settings get the defaults, as unknown handles get sRGB
+		if (static_cast<size_t>(Illuminant) >= kRegistryIlluminants)
+			Illuminant = IlluminantEnum::D50;
+		if (static_cast<size_t>(Method) >= kRegistryAdaptations)
+			Method = AdaptationEnum::amBradford;
+		if (static_cast<size_t>(Accuracy) >= kRegistryAccuracies)
+			Accuracy = AccuracyEnum::Exact;
+
+		Registry& registry = GetRegistry();
+		RegistrySpace& found = registry.Find(space);
+		std::atomic<const ConversionPlan*>& slot = found.Plans
+			[static_cast<size_t>(Illuminant)][static_cast<size_t>(Method)][static_cast<size_t>(Accuracy)];
+		const ConversionPlan* plan = slot.load(std::memory_order_acquire);
+		if (plan)
+			return *plan;
+
+		std::lock_guard<std::mutex> guard(registry.Lock);
+		plan = slot.load(std::memory_order_relaxed);
+		if (!plan)
+		{
+			registry.OwnedPlans.emplace_back(new ConversionPlan(found.Handle, found.Model, Illuminant, Method, Accuracy));
+			plan = registry.OwnedPlans.back().get();
+			slot.store(plan, std::memory_order_release);
+		}
+		return *plan;
+	}
+
+	void ConvertSpaces(ColorSpaceHandle src, ColorSpaceHandle dst,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout, AdaptationEnum Method, AccuracyEnum Accuracy)
+	{
+		ConvertBuffer(GetColorSpacePlan(src, IlluminantEnum::D50, Method, Accuracy),
+			GetColorSpacePlan(dst, IlluminantEnum::D50, Method, Accuracy), in, out, n, layout);
+	}
+
+	void ConvertSpaces(ThreadPool& pool, ColorSpaceHandle src, ColorSpaceHandle dst,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout, AdaptationEnum Method, AccuracyEnum Accuracy, size_t tile)
+	{
+		ConvertBuffer(pool, GetColorSpacePlan(src, IlluminantEnum::D50, Method, Accuracy),
+			GetColorSpacePlan(dst, IlluminantEnum::D50, Method, Accuracy), in, out, n, layout, tile);
+	}
+};
@@ -0,0 +1,70 @@
+#ifndef _COLORREGISTRY_H_
+#define _COLORREGISTRY_H_
+
+#include "ColorBuffer.h"
+#include "ColorPlan.h"
+
+namespace COLORNS
+{
+	// working spaces the registry holds, the built-in ones included
+	constexpr size_t kMaxColorSpaces = 256;
+	// RegisterColorSpace could not take the space
+	constexpr ColorSpaceHandle kColorSpaceNone = static_cast<ColorSpaceHandle>(-1);
+
+	// A working space: the chromaticities of its primaries, its white and transfer
+	// function. Gamma as in RgbModel::GammaRGB: > 0 a power, < 0 the sRGB curve, 0 L*.
+	typedef struct _ColorSpaceDesc
+	{
+		double xr;
+		double yr;
+		double xg;
+		double yg;
+		double xb;
+		double yb;
+		XYZ White;
+		double Gamma;
+	} ColorSpaceDesc;
+
+	// XYZ with Y = 1 of the chromaticity x, y
+	XYZ GetWhiteFromXY(double x, double y);
+
+	// Adds a working space and returns its handle. The built-in spaces are registered
+	// first, their handles are the RgbEnum values; a description matching a registered
+	// space returns that space's handle. White is scaled to Y = 1. kColorSpaceNone when
+	// the registry is full, a value is not finite, a y or White.Y is not positive or the
+	// primaries are collinear.
+	// Safe to call from several threads.
+	ColorSpaceHandle RegisterColorSpace(const ColorSpaceDesc& desc);
+
+	// handles 0 to GetColorSpaceCount() - 1 are registered
+	size_t GetColorSpaceCount();
+
+	// the matrices derived from the description; unknown handles get sRGB
+	const RgbModel& GetColorSpaceModel(ColorSpaceHandle space);
+
+	// The plan of a registered space, built on first request and kept for the life of the
+	// program, so Color can hold it. Later requests are a table lookup, no lock taken.
+	// Unknown handles get the sRGB plan, unknown settings the defaults below.
+	const ConversionPlan& GetColorSpacePlan(ColorSpaceHandle space,
+		IlluminantEnum Illuminant = IlluminantEnum::D50,
+		AdaptationEnum Method = AdaptationEnum::amBradford,
+		AccuracyEnum Accuracy = AccuracyEnum::Exact);
+
+	// RGB of src to RGB of dst: ConvertBuffer on the two cached plans, through XYZ
+	// under D50 like a conversion to XYZ and back would go
+	void ConvertSpaces(ColorSpaceHandle src, ColorSpaceHandle dst,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved,
+		AdaptationEnum Method = AdaptationEnum::amBradford,
+		AccuracyEnum Accuracy = AccuracyEnum::Exact);
+
+	class ThreadPool;
+
+	void ConvertSpaces(ThreadPool& pool, ColorSpaceHandle src, ColorSpaceHandle dst,
+		const float* in, float* out, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved,
+		AdaptationEnum Method = AdaptationEnum::amBradford,
+		AccuracyEnum Accuracy = AccuracyEnum::Exact, size_t tile = kTilePixels);
+};
+
+#endif
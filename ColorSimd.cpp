@@ -0,0 +1,175 @@
+#include "ColorSimd.h"
+
+#if defined(COLOR_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace COLORNS
+{
+	namespace
+	{
+		// scalar kernels run the double reference functions
+		void ScalarMtx3x3(const Mtx3x3f& m, float* c1, float* c2, float* c3, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				double a = c1[i];
+				double b = c2[i];
+				double c = c3[i];
+				c1[i] = static_cast<float>(a * m.m[0][0] + b * m.m[1][0] + c * m.m[2][0]);
+				c2[i] = static_cast<float>(a * m.m[0][1] + b * m.m[1][1] + c * m.m[2][1]);
+				c3[i] = static_cast<float>(a * m.m[0][2] + b * m.m[1][2] + c * m.m[2][2]);
+			}
+		}
+
+		void ScalarXYZ2Lab(const XYZ& white, float* c1, float* c2, float* c3, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				double l, a, b;
+				XYZ2Lab<double>(c1[i], c2[i], c3[i], white, l, a, b);
+				c1[i] = static_cast<float>(l);
+				c2[i] = static_cast<float>(a);
+				c3[i] = static_cast<float>(b);
+			}
+		}
+
+		void ScalarLab2XYZ(const XYZ& white, float* c1, float* c2, float* c3, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				double x, y, z;
+				Lab2XYZ<double>(c1[i], c2[i], c3[i], white, x, y, z);
+				c1[i] = static_cast<float>(x);
+				c2[i] = static_cast<float>(y);
+				c3[i] = static_cast<float>(z);
+			}
+		}
+
+		void ScalarDeltaE2000(const float* l1, const float* a1, const float* b1,
+			const float* l2, const float* a2, const float* b2, float* out, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = static_cast<float>(DeltaE2000<double>(l1[i], a1[i], b1[i], l2[i], a2[i], b2[i]));
+		}
+
+		void ScalarSpectralInterleaved(const float* w, size_t bands, const float* in, size_t stride,
+			float* c1, float* c2, float* c3, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				const float* s = in + i * stride;
+				double x = 0.0, y = 0.0, z = 0.0;
+				for (size_t b = 0; b < bands; ++b)
+				{
+					x += static_cast<double>(w[b]) * s[b];
+					y += static_cast<double>(w[bands + b]) * s[b];
+					z += static_cast<double>(w[2 * bands + b]) * s[b];
+				}
+				c1[i] = static_cast<float>(x);
+				c2[i] = static_cast<float>(y);
+				c3[i] = static_cast<float>(z);
+			}
+		}
+
+		void ScalarSpectralPlanar(const float* w, size_t bands, const float* in, size_t stride,
+			float* c1, float* c2, float* c3, size_t n)
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				double x = 0.0, y = 0.0, z = 0.0;
+				for (size_t b = 0; b < bands; ++b)
+				{
+					const double s = in[b * stride + i];
+					x += w[b] * s;
+					y += w[bands + b] * s;
+					z += w[2 * bands + b] * s;
+				}
+				c1[i] = static_cast<float>(x);
+				c2[i] = static_cast<float>(y);
+				c3[i] = static_cast<float>(z);
+			}
+		}
+	}
+
+	const SimdKernels& GetScalarKernels()
+	{
+		static const SimdKernels kernels = { SimdEnum::Scalar,
+			ScalarMtx3x3, ScalarXYZ2Lab, ScalarLab2XYZ, ScalarDeltaE2000,
+			ScalarSpectralInterleaved, ScalarSpectralPlanar };
+		return kernels;
+	}
+
+	namespace
+	{
+		SimdEnum DetectSimd()
+		{
+#if defined(COLOR_SIMD_X86) && defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			const int leaves = info[0];
+			__cpuid(info, 1);
+			const bool sse42 = (info[2] & (1 << 20)) != 0;
+			const bool fma = (info[2] & (1 << 12)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx2 = false;
+			bool avx512 = false;
+			if (leaves >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+				avx512 = (info[1] & (1 << 16)) != 0;
+			}
+			// the OS has to save the ymm / zmm state too
+			const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+			if (avx512 && fma && (xcr0 & 0xe6) == 0xe6)
+				return SimdEnum::AVX512;
+			if (avx2 && fma && (xcr0 & 0x6) == 0x6)
+				return SimdEnum::AVX2;
+			if (sse42)
+				return SimdEnum::SSE42;
+#elif defined(COLOR_SIMD_X86) && defined(__GNUC__)
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f"))
+				return SimdEnum::AVX512;
+			if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+				return SimdEnum::AVX2;
+			if (__builtin_cpu_supports("sse4.2"))
+				return SimdEnum::SSE42;
+#endif
+			return SimdEnum::Scalar;
+		}
+	}
+
+	SimdEnum GetSimdSupport()
+	{
+		static const SimdEnum support = DetectSimd();
+		return support;
+	}
+
+	const SimdKernels& GetSimdKernels(SimdEnum level)
+	{
+		if (static_cast<int>(level) > static_cast<int>(GetSimdSupport()))
+			level = GetSimdSupport();
+		switch (level)
+		{
+#ifdef COLOR_SIMD_X86
+		case SimdEnum::AVX512:
+			return GetAvx512Kernels();
+		case SimdEnum::AVX2:
+			return GetAvx2Kernels();
+		case SimdEnum::SSE42:
+			return GetSse42Kernels();
+#endif
+		default:
+			return GetScalarKernels();
+		}
+	}
+
+	const SimdKernels& GetSimdKernels()
+	{
+		static const SimdKernels& kernels = GetSimdKernels(GetSimdSupport());
+		return kernels;
+	}
+};
@@ -0,0 +1,71 @@
+#ifndef _COLORSIMD_H_
+#define _COLORSIMD_H_
+
+#include "ColorSpace.h"
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLOR_SIMD_X86 1
+#endif
+
+namespace COLORNS
+{
+	enum class SimdEnum
+	{
+		Scalar = 0,
+		SSE42 = 1,		// 4 pixels per iteration
+		AVX2 = 2,		// 8 pixels per iteration, FMA
+		AVX512 = 3		// 16 pixels per iteration
+	};
+
+	// Kernels over planar float data (c1, c2, c3 hold n values each), in place but for
+	// the spectral ones.
+	// The vector variants match the Scalar ones (the double reference functions)
+	// within kSimdXyzTolerance / kSimdLabTolerance / kSimdDeltaETolerance /
+	// kSimdSpectralTolerance (absolute, for XYZ in [0, 1] and Lab in the usual range).
+	typedef struct _SimdKernels
+	{
+		SimdEnum level;
+		// row-vector convention as Mtx3x3: out = in * m
+		void (*Mtx3x3)(const Mtx3x3f& m, float* c1, float* c2, float* c3, size_t n);
+		void (*XYZ2Lab)(const XYZ& white, float* c1, float* c2, float* c3, size_t n);
+		void (*Lab2XYZ)(const XYZ& white, float* c1, float* c2, float* c3, size_t n);
+		// out[i] = CIEDE2000 of (l1, a1, b1)[i] and (l2, a2, b2)[i]
+		void (*DeltaE2000)(const float* l1, const float* a1, const float* b1,
+			const float* l2, const float* a2, const float* b2, float* out, size_t n);
+		// spectra to XYZ: c1, c2, c3 [i] = the bands samples of spectrum i dotted with the
+		// x, y and z weights (w, w + bands, w + 2 bands). Interleaved: spectrum i starts
+		// at in + i * stride; Planar: its sample b is in[b * stride + i].
+		void (*SpectralInterleaved)(const float* w, size_t bands, const float* in, size_t stride,
+			float* c1, float* c2, float* c3, size_t n);
+		void (*SpectralPlanar)(const float* w, size_t bands, const float* in, size_t stride,
+			float* c1, float* c2, float* c3, size_t n);
+	} SimdKernels;
+
+	constexpr float kSimdXyzTolerance = 1e-6f;
+	constexpr float kSimdLabTolerance = 5e-4f;
+	// absolute, for Lab pairs in the usual range
+	constexpr float kSimdDeltaETolerance = 1e-3f;
+	// absolute, for spectra in [0, 1] on weights that give the white Y = 1
+	constexpr float kSimdSpectralTolerance = 1e-5f;
+
+	// the best level this CPU (and OS) supports, detected with CPUID on first use
+	SimdEnum GetSimdSupport();
+
+	// kernels of the level, lowered to GetSimdSupport() if the CPU can't run it
+	const SimdKernels& GetSimdKernels(SimdEnum level);
+
+	// kernels of the best supported level
+	const SimdKernels& GetSimdKernels();
+
+	// per-ISA tables, defined in ColorSimdSse.cpp, ColorSimdAvx2.cpp and ColorSimdAvx512.cpp
+	const SimdKernels& GetScalarKernels();
+#ifdef COLOR_SIMD_X86
+	const SimdKernels& GetSse42Kernels();
+	const SimdKernels& GetAvx2Kernels();
+	const SimdKernels& GetAvx512Kernels();
+#endif
+};
+
+#endif
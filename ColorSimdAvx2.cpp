@@ -0,0 +1,56 @@
+#include "ColorSimdKernels.h"
+
+#ifdef COLOR_SIMD_X86
+
+#include <immintrin.h>
+
+namespace COLORNS
+{
+	namespace
+	{
+		struct Avx2
+		{
+			static constexpr size_t kWidth = 8;
+			typedef __m256 reg;
+			typedef __m256 mask;
+
+			static reg Load(const float* p) { return _mm256_loadu_ps(p); }
+			static void Store(float* p, reg a) { _mm256_storeu_ps(p, a); }
+			static reg Set(float v) { return _mm256_set1_ps(v); }
+			static reg Add(reg a, reg b) { return _mm256_add_ps(a, b); }
+			static reg Sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+			static reg Mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+			static reg Div(reg a, reg b) { return _mm256_div_ps(a, b); }
+			static reg MulAdd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+			static reg Max(reg a, reg b) { return _mm256_max_ps(a, b); }
+			static reg Min(reg a, reg b) { return _mm256_min_ps(a, b); }
+			static reg Sqrt(reg a) { return _mm256_sqrt_ps(a); }
+			static mask Gt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+			static reg Select(mask m, reg a, reg b) { return _mm256_blendv_ps(b, a, m); }
+			// bits / 3 + magic, the division done in float
+			static reg CbrtSeed(reg x)
+			{
+				__m256 bits = _mm256_cvtepi32_ps(_mm256_castps_si256(x));
+				__m256i third = _mm256_cvttps_epi32(_mm256_mul_ps(bits, _mm256_set1_ps(1.0f / 3.0f)));
+				return _mm256_castsi256_ps(_mm256_add_epi32(third, _mm256_set1_epi32(0x2a508935)));
+			}
+			static float Sum(reg a)
+			{
+				__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+				s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+				return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+			}
+		};
+	}
+
+	const SimdKernels& GetAvx2Kernels()
+	{
+		static const SimdKernels kernels = { SimdEnum::AVX2,
+			Mtx3x3Kernel<Avx2>, XYZ2LabKernel<Avx2>, Lab2XYZKernel<Avx2>,
+			DeltaE2000Kernel<Avx2>,
+			SpectralInterleavedKernel<Avx2>, SpectralPlanarKernel<Avx2> };
+		return kernels;
+	}
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "ColorSimdKernels.h"
+
+#ifdef COLOR_SIMD_X86
+
+#include <immintrin.h>
+
+namespace COLORNS
+{
+	namespace
+	{
+		struct Avx512
+		{
+			static constexpr size_t kWidth = 16;
+			typedef __m512 reg;
+			typedef __mmask16 mask;
+
+			static reg Load(const float* p) { return _mm512_loadu_ps(p); }
+			static void Store(float* p, reg a) { _mm512_storeu_ps(p, a); }
+			static reg Set(float v) { return _mm512_set1_ps(v); }
+			static reg Add(reg a, reg b) { return _mm512_add_ps(a, b); }
+			static reg Sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+			static reg Mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+			static reg Div(reg a, reg b) { return _mm512_div_ps(a, b); }
+			static reg MulAdd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+			static reg Max(reg a, reg b) { return _mm512_max_ps(a, b); }
+			static reg Min(reg a, reg b) { return _mm512_min_ps(a, b); }
+			static reg Sqrt(reg a) { return _mm512_sqrt_ps(a); }
+			static mask Gt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+			static reg Select(mask m, reg a, reg b) { return _mm512_mask_blend_ps(m, b, a); }
+			// bits / 3 + magic, the division done in float
+			static reg CbrtSeed(reg x)
+			{
+				__m512 bits = _mm512_cvtepi32_ps(_mm512_castps_si512(x));
+				__m512i third = _mm512_cvttps_epi32(_mm512_mul_ps(bits, _mm512_set1_ps(1.0f / 3.0f)));
+				return _mm512_castsi512_ps(_mm512_add_epi32(third, _mm512_set1_epi32(0x2a508935)));
+			}
+			static float Sum(reg a) { return _mm512_reduce_add_ps(a); }
+		};
+	}
+
+	const SimdKernels& GetAvx512Kernels()
+	{
+		static const SimdKernels kernels = { SimdEnum::AVX512,
+			Mtx3x3Kernel<Avx512>, XYZ2LabKernel<Avx512>, Lab2XYZKernel<Avx512>,
+			DeltaE2000Kernel<Avx512>,
+			SpectralInterleavedKernel<Avx512>, SpectralPlanarKernel<Avx512> };
+		return kernels;
+	}
+};
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef _COLORSIMDKERNELS_H_
+#define _COLORSIMDKERNELS_H_
+
+// Kernel bodies shared by the per-ISA translation units. Each of them includes
+// this header with its own vector traits V (compiled with its own -m flags);
+// the traits live in an unnamed namespace, so the instantiations never mix.
+//
+// V provides: kWidth, reg, mask, Load, Store, Set, Add, Sub, Mul, Div,
+// MulAdd (a * b + c), Max, Min, Sqrt, Gt (a > b), Select (m ? a : b), CbrtSeed,
+// Sum (of the lanes)
+
+#include "ColorSimd.h"
+
+namespace COLORNS
+{
+	template <class V>
+	void Mtx3x3Kernel(const Mtx3x3f& m, float* c1, float* c2, float* c3, size_t n)
+	{
+		typedef typename V::reg reg;
+		const reg m00 = V::Set(m.m[0][0]), m01 = V::Set(m.m[0][1]), m02 = V::Set(m.m[0][2]);
+		const reg m10 = V::Set(m.m[1][0]), m11 = V::Set(m.m[1][1]), m12 = V::Set(m.m[1][2]);
+		const reg m20 = V::Set(m.m[2][0]), m21 = V::Set(m.m[2][1]), m22 = V::Set(m.m[2][2]);
+
+		size_t i = 0;
+		for (; i + V::kWidth <= n; i += V::kWidth)
+		{
+			reg a = V::Load(c1 + i);
+			reg b = V::Load(c2 + i);
+			reg c = V::Load(c3 + i);
+			V::Store(c1 + i, V::MulAdd(c, m20, V::MulAdd(b, m10, V::Mul(a, m00))));
+			V::Store(c2 + i, V::MulAdd(c, m21, V::MulAdd(b, m11, V::Mul(a, m01))));
+			V::Store(c3 + i, V::MulAdd(c, m22, V::MulAdd(b, m12, V::Mul(a, m02))));
+		}
+		GetScalarKernels().Mtx3x3(m, c1 + i, c2 + i, c3 + i, n - i);
+	}
+
+	// cube root of x > 0: bit trick seed, then two Halley steps
+	template <class V>
+	typename V::reg CbrtKernel(typename V::reg x)
+	{
+		typedef typename V::reg reg;
+		const reg two = V::Set(2.0f);
+		reg y = V::CbrtSeed(x);
+		for (int i = 0; i < 2; ++i)
+		{
+			reg y3 = V::Mul(V::Mul(y, y), y);
+			y = V::Mul(y, V::Div(V::MulAdd(two, x, y3), V::MulAdd(two, y3, x)));
+		}
+		return y;
+	}
+
+	template <class V>
+	typename V::reg LabF(typename V::reg t)
+	{
+		const typename V::reg e = V::Set(static_cast<float>(kE));
+		return V::Select(V::Gt(t, e), CbrtKernel<V>(V::Max(t, e)),
+			V::MulAdd(t, V::Set(static_cast<float>(kK / 116.0)), V::Set(16.0f / 116.0f)));
+	}
+
+	template <class V>
+	void XYZ2LabKernel(const XYZ& white, float* c1, float* c2, float* c3, size_t n)
+	{
+		typedef typename V::reg reg;
+		const reg wx = V::Set(static_cast<float>(1.0 / white.X));
+		const reg wy = V::Set(static_cast<float>(1.0 / white.Y));
+		const reg wz = V::Set(static_cast<float>(1.0 / white.Z));
+		const reg c116 = V::Set(116.0f);
+		const reg c16 = V::Set(16.0f);
+		const reg c500 = V::Set(500.0f);
+		const reg c200 = V::Set(200.0f);
+
+		size_t i = 0;
+		for (; i + V::kWidth <= n; i += V::kWidth)
+		{
+			reg fx = LabF<V>(V::Mul(V::Load(c1 + i), wx));
+			reg fy = LabF<V>(V::Mul(V::Load(c2 + i), wy));
+			reg fz = LabF<V>(V::Mul(V::Load(c3 + i), wz));
+			V::Store(c1 + i, V::Sub(V::Mul(c116, fy), c16));
+			V::Store(c2 + i, V::Mul(c500, V::Sub(fx, fy)));
+			V::Store(c3 + i, V::Mul(c200, V::Sub(fy, fz)));
+		}
+		GetScalarKernels().XYZ2Lab(white, c1 + i, c2 + i, c3 + i, n - i);
+	}
+
+	template <class V>
+	void Lab2XYZKernel(const XYZ& white, float* c1, float* c2, float* c3, size_t n)
+	{
+		typedef typename V::reg reg;
+		const reg wx = V::Set(static_cast<float>(white.X));
+		const reg wy = V::Set(static_cast<float>(white.Y));
+		const reg wz = V::Set(static_cast<float>(white.Z));
+		const reg e = V::Set(static_cast<float>(kE));
+		const reg ke = V::Set(static_cast<float>(kKE));
+		const reg ik = V::Set(static_cast<float>(1.0 / kK));
+		const reg k116 = V::Set(static_cast<float>(116.0 / kK));
+		const reg k16 = V::Set(static_cast<float>(-16.0 / kK));
+		const reg c16 = V::Set(16.0f);
+		const reg i116 = V::Set(1.0f / 116.0f);
+		const reg c0002 = V::Set(0.002f);
+		const reg c0005 = V::Set(0.005f);
+
+		size_t i = 0;
+		for (; i + V::kWidth <= n; i += V::kWidth)
+		{
+			reg l = V::Load(c1 + i);
+			reg fy = V::Mul(V::Add(l, c16), i116);
+			reg fx = V::MulAdd(V::Load(c2 + i), c0002, fy);
+			reg fz = V::Sub(fy, V::Mul(V::Load(c3 + i), c0005));
+
+			reg fx3 = V::Mul(V::Mul(fx, fx), fx);
+			reg fy3 = V::Mul(V::Mul(fy, fy), fy);
+			reg fz3 = V::Mul(V::Mul(fz, fz), fz);
+
+			reg xr = V::Select(V::Gt(fx3, e), fx3, V::MulAdd(fx, k116, k16));
+			reg yr = V::Select(V::Gt(l, ke), fy3, V::Mul(l, ik));
+			reg zr = V::Select(V::Gt(fz3, e), fz3, V::MulAdd(fz, k116, k16));
+
+			V::Store(c1 + i, V::Mul(xr, wx));
+			V::Store(c2 + i, V::Mul(yr, wy));
+			V::Store(c3 + i, V::Mul(zr, wz));
+		}
+		GetScalarKernels().Lab2XYZ(white, c1 + i, c2 + i, c3 + i, n - i);
+	}
+
+	// atan2(y, x) in [0, 2 pi): octant reduction and an odd polynomial on [0, 1], error ~2e-6
+	template <class V>
+	typename V::reg Atan2Kernel(typename V::reg y, typename V::reg x)
+	{
+		typedef typename V::reg reg;
+		const reg zero = V::Set(0.0f);
+		const reg pi = V::Set(3.14159265f);
+		const reg ax = V::Max(x, V::Sub(zero, x));
+		const reg ay = V::Max(y, V::Sub(zero, y));
+		const reg t = V::Div(V::Min(ax, ay), V::Max(V::Max(ax, ay), V::Set(1e-30f)));
+		const reg s = V::Mul(t, t);
+		reg r = V::MulAdd(s, V::Set(-0.01172120f), V::Set(0.05265332f));
+		r = V::MulAdd(r, s, V::Set(-0.11643287f));
+		r = V::MulAdd(r, s, V::Set(0.19354346f));
+		r = V::MulAdd(r, s, V::Set(-0.33262347f));
+		r = V::MulAdd(r, s, V::Set(0.99997726f));
+		r = V::Mul(r, t);
+		r = V::Select(V::Gt(ay, ax), V::Sub(V::Set(1.57079633f), r), r);
+		r = V::Select(V::Gt(zero, x), V::Sub(pi, r), r);
+		return V::Select(V::Gt(zero, y), V::Sub(V::Set(6.28318531f), r), r);
+	}
+
+	// exp(-t) for t >= 0: Taylor series of exp(-t / 16), squared four times;
+	// t is clamped to 32, where the result is already under 1e-13
+	template <class V>
+	typename V::reg ExpNegKernel(typename V::reg t)
+	{
+		typedef typename V::reg reg;
+		const reg u = V::Mul(V::Min(t, V::Set(32.0f)), V::Set(1.0f / 16.0f));
+		reg r = V::Set(1.0f / 40320.0f);
+		r = V::MulAdd(r, u, V::Set(-1.0f / 5040.0f));
+		r = V::MulAdd(r, u, V::Set(1.0f / 720.0f));
+		r = V::MulAdd(r, u, V::Set(-1.0f / 120.0f));
+		r = V::MulAdd(r, u, V::Set(1.0f / 24.0f));
+		r = V::MulAdd(r, u, V::Set(-1.0f / 6.0f));
+		r = V::MulAdd(r, u, V::Set(0.5f));
+		r = V::MulAdd(r, u, V::Set(-1.0f));
+		r = V::MulAdd(r, u, V::Set(1.0f));
+		for (int i = 0; i < 4; ++i)
+			r = V::Mul(r, r);
+		return r;
+	}
+
+	// CIEDE2000 without per-pixel branches and with one polynomial atan2:
+	// dH' and the mean hue (the shorter-arc mean) come from the a'b vectors themselves,
+	// the multiples of the mean hue for T by angle addition. Only the rotation term
+	// needs the hue angle itself. At hue differences of exactly 180 degrees the formula
+	// jumps, there the kernel may pick the other mean.
+	template <class V>
+	void DeltaE2000Kernel(const float* l1, const float* a1, const float* b1,
+		const float* l2, const float* a2, const float* b2, float* out, size_t n)
+	{
+		typedef typename V::reg reg;
+		const reg zero = V::Set(0.0f);
+		const reg one = V::Set(1.0f);
+		const reg half = V::Set(0.5f);
+		const reg two = V::Set(2.0f);
+		const reg tiny = V::Set(1e-30f);
+		const reg pow25_7 = V::Set(6103515625.0f);
+		// cos / sin of 30, 6 and 63 degrees
+		const reg cos30 = V::Set(0.866025404f), sin30 = V::Set(0.5f);
+		const reg cos6 = V::Set(0.994521895f), sin6 = V::Set(0.104528463f);
+		const reg cos63 = V::Set(0.453990500f), sin63 = V::Set(0.891006524f);
+
+		size_t i = 0;
+		for (; i + V::kWidth <= n; i += V::kWidth)
+		{
+			const reg L1 = V::Load(l1 + i), A1 = V::Load(a1 + i), B1 = V::Load(b1 + i);
+			const reg L2 = V::Load(l2 + i), A2 = V::Load(a2 + i), B2 = V::Load(b2 + i);
+
+			const reg c1 = V::Sqrt(V::MulAdd(A1, A1, V::Mul(B1, B1)));
+			const reg c2 = V::Sqrt(V::MulAdd(A2, A2, V::Mul(B2, B2)));
+			const reg cm = V::Mul(V::Add(c1, c2), half);
+			const reg cm2 = V::Mul(cm, cm);
+			const reg cm7 = V::Mul(V::Mul(V::Mul(cm2, cm2), cm2), cm);
+			const reg g1 = V::Add(one, V::Mul(half, V::Sub(one, V::Sqrt(V::Div(cm7, V::Add(cm7, pow25_7))))));
+			const reg ap1 = V::Mul(g1, A1);
+			const reg ap2 = V::Mul(g1, A2);
+			const reg cp1 = V::Sqrt(V::MulAdd(ap1, ap1, V::Mul(B1, B1)));
+			const reg cp2 = V::Sqrt(V::MulAdd(ap2, ap2, V::Mul(B2, B2)));
+
+			const reg dl = V::Sub(L2, L1);
+			const reg dc = V::Sub(cp2, cp1);
+			const reg da = V::Sub(ap2, ap1);
+			const reg db = V::Sub(B2, B1);
+			// dH = 2 sqrt(C1 C2) sin(dh / 2): cross / sqrt((C1 C2 + dot) / 2) below 90 degrees,
+			// where the chord would cancel, the signed chord above
+			const reg cross = V::Sub(V::Mul(ap1, B2), V::Mul(ap2, B1));
+			const reg dot = V::MulAdd(ap1, ap2, V::Mul(B1, B2));
+			const reg cc = V::Mul(cp1, cp2);
+			const reg near = V::Div(cross, V::Max(V::Sqrt(V::Mul(V::Add(cc, dot), half)), tiny));
+			reg far = V::Sqrt(V::Max(zero, V::Sub(V::MulAdd(da, da, V::Mul(db, db)), V::Mul(dc, dc))));
+			far = V::Select(V::Gt(zero, cross), V::Sub(zero, far), far);
+			const reg dh = V::Select(V::Gt(dot, zero), near, far);
+
+			// unit vector of the mean hue: u1 + u2, or +-rot90(u1 - u2) past 90 degrees,
+			// where the sum would cancel
+			const reg i1 = V::Div(one, V::Max(cp1, tiny));
+			const reg i2 = V::Div(one, V::Max(cp2, tiny));
+			const reg x1 = V::Mul(ap1, i1), y1 = V::Mul(B1, i1);
+			const reg x2 = V::Mul(ap2, i2), y2 = V::Mul(B2, i2);
+			const typename V::mask opposite = V::Gt(zero, dot);
+			const reg side = V::Select(V::Gt(zero, cross), V::Set(-1.0f), one);
+			const reg ux = V::Select(opposite, V::Mul(side, V::Sub(y2, y1)), V::Add(x1, x2));
+			const reg uy = V::Select(opposite, V::Mul(side, V::Sub(x1, x2)), V::Add(y1, y2));
+			const reg iu = V::Div(one, V::Max(V::Sqrt(V::MulAdd(ux, ux, V::Mul(uy, uy))), tiny));
+			const reg ch = V::Mul(ux, iu), sh = V::Mul(uy, iu);
+			const reg c2h = V::Sub(V::Mul(ch, ch), V::Mul(sh, sh)), s2h = V::Mul(two, V::Mul(sh, ch));
+			const reg c3h = V::Sub(V::Mul(ch, c2h), V::Mul(sh, s2h)), s3h = V::MulAdd(sh, c2h, V::Mul(ch, s2h));
+			const reg c4h = V::Sub(V::Mul(c2h, c2h), V::Mul(s2h, s2h)), s4h = V::Mul(two, V::Mul(s2h, c2h));
+			reg t = V::Sub(one, V::Mul(V::Set(0.17f), V::MulAdd(ch, cos30, V::Mul(sh, sin30))));
+			t = V::MulAdd(V::Set(0.24f), c2h, t);
+			t = V::MulAdd(V::Set(0.32f), V::Sub(V::Mul(c3h, cos6), V::Mul(s3h, sin6)), t);
+			t = V::Sub(t, V::Mul(V::Set(0.20f), V::MulAdd(c4h, cos63, V::Mul(s4h, sin63))));
+
+			// rotation: 2 dtheta = 60 deg * exp(-((hm - 275) / 25)^2), sin by its series
+			const reg x = V::Mul(V::Sub(V::Mul(Atan2Kernel<V>(sh, ch), V::Set(57.2957795f)), V::Set(275.0f)),
+				V::Set(1.0f / 25.0f));
+			const reg th = V::Mul(V::Set(1.04719755f), ExpNegKernel<V>(V::Mul(x, x)));
+			const reg th2 = V::Mul(th, th);
+			reg sin2t = V::MulAdd(th2, V::Set(-1.0f / 5040.0f), V::Set(1.0f / 120.0f));
+			sin2t = V::MulAdd(sin2t, th2, V::Set(-1.0f / 6.0f));
+			sin2t = V::Mul(th, V::MulAdd(sin2t, th2, one));
+			const reg cpm = V::Mul(V::Add(cp1, cp2), half);
+			const reg cpm2 = V::Mul(cpm, cpm);
+			const reg cpm7 = V::Mul(V::Mul(V::Mul(cpm2, cpm2), cpm2), cpm);
+			const reg rt = V::Mul(V::Sub(zero, sin2t), V::Mul(two, V::Sqrt(V::Div(cpm7, V::Add(cpm7, pow25_7)))));
+
+			const reg lm = V::Sub(V::Mul(V::Add(L1, L2), half), V::Set(50.0f));
+			const reg lm50 = V::Mul(lm, lm);
+			const reg sl = V::MulAdd(V::Set(0.015f), V::Div(lm50, V::Sqrt(V::Add(V::Set(20.0f), lm50))), one);
+			const reg sc = V::MulAdd(V::Set(0.045f), cpm, one);
+			const reg shue = V::MulAdd(V::Mul(V::Set(0.015f), cpm), t, one);
+			const reg vl = V::Div(dl, sl);
+			const reg vc = V::Div(dc, sc);
+			const reg vh = V::Div(dh, shue);
+			const reg sum = V::MulAdd(vl, vl, V::MulAdd(vc, vc, V::MulAdd(vh, vh, V::Mul(rt, V::Mul(vc, vh)))));
+			V::Store(out + i, V::Sqrt(V::Max(sum, zero)));
+		}
+		GetScalarKernels().DeltaE2000(l1 + i, a1 + i, b1 + i, l2 + i, a2 + i, b2 + i, out + i, n - i);
+	}
+
+	// P spectra at a time, the lanes across their bands; each spectrum has its own
+	// accumulators, the weights are loaded once for all of them. The bands past the
+	// last full vector come from one more load of the final kWidth samples, tail holds
+	// the weights for it with the lanes already summed set to 0.
+	template <class V, size_t P>
+	void SpectralDotKernel(const float* w, size_t bands, const typename V::reg tail[3],
+		const float* in, size_t stride, float* c1, float* c2, float* c3)
+	{
+		typedef typename V::reg reg;
+		const size_t body = bands - bands % V::kWidth;
+		reg x[P], y[P], z[P];
+		for (size_t p = 0; p < P; ++p)
+			x[p] = y[p] = z[p] = V::Set(0.0f);
+		for (size_t b = 0; b < body; b += V::kWidth)
+		{
+			const reg wx = V::Load(w + b);
+			const reg wy = V::Load(w + bands + b);
+			const reg wz = V::Load(w + 2 * bands + b);
+			for (size_t p = 0; p < P; ++p)
+			{
+				const reg s = V::Load(in + p * stride + b);
+				x[p] = V::MulAdd(s, wx, x[p]);
+				y[p] = V::MulAdd(s, wy, y[p]);
+				z[p] = V::MulAdd(s, wz, z[p]);
+			}
+		}
+		if (body < bands)
+			for (size_t p = 0; p < P; ++p)
+			{
+				const reg s = V::Load(in + p * stride + bands - V::kWidth);
+				x[p] = V::MulAdd(s, tail[0], x[p]);
+				y[p] = V::MulAdd(s, tail[1], y[p]);
+				z[p] = V::MulAdd(s, tail[2], z[p]);
+			}
+		for (size_t p = 0; p < P; ++p)
+		{
+			c1[p] = V::Sum(x[p]);
+			c2[p] = V::Sum(y[p]);
+			c3[p] = V::Sum(z[p]);
+		}
+	}
+
+	// four spectra per pass; spectra shorter than a vector go to the scalar kernel
+	template <class V>
+	void SpectralInterleavedKernel(const float* w, size_t bands, const float* in, size_t stride,
+		float* c1, float* c2, float* c3, size_t n)
+	{
+		typedef typename V::reg reg;
+		if (bands < V::kWidth)
+		{
+			GetScalarKernels().SpectralInterleaved(w, bands, in, stride, c1, c2, c3, n);
+			return;
+		}
+		const size_t rest = bands % V::kWidth;
+		float t[V::kWidth];
+		reg tail[3];
+		for (size_t k = 0; k < 3; ++k)
+		{
+			for (size_t lane = 0; lane < V::kWidth; ++lane)
+				t[lane] = (lane + rest >= V::kWidth) ? w[k * bands + bands - V::kWidth + lane] : 0.0f;
+			tail[k] = V::Load(t);
+		}
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			SpectralDotKernel<V, 4>(w, bands, tail, in + i * stride, stride, c1 + i, c2 + i, c3 + i);
+		for (; i < n; ++i)
+			SpectralDotKernel<V, 1>(w, bands, tail, in + i * stride, stride, c1 + i, c2 + i, c3 + i);
+	}
+
+	// the lanes across the spectra: two band planes per sweep over c1, c2, c3, which
+	// stay in L1 for the chunks SpectralTable passes, while the planes stream through
+	template <class V>
+	void SpectralPlanarKernel(const float* w, size_t bands, const float* in, size_t stride,
+		float* c1, float* c2, float* c3, size_t n)
+	{
+		typedef typename V::reg reg;
+		const float* wx = w;
+		const float* wy = w + bands;
+		const float* wz = w + 2 * bands;
+		const size_t m = n - n % V::kWidth;
+		const reg zero = V::Set(0.0f);
+		for (size_t i = 0; i < m; i += V::kWidth)
+		{
+			V::Store(c1 + i, zero);
+			V::Store(c2 + i, zero);
+			V::Store(c3 + i, zero);
+		}
+		size_t b = 0;
+		for (; b + 2 <= bands; b += 2)
+		{
+			const float* p0 = in + b * stride;
+			const float* p1 = p0 + stride;
+			const reg x0 = V::Set(wx[b]), y0 = V::Set(wy[b]), z0 = V::Set(wz[b]);
+			const reg x1 = V::Set(wx[b + 1]), y1 = V::Set(wy[b + 1]), z1 = V::Set(wz[b + 1]);
+			for (size_t i = 0; i < m; i += V::kWidth)
+			{
+				const reg s0 = V::Load(p0 + i);
+				const reg s1 = V::Load(p1 + i);
+				V::Store(c1 + i, V::MulAdd(s1, x1, V::MulAdd(s0, x0, V::Load(c1 + i))));
+				V::Store(c2 + i, V::MulAdd(s1, y1, V::MulAdd(s0, y0, V::Load(c2 + i))));
+				V::Store(c3 + i, V::MulAdd(s1, z1, V::MulAdd(s0, z0, V::Load(c3 + i))));
+			}
+		}
+		if (b < bands)
+		{
+			const float* p0 = in + b * stride;
+			const reg x0 = V::Set(wx[b]), y0 = V::Set(wy[b]), z0 = V::Set(wz[b]);
+			for (size_t i = 0; i < m; i += V::kWidth)
+			{
+				const reg s0 = V::Load(p0 + i);
+				V::Store(c1 + i, V::MulAdd(s0, x0, V::Load(c1 + i)));
+				V::Store(c2 + i, V::MulAdd(s0, y0, V::Load(c2 + i)));
+				V::Store(c3 + i, V::MulAdd(s0, z0, V::Load(c3 + i)));
+			}
+		}
+		GetScalarKernels().SpectralPlanar(w, bands, in + m, stride, c1 + m, c2 + m, c3 + m, n - m);
+	}
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "ColorSimdKernels.h"
+
+#ifdef COLOR_SIMD_X86
+
+#include <immintrin.h>
+
+namespace COLORNS
+{
+	namespace
+	{
+		struct Sse42
+		{
+			static constexpr size_t kWidth = 4;
+			typedef __m128 reg;
+			typedef __m128 mask;
+
+			static reg Load(const float* p) { return _mm_loadu_ps(p); }
+			static void Store(float* p, reg a) { _mm_storeu_ps(p, a); }
+			static reg Set(float v) { return _mm_set1_ps(v); }
+			static reg Add(reg a, reg b) { return _mm_add_ps(a, b); }
+			static reg Sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+			static reg Mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+			static reg Div(reg a, reg b) { return _mm_div_ps(a, b); }
+			static reg MulAdd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			static reg Max(reg a, reg b) { return _mm_max_ps(a, b); }
+			static reg Min(reg a, reg b) { return _mm_min_ps(a, b); }
+			static reg Sqrt(reg a) { return _mm_sqrt_ps(a); }
+			static mask Gt(reg a, reg b) { return _mm_cmpgt_ps(a, b); }
+			static reg Select(mask m, reg a, reg b) { return _mm_blendv_ps(b, a, m); }
+			// bits / 3 + magic, the division done in float
+			static reg CbrtSeed(reg x)
+			{
+				__m128 bits = _mm_cvtepi32_ps(_mm_castps_si128(x));
+				__m128i third = _mm_cvttps_epi32(_mm_mul_ps(bits, _mm_set1_ps(1.0f / 3.0f)));
+				return _mm_castsi128_ps(_mm_add_epi32(third, _mm_set1_epi32(0x2a508935)));
+			}
+			static float Sum(reg a)
+			{
+				__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+				return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+			}
+		};
+	}
+
+	const SimdKernels& GetSse42Kernels()
+	{
+		static const SimdKernels kernels = { SimdEnum::SSE42,
+			Mtx3x3Kernel<Sse42>, XYZ2LabKernel<Sse42>, Lab2XYZKernel<Sse42>,
+			DeltaE2000Kernel<Sse42>,
+			SpectralInterleavedKernel<Sse42>, SpectralPlanarKernel<Sse42> };
+		return kernels;
+	}
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef _COLORSPACE_H_
+#define _COLORSPACE_H_
+
+#include <cstddef>
+
+namespace COLORNS
+{
+	//////////////////////////////////////////////////////////////////////////////////////////////////
+	// brucelindblum.com CIE Color Calculator C++ porting
+	typedef struct _XYZ
+	{
+		double X{ 0.0 };
+		double Y{ 0.0 };
+		double Z{ 0.0 };
+	} XYZ;
+
+	enum class AdaptationEnum
+	{
+		amBradford = 0,
+		amVonKries = 1,
+//		amXYZScaling = 2,
+		amNone = 2
+	};
+
+	enum class RgbEnum
+	{
+		AdobeRgb = 0,
+		AppleRgb = 1,
+		BestRgb = 2,
+		BetaRgb = 3,
+		BruceRgb = 4,
+		CieRgb = 5,
+		ColorMatchRgb = 6,
+		DonRgb4 = 7,
+		EciRgb2 = 8,
+		EktaSpacePS5 = 9,
+		NtscRgb = 10,
+		PalSecamRgb = 11,
+		ProPhotoRgb = 12,
+		SmpteCRgb = 13,
+		sRGB = 14,
+		WideGamutRgb = 15
+	};
+
+	constexpr size_t kRgbModelCount = 16;
+
+	enum class IlluminantEnum
+	{
+		A = 0,
+		B = 1,
+		C = 2,
+		D50 = 3,
+		D55 = 4,
+		D65 = 5,
+		D75 = 6,
+		E = 7,
+		F2 = 8,
+		F7 = 9,
+		F11 = 10
+	};
+
+	// the conversion functions below are templates on the scalar type T, defined
+	// in Color.cpp for float and double; white points and models stay double
+	template <typename T = double>
+	struct BasicMtx3x3
+	{
+		T m[3][3];
+	};
+
+	typedef BasicMtx3x3<> Mtx3x3;
+	typedef BasicMtx3x3<float> Mtx3x3f;
+
+	// element-wise conversion between scalar types
+	template <typename T, typename U>
+	BasicMtx3x3<T> MtxConvert3x3(const BasicMtx3x3<U>& m)
+	{
+		BasicMtx3x3<T> result;
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				result.m[i][j] = static_cast<T>(m.m[i][j]);
+		return result;
+	}
+
+	typedef struct _RgbModel
+	{
+		XYZ RefWhiteRGB;
+		double GammaRGB;
+		Mtx3x3 MtxRGB2XYZ;
+		Mtx3x3 MtxXYZ2RGB;
+	} RgbModel;
+
+	constexpr double kE = 216.0 / 24389.0;
+	constexpr double kK = 24389.0 / 27.0;
+	constexpr double kKE = 8.0;
+
+	template <typename T>
+	T GetLuminance(const T r, const T g, const T b);
+
+	template <typename T>
+	void GetHSPVL(const T r, const T g, const T b,
+		T& h, T& s, T& p, T& v, T& l);
+
+	template <typename T>
+	void GetRGBfromHSV(const T h, const T s, const T v,
+		T& r, T& g, T& b);
+
+	// the white points, matrix helpers and the adaptation table are constexpr, so the
+	// working space table and ColorConstexpr.h evaluate them at compile time
+	constexpr XYZ GetRefWhite(IlluminantEnum i = IlluminantEnum::D50)
+	{
+		XYZ RefWhite;
+		RefWhite.Y = 1.0;
+		switch (i)
+		{
+		case IlluminantEnum::A:	// A (ASTM E308-01)
+			RefWhite.X = 1.09850;
+			RefWhite.Z = 0.35585;
+			break;
+		case IlluminantEnum::B:	// B (Wyszecki & Stiles, p. 769)
+			RefWhite.X = 0.99072;
+			RefWhite.Z = 0.85223;
+			break;
+		case IlluminantEnum::C:	// C (ASTM E308-01)
+			RefWhite.X = 0.98074;
+			RefWhite.Z = 1.18232;
+			break;
+		case IlluminantEnum::D50:	// D50 (ASTM E308-01)
+			RefWhite.X = 0.96422;
+			RefWhite.Z = 0.82521;
+			break;
+		case IlluminantEnum::D55:	// D55 (ASTM E308-01)
+			RefWhite.X = 0.95682;
+			RefWhite.Z = 0.92149;
+			break;
+		case IlluminantEnum::D65:	// D65 (ASTM E308-01)
+			RefWhite.X = 0.95047;
+			RefWhite.Z = 1.08883;
+			break;
+		case IlluminantEnum::D75:	// D75 (ASTM E308-01)
+			RefWhite.X = 0.94972;
+			RefWhite.Z = 1.22638;
+			break;
+		default:
+		case IlluminantEnum::E:	// E (ASTM E308-01)
+			RefWhite.X = 1.00000;
+			RefWhite.Z = 1.00000;
+			break;
+		case IlluminantEnum::F2:	// F2 (ASTM E308-01)
+			RefWhite.X = 0.99186;
+			RefWhite.Z = 0.67393;
+			break;
+		case IlluminantEnum::F7:	// F7 (ASTM E308-01)
+			RefWhite.X = 0.95041;
+			RefWhite.Z = 1.08747;
+			break;
+		case IlluminantEnum::F11:	// F11 (ASTM E308-01)
+			RefWhite.X = 1.00962;
+			RefWhite.Z = 0.64350;
+			break;
+		}
+		return RefWhite;
+	}
+
+	template <typename T>
+	constexpr T Determinant3x3(const BasicMtx3x3<T>& m)
+	{
+		T det = m.m[0][0] * (m.m[2][2] * m.m[1][1] - m.m[2][1] * m.m[1][2]) -
+			m.m[1][0] * (m.m[2][2] * m.m[0][1] - m.m[2][1] * m.m[0][2]) +
+			m.m[2][0] * (m.m[1][2] * m.m[0][1] - m.m[1][1] * m.m[0][2]);
+
+		return (det);
+	}
+
+	template <typename T>
+	constexpr void MtxInvert3x3(const BasicMtx3x3<T>& m, BasicMtx3x3<T>& i)
+	{
+		T scale = T(1.0) / Determinant3x3(m);
+
+		i.m[0][0] = scale * (m.m[2][2] * m.m[1][1] - m.m[2][1] * m.m[1][2]);
+		i.m[0][1] = -scale * (m.m[2][2] * m.m[0][1] - m.m[2][1] * m.m[0][2]);
+		i.m[0][2] = scale * (m.m[1][2] * m.m[0][1] - m.m[1][1] * m.m[0][2]);
+
+		i.m[1][0] = -scale * (m.m[2][2] * m.m[1][0] - m.m[2][0] * m.m[1][2]);
+		i.m[1][1] = scale * (m.m[2][2] * m.m[0][0] - m.m[2][0] * m.m[0][2]);
+		i.m[1][2] = -scale * (m.m[1][2] * m.m[0][0] - m.m[1][0] * m.m[0][2]);
+
+		i.m[2][0] = scale * (m.m[2][1] * m.m[1][0] - m.m[2][0] * m.m[1][1]);
+		i.m[2][1] = -scale * (m.m[2][1] * m.m[0][0] - m.m[2][0] * m.m[0][1]);
+		i.m[2][2] = scale * (m.m[1][1] * m.m[0][0] - m.m[1][0] * m.m[0][1]);
+	}
+
+	template <typename T>
+	constexpr void MtxMultiply3x3(const BasicMtx3x3<T>& a, const BasicMtx3x3<T>& b, BasicMtx3x3<T>& r)
+	{
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+	}
+
+	template <typename T>
+	constexpr void MtxTranspose3x3(BasicMtx3x3<T>& m)
+	{
+		T v = m.m[0][1];
+		m.m[0][1] = m.m[1][0];
+		m.m[1][0] = v;
+
+		v = m.m[0][2];
+		m.m[0][2] = m.m[2][0];
+		m.m[2][0] = v;
+
+		v = m.m[1][2];
+		m.m[1][2] = m.m[2][1];
+		m.m[2][1] = v;
+	}
+
+	// returns the precomputed working space, the table is built at compile time
+	const RgbModel& GetRGBModel(RgbEnum Model = RgbEnum::sRGB);
+
+	// cone response matrix and its inverse per AdaptationEnum
+	constexpr Mtx3x3 Adaptations[3][2] = {
+			{
+				{{{0.8951, -0.7502, 0.0389}, {0.2664, 1.7135, -0.0685}, {-0.1614, 0.0367, 1.0296}}},
+				{{{0.9869929, 0.4323053, -0.0085287}, {-0.1470543, 0.5183603, 0.0400428}, {0.1599627, 0.0492912, 0.9684867}}}
+			},
+			{
+				{{{0.40024, -0.2263, 0}, {0.7076, 1.16532, 0}, {-0.08081, 0.0457, 0.91822}}},
+				{{{1.8599364, 0.3611914, 0}, {-1.1293816, 0.6388125, 0}, {0.2198974, -0.0000064, 1.0890636}}}
+			},
+			{
+				{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}},
+				{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}},
+			}
+		};
+
+	void GetAdaptation(AdaptationEnum Method, Mtx3x3& MtxAdaptMa, Mtx3x3& MtxAdaptMaI);
+
+	template <typename T>
+	T Compand(T linear, const double gamma);
+	template <typename T>
+	T InvCompand(T companded, const double gamma);
+
+	template <typename T>
+	void RGB2XYZ(const T& r, const T& g, const T& b,
+		const double gamma, const RgbModel& model,
+		T& x, T& y, T& z, const XYZ& RefWhite,
+		const AdaptationEnum Method = AdaptationEnum::amBradford);
+
+	template <typename T>
+	void XYZ2RGB(const T& x, const T& y, const T& z,
+		const XYZ& RefWhite,
+		T& r, T& g, T& b,
+		const double gamma, const RgbModel& model,
+		const AdaptationEnum Method = AdaptationEnum::amBradford);
+
+	template <typename T>
+	void XYZ2Lab(const T& x, const T& y, const T& z,
+		const XYZ& RefWhite,
+		T& l, T& a, T& b);
+
+	template <typename T>
+	void Lab2XYZ(const T& l, const T& a, const T& b,
+		const XYZ& RefWhite,
+		T& x, T& y, T& z);
+
+	// Lab kernels without pow(): a bit trick + Halley cube root and plain cubing.
+	// They agree with XYZ2Lab / Lab2XYZ to ~1e-12 over the whole kE / kK range
+	// (to float rounding for T = float).
+	double FastCbrt(double x);
+	float FastCbrt(float x);
+
+	template <typename T>
+	void XYZ2LabFast(const T& x, const T& y, const T& z,
+		const XYZ& RefWhite,
+		T& l, T& a, T& b);
+
+	template <typename T>
+	void Lab2XYZFast(const T& l, const T& a, const T& b,
+		const XYZ& RefWhite,
+		T& x, T& y, T& z);
+
+	// CIE76 color difference: the Euclidean distance of two Lab colors
+	template <typename T>
+	T DeltaE76(const T l1, const T a1, const T b1,
+		const T l2, const T a2, const T b2);
+
+	// CIE94 with the graphic arts weights (kL = 1, K1 = 0.045, K2 = 0.015),
+	// (l1, a1, b1) is the reference color
+	template <typename T>
+	T DeltaE94(const T l1, const T a1, const T b1,
+		const T l2, const T a2, const T b2);
+
+	// CIEDE2000 color difference of two Lab colors
+	template <typename T>
+	T DeltaE2000(const T l1, const T a1, const T b1,
+		const T l2, const T a2, const T b2);
+};
+
+#endif
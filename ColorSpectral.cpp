@@ -0,0 +1,353 @@
+#include "ColorSpectral.h"
+#include "ColorPool.h"
+#include "ColorSimd.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace COLORNS
+{
+	// spectra per kernel call, the XYZ scratch stays in L1
+	constexpr size_t kSpectralChunk = 256;
+	// samples of the 10 nm tables, kSpectralFirst to kSpectralLast
+	constexpr size_t kSpectral10nm = 41;
+	// A: Planck's law at 2848 K with c2 = 1.435e-2 m K (2856 K with the current c2)
+	constexpr double kSpectralTemperatureA = 2848.0;
+	constexpr double kSpectralC2 = 1.435e7;		// nm K
+
+	// CIE 1931 2 degree observer, 5 nm
+	const double kSpectralCie1931[kSpectralSamples][3] = {
+		{ 0.001368, 0.000039, 0.00645 }, { 0.002236, 0.000064, 0.01055 }, { 0.004243, 0.00012, 0.02005 },
+		{ 0.00765, 0.000217, 0.03621 }, { 0.01431, 0.000396, 0.06785 }, { 0.02319, 0.00064, 0.1102 },
+		{ 0.04351, 0.00121, 0.2074 }, { 0.07763, 0.00218, 0.3713 }, { 0.13438, 0.004, 0.6456 },
+		{ 0.21477, 0.0073, 1.03905 }, { 0.2839, 0.0116, 1.3856 }, { 0.3285, 0.01684, 1.62296 },
+		{ 0.34828, 0.023, 1.74706 }, { 0.34806, 0.0298, 1.7826 }, { 0.3362, 0.038, 1.77211 },
+		{ 0.3187, 0.048, 1.7441 }, { 0.2908, 0.06, 1.6692 }, { 0.2511, 0.0739, 1.5281 },
+		{ 0.19536, 0.09098, 1.28764 }, { 0.1421, 0.1126, 1.0419 }, { 0.09564, 0.13902, 0.81295 },
+		{ 0.05795, 0.1693, 0.6162 }, { 0.03201, 0.20802, 0.46518 }, { 0.0147, 0.2586, 0.3533 },
+		{ 0.0049, 0.323, 0.272 }, { 0.0024, 0.4073, 0.2123 }, { 0.0093, 0.503, 0.1582 },
+		{ 0.0291, 0.6082, 0.1117 }, { 0.06327, 0.71, 0.07825 }, { 0.1096, 0.7932, 0.05725 },
+		{ 0.1655, 0.862, 0.04216 }, { 0.22575, 0.91485, 0.02984 }, { 0.2904, 0.954, 0.0203 },
+		{ 0.3597, 0.9803, 0.0134 }, { 0.43345, 0.99495, 0.00875 }, { 0.51205, 1.0, 0.00575 },
+		{ 0.5945, 0.995, 0.0039 }, { 0.6784, 0.9786, 0.00275 }, { 0.7621, 0.952, 0.0021 },
+		{ 0.8425, 0.9154, 0.0018 }, { 0.9163, 0.87, 0.00165 }, { 0.9786, 0.8163, 0.0014 },
+		{ 1.0263, 0.757, 0.0011 }, { 1.0567, 0.6949, 0.001 }, { 1.0622, 0.631, 0.0008 },
+		{ 1.0456, 0.5668, 0.0006 }, { 1.0026, 0.503, 0.00034 }, { 0.9384, 0.4412, 0.00024 },
+		{ 0.85445, 0.381, 0.00019 }, { 0.7514, 0.321, 0.0001 }, { 0.6424, 0.265, 0.00005 },
+		{ 0.5419, 0.217, 0.00003 }, { 0.4479, 0.175, 0.00002 }, { 0.3608, 0.1382, 0.00001 },
+		{ 0.2835, 0.107, 0.0 }, { 0.2187, 0.0816, 0.0 }, { 0.1649, 0.061, 0.0 },
+		{ 0.1212, 0.04458, 0.0 }, { 0.0874, 0.032, 0.0 }, { 0.0636, 0.0232, 0.0 },
+		{ 0.04677, 0.017, 0.0 }, { 0.0329, 0.01192, 0.0 }, { 0.0227, 0.00821, 0.0 },
+		{ 0.01584, 0.005723, 0.0 }, { 0.011359, 0.004102, 0.0 }, { 0.008111, 0.002929, 0.0 },
+		{ 0.00579, 0.002091, 0.0 }, { 0.004109, 0.001484, 0.0 }, { 0.002899, 0.001047, 0.0 },
+		{ 0.002049, 0.00074, 0.0 }, { 0.00144, 0.00052, 0.0 }, { 0.001, 0.000361, 0.0 },
+		{ 0.00069, 0.000249, 0.0 }, { 0.000476, 0.000172, 0.0 }, { 0.000332, 0.00012, 0.0 },
+		{ 0.000235, 0.000085, 0.0 }, { 0.000166, 0.00006, 0.0 }, { 0.000117, 0.000042, 0.0 },
+		{ 0.000083, 0.00003, 0.0 }, { 0.000059, 0.000021, 0.0 }, { 0.000042, 0.000015, 0.0 }
+	};
+
+	// CIE 1964 10 degree observer, 10 nm
+	const double kSpectralCie1964[kSpectral10nm][3] = {
+		{ 0.00016, 0.000017, 0.000705 }, { 0.002362, 0.000253, 0.010482 }, { 0.01911, 0.002004, 0.086011 },
+		{ 0.084736, 0.008756, 0.389366 }, { 0.204492, 0.021391, 0.972542 }, { 0.314679, 0.038676, 1.55348 },
+		{ 0.383734, 0.062077, 1.96728 }, { 0.370702, 0.089456, 1.9948 }, { 0.302273, 0.128201, 1.74537 },
+		{ 0.195618, 0.18519, 1.31756 }, { 0.080507, 0.253589, 0.772125 }, { 0.016172, 0.339133, 0.415254 },
+		{ 0.003816, 0.460777, 0.218502 }, { 0.037465, 0.606741, 0.112044 }, { 0.117749, 0.761757, 0.060709 },
+		{ 0.236491, 0.875211, 0.030451 }, { 0.376772, 0.961988, 0.013676 }, { 0.529826, 0.991761, 0.003988 },
+		{ 0.705224, 0.99734, 0.0 }, { 0.878655, 0.955552, 0.0 }, { 1.01416, 0.868934, 0.0 },
+		{ 1.11852, 0.777405, 0.0 }, { 1.12399, 0.658341, 0.0 }, { 1.03048, 0.527963, 0.0 },
+		{ 0.856297, 0.398057, 0.0 }, { 0.647467, 0.283493, 0.0 }, { 0.431567, 0.179828, 0.0 },
+		{ 0.268329, 0.107633, 0.0 }, { 0.152568, 0.060281, 0.0 }, { 0.081261, 0.0318, 0.0 },
+		{ 0.040851, 0.015905, 0.0 }, { 0.019941, 0.007749, 0.0 }, { 0.009577, 0.003718, 0.0 },
+		{ 0.004553, 0.001768, 0.0 }, { 0.002175, 0.000846, 0.0 }, { 0.001045, 0.000407, 0.0 },
+		{ 0.000508, 0.000199, 0.0 }, { 0.000251, 0.000098, 0.0 }, { 0.000126, 0.00005, 0.0 },
+		{ 0.000065, 0.000025, 0.0 }, { 0.000033, 0.000013, 0.0 }
+	};
+
+	// CIE daylight basis S0, S1, S2, 10 nm
+	const double kSpectralDaylight[kSpectral10nm][3] = {
+		{ 63.4, 38.5, 3.0 }, { 65.8, 35.0, 1.2 }, { 94.8, 43.4, -1.1 }, { 104.8, 46.3, -0.5 }, { 105.9, 43.9, -0.7 },
+		{ 96.8, 37.1, -1.2 }, { 113.9, 36.7, -2.6 }, { 125.6, 35.9, -2.9 }, { 125.5, 32.6, -2.8 }, { 121.3, 27.9, -2.6 },
+		{ 121.3, 24.3, -2.6 }, { 113.5, 20.1, -1.8 }, { 113.1, 16.2, -1.5 }, { 110.8, 13.2, -1.3 }, { 106.5, 8.6, -1.2 },
+		{ 108.8, 6.1, -1.0 }, { 105.3, 4.2, -0.5 }, { 104.4, 1.9, -0.3 }, { 100.0, 0.0, 0.0 }, { 96.0, -1.6, 0.2 },
+		{ 95.1, -3.5, 0.5 }, { 89.1, -3.5, 2.1 }, { 90.5, -5.8, 3.2 }, { 90.3, -7.2, 4.1 }, { 88.4, -8.6, 4.7 },
+		{ 84.0, -9.5, 5.1 }, { 85.1, -10.9, 6.7 }, { 81.9, -10.7, 7.3 }, { 82.6, -12.0, 8.6 }, { 84.9, -14.0, 9.8 },
+		{ 81.3, -13.6, 10.2 }, { 71.9, -12.0, 8.3 }, { 74.3, -13.3, 9.6 }, { 76.4, -12.9, 8.5 }, { 63.3, -10.6, 7.0 },
+		{ 71.7, -11.6, 7.6 }, { 77.0, -12.2, 8.0 }, { 65.2, -10.2, 6.7 }, { 47.7, -7.8, 5.2 }, { 68.6, -11.2, 7.4 },
+		{ 65.0, -10.4, 6.8 }
+	};
+
+	// illuminant C, 10 nm
+	const double kSpectralC[kSpectral10nm] = {
+		33.0, 47.4, 63.3, 80.6, 98.1, 112.4, 121.5, 124.0, 123.1, 123.8,
+		123.9, 120.7, 112.1, 102.3, 96.9, 98.0, 102.1, 105.2, 105.3, 102.3,
+		97.8, 93.2, 89.7, 88.4, 88.1, 88.0, 87.8, 88.2, 87.9, 86.3,
+		84.0, 80.2, 76.3, 72.4, 68.3, 64.4, 61.5, 59.2, 58.1, 58.2,
+		59.1
+	};
+
+	namespace
+	{
+		// a 10 nm table to 5 nm, linear
+		void SpectralInterpolate(const double* table, size_t stride, double* out)
+		{
+			for (size_t i = 0; i < kSpectralSamples; ++i)
+			{
+				const size_t j = i / 2;
+				out[i] = (i % 2) ? 0.5 * (table[j * stride] + table[(j + 1) * stride]) : table[j * stride];
+			}
+		}
+
+		// CIE 15 daylight of correlated color temperature T: chromaticity from T, then
+		// S0 + M1 S1 + M2 S2 with M1 and M2 rounded to three decimals as in the CIE tables
+		void SpectralDaylight(double T, double spd[kSpectralSamples])
+		{
+			const double x = (T <= 7000.0)
+				? -4.6070e9 / (T * T * T) + 2.9678e6 / (T * T) + 0.09911e3 / T + 0.244063
+				: -2.0064e9 / (T * T * T) + 1.9018e6 / (T * T) + 0.24748e3 / T + 0.237040;
+			const double y = -3.000 * x * x + 2.870 * x - 0.275;
+			const double m = 0.0241 + 0.2562 * x - 0.7341 * y;
+			const double m1 = std::round((-1.3515 - 1.7703 * x + 5.9114 * y) / m * 1000.0) / 1000.0;
+			const double m2 = std::round((0.0300 - 31.4424 * x + 30.0717 * y) / m * 1000.0) / 1000.0;
+			double s[3][kSpectralSamples];
+			for (size_t k = 0; k < 3; ++k)
+				SpectralInterpolate(&kSpectralDaylight[0][k], 3, s[k]);
+			for (size_t i = 0; i < kSpectralSamples; ++i)
+				spd[i] = s[0][i] + m1 * s[1][i] + m2 * s[2][i];
+		}
+
+		double SpectralPlanck(double T, double nm)
+		{
+			return 1.0 / (nm * nm * nm * nm * nm * (std::exp(kSpectralC2 / (nm * T)) - 1.0));
+		}
+	}
+
+	void GetObserverFunctions(ObserverEnum observer, double xyz[kSpectralSamples][3])
+	{
+		if (observer == ObserverEnum::Cie1964)
+		{
+			double c[kSpectralSamples];
+			for (size_t k = 0; k < 3; ++k)
+			{
+				SpectralInterpolate(&kSpectralCie1964[0][k], 3, c);
+				for (size_t i = 0; i < kSpectralSamples; ++i)
+					xyz[i][k] = c[i];
+			}
+			return;
+		}
+		for (size_t i = 0; i < kSpectralSamples; ++i)
+			for (size_t k = 0; k < 3; ++k)
+				xyz[i][k] = kSpectralCie1931[i][k];
+	}
+
+	bool GetIlluminantSpectrum(IlluminantEnum illuminant, double spd[kSpectralSamples])
+	{
+		switch (illuminant)
+		{
+		case IlluminantEnum::A:
+			for (size_t i = 0; i < kSpectralSamples; ++i)
+				spd[i] = 100.0 * SpectralPlanck(kSpectralTemperatureA, kSpectralFirst + kSpectralInterval * double(i))
+					/ SpectralPlanck(kSpectralTemperatureA, 560.0);
+			return true;
+		case IlluminantEnum::C:
+			SpectralInterpolate(kSpectralC, 1, spd);
+			return true;
+		// the nominal temperatures times 1.4388 / 1.4380, the change of c2
+		case IlluminantEnum::D50:
+			SpectralDaylight(5003.0, spd);
+			return true;
+		case IlluminantEnum::D55:
+			SpectralDaylight(5503.0, spd);
+			return true;
+		case IlluminantEnum::D65:
+			SpectralDaylight(6504.0, spd);
+			return true;
+		case IlluminantEnum::D75:
+			SpectralDaylight(7504.0, spd);
+			return true;
+		case IlluminantEnum::E:
+			std::fill(spd, spd + kSpectralSamples, 100.0);
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	SpectralTable::SpectralTable(IlluminantEnum illuminant, ObserverEnum observer, int first, int interval,
+		size_t bands) :
+		m_observer(observer),
+		m_first(first),
+		m_interval(std::max(interval, 1)),
+		m_bands(std::max(bands, size_t(1))),
+		m_lo(0),
+		m_hi(0)
+	{
+		double spd[kSpectralSamples];
+		if (!GetIlluminantSpectrum(illuminant, spd))
+			GetIlluminantSpectrum(IlluminantEnum::E, spd);
+		Build(spd);
+	}
+
+	SpectralTable::SpectralTable(const double spd[kSpectralSamples], ObserverEnum observer, int first,
+		int interval, size_t bands) :
+		m_observer(observer),
+		m_first(first),
+		m_interval(std::max(interval, 1)),
+		m_bands(std::max(bands, size_t(1))),
+		m_lo(0),
+		m_hi(0)
+	{
+		Build(spd);
+	}
+
+	// Each 5 nm sample of spd x cmf goes to the two bands around it, in the proportions
+	// of the linear interpolation between them (all of it to the end band past either
+	// end), so the bands of a spectrum sum to the 5 nm sum of its interpolation.
+	void SpectralTable::Build(const double spd[kSpectralSamples])
+	{
+		double cmf[kSpectralSamples][3];
+		GetObserverFunctions(m_observer, cmf);
+		double norm = 0.0;
+		for (size_t i = 0; i < kSpectralSamples; ++i)
+			norm += spd[i] * cmf[i][1];
+		norm = (norm > 0.0) ? 1.0 / norm : 0.0;
+
+		std::vector<double> w(m_bands * 3, 0.0);
+		for (size_t i = 0; i < kSpectralSamples; ++i)
+		{
+			const double t = (kSpectralFirst + kSpectralInterval * double(i) - m_first) / m_interval;
+			size_t band = 0;
+			double f = 0.0;
+			if (t >= static_cast<double>(m_bands - 1))
+				band = m_bands - 1;
+			else if (t > 0.0)
+			{
+				band = static_cast<size_t>(t);
+				f = t - static_cast<double>(band);
+			}
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const double v = spd[i] * cmf[i][k] * norm;
+				w[k * m_bands + band] += (1.0 - f) * v;
+				if (f > 0.0)
+					w[k * m_bands + band + 1] += f * v;
+			}
+		}
+
+		m_lo = m_bands;
+		m_hi = 0;
+		for (size_t b = 0; b < m_bands; ++b)
+			if (w[b] != 0.0 || w[m_bands + b] != 0.0 || w[2 * m_bands + b] != 0.0)
+			{
+				m_lo = std::min(m_lo, b);
+				m_hi = b + 1;
+			}
+		if (m_hi < m_lo)
+			m_lo = m_hi = 0;
+		const size_t count = m_hi - m_lo;
+		m_weights.assign(count * 3, 0.0);
+		m_kernelWeights.assign(count * 3, 0.0f);
+		double white[3] = { 0.0, 0.0, 0.0 };
+		for (size_t k = 0; k < 3; ++k)
+			for (size_t b = 0; b < count; ++b)
+			{
+				const double v = w[k * m_bands + m_lo + b];
+				m_weights[k * count + b] = v;
+				m_kernelWeights[k * count + b] = static_cast<float>(v);
+				white[k] += v;
+			}
+		m_white.X = white[0];
+		m_white.Y = white[1];
+		m_white.Z = white[2];
+	}
+
+	ObserverEnum SpectralTable::GetObserver() const noexcept
+	{
+		return m_observer;
+	}
+
+	int SpectralTable::GetFirst() const noexcept
+	{
+		return m_first;
+	}
+
+	int SpectralTable::GetInterval() const noexcept
+	{
+		return m_interval;
+	}
+
+	size_t SpectralTable::GetBands() const noexcept
+	{
+		return m_bands;
+	}
+
+	const XYZ& SpectralTable::GetWhite() const noexcept
+	{
+		return m_white;
+	}
+
+	const float* SpectralTable::GetWeights(size_t& lo, size_t& count) const noexcept
+	{
+		lo = m_lo;
+		count = m_hi - m_lo;
+		return m_kernelWeights.data();
+	}
+
+	XyzColor SpectralTable::Integrate(const double* spectrum) const
+	{
+		const size_t count = m_hi - m_lo;
+		const double* s = spectrum + m_lo;
+		double xyz[3] = { 0.0, 0.0, 0.0 };
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const double* w = m_weights.data() + k * count;
+			for (size_t b = 0; b < count; ++b)
+				xyz[k] += w[b] * s[b];
+		}
+		return XyzColor(xyz[0], xyz[1], xyz[2]);
+	}
+
+	// spectra [first, last) of n in kSpectralChunk passes; planar output goes
+	// straight to the planes, interleaved through the scratch
+	void SpectralTable::IntegrateRange(const float* in, float* out, size_t n, size_t first, size_t last,
+		LayoutEnum layout) const
+	{
+		const SimdKernels& kernels = GetSimdKernels();
+		const size_t count = m_hi - m_lo;
+		const float* w = m_kernelWeights.data();
+		float c[3][kSpectralChunk];
+		for (size_t begin = first; begin < last; begin += kSpectralChunk)
+		{
+			const size_t chunk = std::min(kSpectralChunk, last - begin);
+			if (layout == LayoutEnum::Planar)
+			{
+				kernels.SpectralPlanar(w, count, in + m_lo * n + begin, n,
+					out + begin, out + n + begin, out + 2 * n + begin, chunk);
+				continue;
+			}
+			kernels.SpectralInterleaved(w, count, in + begin * m_bands + m_lo, m_bands,
+				c[0], c[1], c[2], chunk);
+			float* o = out + begin * 3;
+			for (size_t i = 0; i < chunk; ++i)
+			{
+				o[i * 3] = c[0][i];
+				o[i * 3 + 1] = c[1][i];
+				o[i * 3 + 2] = c[2][i];
+			}
+		}
+	}
+
+	void SpectralTable::Integrate(const float* in, float* out, size_t n, LayoutEnum layout) const
+	{
+		IntegrateRange(in, out, n, 0, n, layout);
+	}
+
+	void SpectralTable::Integrate(ThreadPool& pool, const float* in, float* out, size_t n,
+		LayoutEnum layout, size_t tile) const
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			IntegrateRange(in, out, n, first, last, layout);
+		});
+	}
+};
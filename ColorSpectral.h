@@ -0,0 +1,92 @@
+#ifndef _COLORSPECTRAL_H_
+#define _COLORSPECTRAL_H_
+
+#include "Color.h"
+#include "ColorBuffer.h"
+#include "ColorSpace.h"
+
+#include <vector>
+
+namespace COLORNS
+{
+	enum class ObserverEnum
+	{
+		Cie1931 = 0,	// 2 degree
+		Cie1964 = 1		// 10 degree
+	};
+
+	// the built-in spectra: kSpectralFirst to kSpectralLast nm every kSpectralInterval
+	constexpr int kSpectralFirst = 380;
+	constexpr int kSpectralLast = 780;
+	constexpr int kSpectralInterval = 5;
+	constexpr size_t kSpectralSamples = 81;
+
+	// x, y, z color matching functions of the observer at the kSpectralSamples wavelengths.
+	// CIE 1931 is the 5 nm table, CIE 1964 its 10 nm table linearly interpolated.
+	void GetObserverFunctions(ObserverEnum observer, double xyz[kSpectralSamples][3]);
+
+	// relative SPD of the illuminant at the kSpectralSamples wavelengths, 100 at 560 nm:
+	// A from Planck's law, the D illuminants from the CIE daylight basis (10 nm, linearly
+	// interpolated), C from its 10 nm table, E constant. B and the F illuminants have no
+	// built-in spectrum: false, spd is left alone.
+	bool GetIlluminantSpectrum(IlluminantEnum illuminant, double spd[kSpectralSamples]);
+
+	class ThreadPool;
+
+	// Spectra to XYZ: weights per band of one sampling (bands samples from first nm every
+	// interval nm) for one observer and illuminant, computed once, so a spectrum costs
+	// three dot products. The weights integrate the spectrum, linearly interpolated
+	// between the bands and held constant past the end bands, over the 5 nm tables and
+	// are normalized to Y = 1 for the perfect reflector (all samples 1), GetWhite().
+	// Spectra are reflectance or transmittance factors; emission spectra go through
+	// illuminant E, their XYZ then relative to the equal energy spectrum.
+	// Bands outside kSpectralFirst to kSpectralLast carry no weight and are skipped.
+	class SpectralTable
+	{
+		ObserverEnum m_observer;
+		int m_first;
+		int m_interval;
+		size_t m_bands;
+		size_t m_lo;					// the bands with a weight: m_lo to m_hi
+		size_t m_hi;
+		XYZ m_white;
+		// x, y and z weights of the bands m_lo to m_hi, one channel after the other
+		std::vector<double> m_weights;
+		std::vector<float> m_kernelWeights;
+
+		void Build(const double spd[kSpectralSamples]);
+		void IntegrateRange(const float* in, float* out, size_t n, size_t first, size_t last,
+			LayoutEnum layout) const;
+	public:
+		// B and the F illuminants have no built-in spectrum, E stands in for them:
+		// pass theirs to the constructor below
+		explicit SpectralTable(IlluminantEnum illuminant = IlluminantEnum::D50,
+			ObserverEnum observer = ObserverEnum::Cie1931, int first = 400, int interval = 10,
+			size_t bands = 31);
+		// spd at the kSpectralSamples wavelengths, any scale
+		SpectralTable(const double spd[kSpectralSamples], ObserverEnum observer, int first = 400,
+			int interval = 10, size_t bands = 31);
+
+		ObserverEnum GetObserver() const noexcept;
+		int GetFirst() const noexcept;
+		int GetInterval() const noexcept;
+		size_t GetBands() const noexcept;
+		// XYZ of the perfect reflector
+		const XYZ& GetWhite() const noexcept;
+		// the weights the batch kernels use: x, y, then z of the bands lo to lo + count
+		const float* GetWeights(size_t& lo, size_t& count) const noexcept;
+
+		// one spectrum of GetBands() samples, in double
+		XyzColor Integrate(const double* spectrum) const;
+
+		// n spectra to XYZ on the SIMD kernels. Interleaved: the samples of a spectrum
+		// are contiguous, out gets XYZ triples; Planar: GetBands() planes of n samples
+		// (band sequential), out gets X, Y and Z planes. out must not overlap in.
+		void Integrate(const float* in, float* out, size_t n,
+			LayoutEnum layout = LayoutEnum::Interleaved) const;
+		void Integrate(ThreadPool& pool, const float* in, float* out, size_t n,
+			LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels) const;
+	};
+};
+
+#endif
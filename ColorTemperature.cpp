@@ -0,0 +1,145 @@
+#include "ColorTemperature.h"
+#include "ColorPool.h"
+#include "ColorSpectral.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace COLORNS
+{
+	// second radiation constant, nm K
+	constexpr double kCctC2 = 1.4388e7;
+	// mired step of the locus tangents, central differences
+	constexpr double kCctTangentStep = 0.01;
+
+	namespace
+	{
+		// a point of the Planckian locus and the unit tangent there, towards higher mired;
+		// the isotemperature line through it is normal to the tangent
+		typedef struct _CctEntry
+		{
+			double Mired;
+			double U;
+			double V;
+			double Du;
+			double Dv;
+		} CctEntry;
+
+		typedef struct _CctTable
+		{
+			CctEntry Entries[kCctEntries];
+			_CctTable()
+			{
+				const double lo = 1e6 / kCctMax, hi = 1e6 / kCctMin;
+				for (size_t i = 0; i < kCctEntries; ++i)
+				{
+					CctEntry& e = Entries[i];
+					e.Mired = lo + (hi - lo) * static_cast<double>(i) / (kCctEntries - 1);
+					GetPlanckianUV(1e6 / e.Mired, e.U, e.V);
+					double u0, v0, u1, v1;
+					GetPlanckianUV(1e6 / (e.Mired - kCctTangentStep), u0, v0);
+					GetPlanckianUV(1e6 / (e.Mired + kCctTangentStep), u1, v1);
+					const double length = std::sqrt((u1 - u0) * (u1 - u0) + (v1 - v0) * (v1 - v0));
+					e.Du = (u1 - u0) / length;
+					e.Dv = (v1 - v0) / length;
+				}
+			}
+		} CctTable;
+
+		const CctTable& GetCctTable()
+		{
+			static const CctTable table;
+			return table;
+		}
+	}
+
+	void GetPlanckianUV(double T, double& u, double& v)
+	{
+		double cmf[kSpectralSamples][3];
+		GetObserverFunctions(ObserverEnum::Cie1931, cmf);
+		double X = 0.0, Y = 0.0, Z = 0.0;
+		for (size_t i = 0; i < kSpectralSamples; ++i)
+		{
+			const double nm = kSpectralFirst + kSpectralInterval * static_cast<double>(i);
+			// expm1 keeps the digits at high T, where the exponent goes to 0
+			const double m = 1.0 / (nm * nm * nm * nm * nm * std::expm1(kCctC2 / (nm * T)));
+			X += m * cmf[i][0];
+			Y += m * cmf[i][1];
+			Z += m * cmf[i][2];
+		}
+		const double den = X + 15.0 * Y + 3.0 * Z;
+		u = 4.0 * X / den;
+		v = 6.0 * Y / den;
+	}
+
+	// The distance of (u, v) along the tangent from entry i falls with i (for colors
+	// within the |Duv| the CCT is defined for), so the search keeps the last entry at
+	// or before the color and the one after brackets it.
+	void XYZ2CCT(double X, double Y, double Z, double& cct, double& duv)
+	{
+		const double den = X + 15.0 * Y + 3.0 * Z;
+		if (!(den > 0.0))
+		{
+			cct = 0.0;
+			duv = 0.0;
+			return;
+		}
+		const double u = 4.0 * X / den;
+		const double v = 6.0 * Y / den;
+		const CctEntry* e = GetCctTable().Entries;
+		size_t base = 0;
+		for (size_t half = kCctEntries / 2; half > 0; half /= 2)
+		{
+			const CctEntry& probe = e[base + half];
+			base = ((u - probe.U) * probe.Du + (v - probe.V) * probe.Dv >= 0.0) ? base + half : base;
+		}
+		base = std::min(base, kCctEntries - 2);
+		const CctEntry& e0 = e[base];
+		const CctEntry& e1 = e[base + 1];
+		const double d0 = (u - e0.U) * e0.Du + (v - e0.V) * e0.Dv;
+		const double d1 = (u - e1.U) * e1.Du + (v - e1.V) * e1.Dv;
+		const double f = (d0 > d1) ? std::min(std::max(d0 / (d0 - d1), 0.0), 1.0) : 0.0;
+		cct = 1e6 / (e0.Mired + f * (e1.Mired - e0.Mired));
+
+		// the locus point at f; its normal (the tangent turned left) points up
+		const double du = u - (e0.U + f * (e1.U - e0.U));
+		const double dv = v - (e0.V + f * (e1.V - e0.V));
+		const double nu = -(e0.Dv + f * (e1.Dv - e0.Dv));
+		const double nv = e0.Du + f * (e1.Du - e0.Du);
+		const double distance = std::sqrt(du * du + dv * dv);
+		duv = (du * nu + dv * nv < 0.0) ? -distance : distance;
+	}
+
+	namespace
+	{
+		void CCTRange(const float* xyz, float* cct, float* duv, size_t n, size_t first, size_t last,
+			LayoutEnum layout)
+		{
+			const size_t step = (layout == LayoutEnum::Planar) ? 1 : 3;
+			const size_t plane = (layout == LayoutEnum::Planar) ? n : 1;
+			for (size_t i = first; i < last; ++i)
+			{
+				const float* p = xyz + i * step;
+				double t, d;
+				XYZ2CCT(p[0], p[plane], p[2 * plane], t, d);
+				cct[i] = static_cast<float>(t);
+				if (duv)
+					duv[i] = static_cast<float>(d);
+			}
+		}
+	}
+
+	void CCTBuffer(const float* xyz, float* cct, float* duv, size_t n, LayoutEnum layout)
+	{
+		CCTRange(xyz, cct, duv, n, 0, n, layout);
+	}
+
+	void CCTBuffer(ThreadPool& pool, const float* xyz, float* cct, float* duv, size_t n,
+		LayoutEnum layout, size_t tile)
+	{
+		pool.ParallelFor(n, tile, [&](size_t first, size_t last)
+		{
+			CCTRange(xyz, cct, duv, n, first, last, layout);
+		});
+	}
+};
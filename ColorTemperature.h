@@ -0,0 +1,36 @@
+#ifndef _COLORTEMPERATURE_H_
+#define _COLORTEMPERATURE_H_
+
+#include "ColorBuffer.h"
+
+namespace COLORNS
+{
+	// the range of the isotemperature table, colors past its ends get the end temperature
+	constexpr double kCctMin = 1000.0;		// K
+	constexpr double kCctMax = 100000.0;
+	// isotemperature lines of the table, evenly spaced in mired (1e6 / T)
+	constexpr size_t kCctEntries = 1024;
+
+	// (u, v) of CIE 1960 of the Planckian radiator at T kelvin: Planck's law
+	// (c2 = 1.4388e-2 m K) over the CIE 1931 5 nm table
+	void GetPlanckianUV(double T, double& u, double& v);
+
+	// Correlated color temperature (K) and Duv of one color, Robertson's method on a
+	// dense table: the isotemperature lines, normal to the Planckian locus in (u, v),
+	// are found by a branch-free binary search, the temperature is interpolated in
+	// mired between the two around the color. Duv is the distance to the locus,
+	// positive above it (towards green). Black gets 0 and 0.
+	void XYZ2CCT(double X, double Y, double Z, double& cct, double& duv);
+
+	// n colors: xyz holds XYZ triples (Interleaved) or the X, Y and Z planes (Planar),
+	// cct and duv get n values each; duv may be nullptr
+	void CCTBuffer(const float* xyz, float* cct, float* duv, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved);
+
+	class ThreadPool;
+
+	void CCTBuffer(ThreadPool& pool, const float* xyz, float* cct, float* duv, size_t n,
+		LayoutEnum layout = LayoutEnum::Interleaved, size_t tile = kTilePixels);
+};
+
+#endif